@@ -0,0 +1,90 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 軸平行境界ボックス(AABB)
+ * BVHのノードやプリミティブの範囲を表す
+ * 初期状態は空の範囲(min > max)で、expandにより点やボックスを含むように広げる
+ */
+
+#ifndef PRACTICEPATHTRACING_AABB_H
+#define PRACTICEPATHTRACING_AABB_H
+
+#include <algorithm>
+#include <limits>
+#include "futaba/core/vec3.h"
+
+class AABB {
+public:
+    // 1 + 2 * gamma(3) (PBRT 3.9.2節)
+    static constexpr float SLAB_MARGIN = 1.0f + 2.0f * 3.0f * 0.5f * std::numeric_limits<float>::epsilon() /
+                                                 (1.0f - 3.0f * 0.5f * std::numeric_limits<float>::epsilon());
+
+    Vec3 min;
+    Vec3 max;
+
+    AABB() : min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max()) {};
+
+    AABB(const Vec3 &_min, const Vec3 &_max) : min(_min), max(_max) {};
+
+    bool is_empty() const {
+        return min.x() > max.x() || min.y() > max.y() || min.z() > max.z();
+    }
+
+    void expand(const Vec3 &p) {
+        for (int i = 0; i < 3; i++) {
+            min.elements[i] = std::min(min.elements[i], p.elements[i]);
+            max.elements[i] = std::max(max.elements[i], p.elements[i]);
+        }
+    }
+
+    void expand(const AABB &box) {
+        for (int i = 0; i < 3; i++) {
+            min.elements[i] = std::min(min.elements[i], box.min.elements[i]);
+            max.elements[i] = std::max(max.elements[i], box.max.elements[i]);
+        }
+    }
+
+    Vec3 centroid() const {
+        return 0.5f * (min + max);
+    }
+
+    float surface_area() const {
+        if (is_empty())
+            return 0.0f;
+        Vec3 d = max - min;
+        return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    }
+
+    // 最も長い辺の軸(0: x, 1: y, 2: z)
+    int longest_axis() const {
+        Vec3 d = max - min;
+        if (d.x() >= d.y() && d.x() >= d.z())
+            return 0;
+        return d.y() >= d.z() ? 1 : 2;
+    }
+
+    /*
+     * スラブ法による判定
+     * inv_directionはレイの方向ベクトルの各成分の逆数で、ボックス毎の除算を避けるため呼び出し側で一度だけ求める
+     * 衝突した場合はt_enterにボックスに入る距離を設定する
+     */
+    bool is_hittable(const Vec3 &origin, const Vec3 &inv_direction, float t_min, float t_max, float &t_enter) const {
+        for (int i = 0; i < 3; i++) {
+            float t0 = (min.elements[i] - origin.elements[i]) * inv_direction.elements[i];
+            float t1 = (max.elements[i] - origin.elements[i]) * inv_direction.elements[i];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            // 厚みの無いボックスの辺上で丸め誤差により判定が漏れないよう、出る距離を僅かに広げる
+            t1 *= SLAB_MARGIN;
+            // 方向成分が0でoriginが面上にある場合の0 * infによるNaNは比較で除外される
+            t_min = t0 > t_min ? t0 : t_min;
+            t_max = t1 < t_max ? t1 : t_max;
+            if (t_min > t_max)
+                return false;
+        }
+        t_enter = t_min;
+        return true;
+    }
+};
+
+#endif //PRACTICEPATHTRACING_AABB_H
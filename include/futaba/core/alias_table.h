@@ -0,0 +1,100 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * AliasTableクラス
+ * 重みに比例する確率で離散的な値を選ぶ(Walkerのエイリアス法、構築はVoseの方法)
+ *
+ * 各要素は自身が選ばれる確率probと、選ばれなかった場合の代わりの要素aliasを持つ
+ * 1つの一様乱数で要素とprobの判定を行うため、サンプリングは要素数によらずO(1)となる
+ */
+
+#ifndef PRACTICEPATHTRACING_ALIAS_TABLE_H
+#define PRACTICEPATHTRACING_ALIAS_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    /*
+     * weightsは非負とする
+     * 全ての重みが0の場合は一様に選ぶ
+     */
+    explicit AliasTable(const std::vector<float> &weights) : prob(weights.size()), alias(weights.size()),
+                                                             pmfs(weights.size()) {
+        size_t n = weights.size();
+        if (n == 0)
+            return;
+        double sum = 0.0;
+        for (float w: weights)
+            sum += w;
+        total = static_cast<float>(sum);
+
+        // 平均が1になるように正規化し、1未満の要素の不足分を1以上の要素で埋める
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            pmfs[i] = sum > 0.0 ? static_cast<float>(weights[i] / sum) : 1.0f / static_cast<float>(n);
+            scaled[i] = sum > 0.0 ? weights[i] * static_cast<double>(n) / sum : 1.0;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            large.pop_back();
+            prob[s] = static_cast<float>(scaled[s]);
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            (scaled[l] < 1.0 ? small : large).push_back(l);
+        }
+        // 丸め誤差で残った要素は確率1とする
+        for (uint32_t i: large) {
+            prob[i] = 1.0f;
+            alias[i] = i;
+        }
+        for (uint32_t i: small) {
+            prob[i] = 1.0f;
+            alias[i] = i;
+        }
+    }
+
+    size_t size() const {
+        return prob.size();
+    }
+
+    // 重みの合計
+    float sum() const {
+        return total;
+    }
+
+    // 要素iが選ばれる確率
+    float pmf(uint32_t i) const {
+        return pmfs[i];
+    }
+
+    /*
+     * [0, 1)の一様乱数uから要素を選ぶ
+     * remappedには要素の選択に使わなかった端数を[0, 1)の一様乱数として返す
+     */
+    uint32_t sample(float u, float *remapped = nullptr) const {
+        float s = u * static_cast<float>(prob.size());
+        auto i = std::min(static_cast<uint32_t>(s), static_cast<uint32_t>(prob.size() - 1));
+        float f = std::min(s - static_cast<float>(i), 0.99999994f);
+        bool keep = f < prob[i];
+        if (remapped)
+            *remapped = keep ? f / prob[i] : std::min((f - prob[i]) / (1.0f - prob[i]), 0.99999994f);
+        return keep ? i : alias[i];
+    }
+
+private:
+    std::vector<float> prob;
+    std::vector<uint32_t> alias;
+    std::vector<float> pmfs;
+    float total = 0.0f;
+};
+
+#endif //PRACTICEPATHTRACING_ALIAS_TABLE_H
@@ -19,4 +19,6 @@ const int MAX_DEPTH = 100;
 
 const float ROULETTE = 0.9;
 
+const float PI = 3.14159265358979323846f;
+
 #endif //PRACTICEPATHTRACING_CONFIG_H
@@ -0,0 +1,213 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Framebufferクラス
+ *
+ * 1回のレンダリングで複数のAOV(Arbitrary Output Variables)を同時に書き込むための浮動小数点バッファ
+ * 従来は法線画像を得るためにNormalPixelを書き込む別のImageに対して再度レンダリングが必要だった
+ * Framebufferでは同一のHitRecordから必要なAOVを全て書き出すため、N種類の出力でもトラバーサルは1回で済む
+ *
+ * メモリ配置:
+ * 画面をtile_size x tile_sizeのタイルに分割し、タイル毎に連続した領域を割り当てる
+ * タイル内はチャンネル毎に独立した平面(プレーン)を持つプレーナ形式
+ * 例えばBeautyとDepthを有効にした場合は各タイルが[R平面][G平面][B平面][Depth平面]の順に並ぶ
+ * 無効なAOVの平面は確保されない
+ * 画面端のタイルも常にtile_size x tile_sizeの大きさで確保する
+ *
+ * バックエンド:
+ * 通常はヒープ上に確保する
+ * ファイルパスを指定した場合はMappedFileによるメモリマップドファイルを利用する
+ * レンダラはタイルを直接書き込み、物理メモリへの読み込みと書き出しはOSのページングに任せる
+ * そのため物理メモリに収まらないギガピクセル級の画像もレンダリングできる
+ * メモリマップドファイルの場合は初期化のための全体の書き込みを行わないため、未描画の画素は全て0となる
+ */
+
+#ifndef PRACTICEPATHTRACING_FRAMEBUFFER_H
+#define PRACTICEPATHTRACING_FRAMEBUFFER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "futaba/core/image.h"
+#include "futaba/core/mapped_file.h"
+#include "futaba/core/vec3.h"
+
+/*
+ * AOVの種類
+ * AOV_BEAUTY: レンダリング結果の放射輝度(RGB)
+ * AOV_NORMAL: 最前面の衝突点の法線(XYZ)
+ * AOV_DEPTH: カメラから衝突点までの距離t(1ch)
+ * AOV_ALBEDO: 衝突点の反射率(RGB)
+ * AOV_OBJECT_ID: 衝突したオブジェクトのAggregate内でのインデックス(1ch)
+ * AOV_SAMPLE_COUNT: 画素毎の累積サンプル数(1ch)
+ *  漸進的なレンダリングでBeautyとAlbedoの平均を更新するために利用するため常に有効
+ */
+enum AOVType {
+    AOV_BEAUTY = 0,
+    AOV_NORMAL,
+    AOV_DEPTH,
+    AOV_ALBEDO,
+    AOV_OBJECT_ID,
+    AOV_SAMPLE_COUNT,
+    AOV_COUNT
+};
+
+/*
+ * 有効にするAOVはビットマスクで指定する
+ * 例: aov_bit(AOV_BEAUTY) | aov_bit(AOV_DEPTH)
+ */
+inline uint32_t aov_bit(AOVType aov) {
+    return 1u << static_cast<uint32_t>(aov);
+}
+
+const uint32_t AOV_ALL = (1u << AOV_COUNT) - 1;
+
+inline int aov_channel_count(AOVType aov) {
+    return (aov == AOV_DEPTH || aov == AOV_OBJECT_ID || aov == AOV_SAMPLE_COUNT) ? 1 : 3;
+}
+
+const char *aov_name(AOVType aov);
+
+class Framebuffer {
+public:
+    int width;
+    int height;
+    uint32_t aov_mask;
+    int tile_size;
+    int tiles_x;
+    int tiles_y;
+
+    Framebuffer(int _height, int _width, uint32_t _aov_mask, int _tile_size = 64);
+
+    /*
+     * メモリマップドファイルをバックエンドとするFramebuffer
+     * backing_fileは作成(既存の場合は切り詰め)される
+     * backing_fileが空の場合は無名の領域を割り当て、書き込まれたタイルのみが物理メモリを消費する
+     */
+    Framebuffer(int _height, int _width, uint32_t _aov_mask, const std::string &backing_file, int _tile_size = 64);
+
+    Framebuffer(const Framebuffer &) = delete;
+
+    Framebuffer &operator=(const Framebuffer &) = delete;
+
+    Framebuffer(Framebuffer &&) = default;
+
+    Framebuffer &operator=(Framebuffer &&) = default;
+
+    bool has_aov(AOVType aov) const {
+        return (aov_mask & aov_bit(aov)) != 0;
+    }
+
+    bool is_mapped() const {
+        return mapped.data() != nullptr;
+    }
+
+    /*
+     * 画素(x, y)の指定したAOVのチャンネルの値へのポインタを返す
+     * 同じタイル内で同じ行の画素は連続して並ぶ
+     */
+    float *at(AOVType aov, int channel, int x, int y) {
+        return base + offset(aov, channel, x, y);
+    }
+
+    const float *at(AOVType aov, int channel, int x, int y) const {
+        return base + offset(aov, channel, x, y);
+    }
+
+    // タイル(tx, ty)の先頭と大きさ(float数)
+    float *tile(int tx, int ty) {
+        return base + tile_offset(tx, ty);
+    }
+
+    size_t tile_floats() const {
+        return static_cast<size_t>(planes) * tile_size * tile_size;
+    }
+
+    // 全タイルを含む領域の先頭と大きさ(float数)、チェックポイントの保存と復元に利用する
+    float *storage() {
+        return base;
+    }
+
+    const float *storage() const {
+        return base;
+    }
+
+    size_t storage_floats() const {
+        return tile_floats() * tiles_x * tiles_y;
+    }
+
+    void write(AOVType aov, int x, int y, const Vec3 &v);
+
+    void write(AOVType aov, int x, int y, float v);
+
+    Vec3 read(AOVType aov, int x, int y) const;
+
+    float read_scalar(AOVType aov, int x, int y) const;
+
+    // メモリマップドファイルの場合は変更をファイルに書き戻す
+    void sync() const;
+
+    /*
+     * 各AOVを個別に8bitのImageとして書き出す
+     * Beauty, Albedo: RGBPixelと同様にクランプとガンマ補正
+     * Normal: NormalPixelと同様に[-1, 1]を[0, 1]に写像
+     * Depth: 衝突した画素の最大の距離で正規化したグレースケール
+     * ObjectId: IDのハッシュ値から生成した色
+     * SampleCount: 最大のサンプル数で正規化したグレースケール
+     */
+    Image to_image(AOVType aov) const;
+
+    /*
+     * to_imageと同じ変換でPNGとして書き出す
+     * Imageを経由せず1行ずつ8bitに変換してストリップ毎に並列に圧縮する(png_write_rows)
+     * level、threadsはImage::png_output_parallelと同じ
+     */
+    void png_output(AOVType aov, const std::string &filename, int level = 6, int threads = 0) const;
+
+    /*
+     * 浮動小数点のままファイルに書き出す(クランプやガンマ補正は行わない)
+     * 1行分のバッファのみを利用して1行ずつ書き出すため、画像全体の一時的なコピーは作成しない
+     * 1行はタイルの行をつなぎ合わせて作るため、同じタイルの行に対するアクセスは連続する
+     *
+     * pfm_output: PFM形式(3chはPF, 1chはPf)
+     *  PFMは下の行から順に格納される
+     *  スケール値の符号でエンディアンを表す(負ならリトルエンディアン)
+     *
+     * raw_output: プレーナ形式の独自フォーマット
+     *  ヘッダ: "FTBRAW01"(8byte), width, height, aov_mask, channels(各uint32)
+     *  本体: 有効なAOVの順に各チャンネルの平面をfloat32で上の行から格納する
+     */
+    void pfm_output(AOVType aov, const std::string &filename) const;
+
+    void raw_output(const std::string &filename, uint32_t mask = AOV_ALL) const;
+
+private:
+    std::vector<float> heap;
+    MappedFile mapped;
+    float *base = nullptr;
+
+    int planes = 0;
+
+    // 各AOVのタイル内での先頭平面のインデックス(無効なAOVは-1)
+    std::array<int, AOV_COUNT> first_plane{};
+
+    void init_layout();
+
+    size_t tile_offset(int tx, int ty) const {
+        return (static_cast<size_t>(ty) * tiles_x + tx) * tile_floats();
+    }
+
+    size_t offset(AOVType aov, int channel, int x, int y) const;
+
+    // 1行分のチャンネルの値をrowに書き出す
+    void read_row(AOVType aov, int channel, int y, float *row) const;
+
+    // DepthとSampleCountの正規化に用いる最大値(それ以外のAOVは0)
+    float scalar_max(AOVType aov) const;
+
+    // 1行分をto_imageと同じ変換で8bitのRGBとしてdstに書き出す
+    void pixel_row(AOVType aov, int y, float max_value, uint8_t *dst) const;
+};
+
+#endif //PRACTICEPATHTRACING_FRAMEBUFFER_H
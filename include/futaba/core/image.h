@@ -5,7 +5,10 @@
 #ifndef PRACTICEPATHTRACING_IMAGE_H
 #define PRACTICEPATHTRACING_IMAGE_H
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 #include "futaba/core/pixel.h"
 
@@ -28,6 +31,21 @@ public:
     void write_pixel(int x, int y, const RGBPixel &p);
 
     void png_output(const std::string &filename, int comp) const;
+
+    /*
+     * 水平方向の帯(ストリップ)毎に並列に圧縮してPNGとして書き出す
+     * level: zlibの圧縮レベル(0は無圧縮のstore、1は最速、9は最高圧縮)
+     * threads: 0の場合はハードウェアの並列数を利用する
+     */
+    void png_output_parallel(const std::string &filename, int comp, int level = 6, int threads = 0) const;
 };
 
+/*
+ * png_output_parallelと同じストリップ毎の並列圧縮でPNGを書き出す
+ * 画素値は画像全体を保持せず、row_bytes(y, dst)で1行分(width * comp byte)ずつdstに書き込ませる
+ * row_bytesは複数のスレッドから同時に呼び出され、ストリップの境界の行は2回呼び出されることがある
+ */
+void png_write_rows(const std::string &filename, int width, int height, int comp,
+                    const std::function<void(int, uint8_t *)> &row_bytes, int level = 6, int threads = 0);
+
 #endif //PRACTICEPATHTRACING_IMAGE_H
\ No newline at end of file
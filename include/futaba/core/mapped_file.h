@@ -0,0 +1,77 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * MappedFileクラス
+ * ファイルをmmapで仮想メモリ空間に割り当てる
+ * 割り当てた領域へのアクセスはOSのページングにより必要な部分のみが物理メモリに読み込まれる
+ * そのため物理メモリよりも大きなファイルも扱うことができる
+ *
+ * POSIXの共有メモリ(shm_open)の名前付きの領域も同様に割り当てられる
+ * 共有メモリの名前は"/name"の形式とし、unlink_sharedを呼び出すまで全てのプロセスの割り当てが解除されても残る
+ *
+ * 割り当てを解除する必要があるためコピーは禁止する
+ */
+
+#ifndef PRACTICEPATHTRACING_MAPPED_FILE_H
+#define PRACTICEPATHTRACING_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+public:
+    /*
+     * 読み書き用にファイルを作成してsizeバイトに拡張する
+     * 拡張した領域は疎なファイルとなり、書き込まれるまでディスクは消費しない
+     */
+    static MappedFile create(const std::string &path, size_t size);
+
+    /*
+     * ファイルを伴わない無名の領域を割り当てる
+     * 各ページは最初に書き込まれた時点で0で初期化された物理メモリが割り当てられる
+     */
+    static MappedFile anonymous(size_t size);
+
+    // 既存のファイルを読み込み専用で割り当てる
+    static MappedFile open_readonly(const std::string &path);
+
+    // 共有メモリの領域を作成してsizeバイトを読み書き用に割り当てる、同名の領域が既にある場合は例外を送出する
+    static MappedFile create_shared(const std::string &name, size_t size);
+
+    // 既存の共有メモリの領域を読み込み専用で割り当てる
+    static MappedFile open_shared_readonly(const std::string &name);
+
+    // 共有メモリの名前を削除する、既に割り当てたプロセスの領域は解除されるまで有効
+    static void unlink_shared(const std::string &name);
+
+    MappedFile() = default;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&src) noexcept;
+
+    MappedFile &operator=(MappedFile &&src) noexcept;
+
+    ~MappedFile();
+
+    void *data() const {
+        return addr;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    // 変更をファイルに書き戻す
+    void sync() const;
+
+private:
+    void *addr = nullptr;
+    size_t length = 0;
+
+    void unmap();
+};
+
+#endif //PRACTICEPATHTRACING_MAPPED_FILE_H
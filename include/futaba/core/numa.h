@@ -0,0 +1,54 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * NUMA(Non-Uniform Memory Access)のノードの構成とスレッドの固定
+ *
+ * 複数のソケットを持つ計算機では、各ソケットのCPUは自身のノードのメモリを速く読み書きできる
+ * Linuxは物理メモリをページに最初に書き込んだスレッドが動作するノードから割り当てる(first-touch)ため、
+ * スレッドをノードに固定し、各スレッドが使う領域をそのスレッド自身に最初に書き込ませれば、アクセスはノード内で完結する
+ *
+ * ノードの構成は/sys/devices/system/node以下の各ノードのcpulistから読み込み、libnumaには依存しない
+ * 構成を読めない環境(Linux以外、sysfsの無いコンテナ)では全てのCPUを含む1つのノードとして扱う
+ * ノードはnuma_nodesの中の位置(0から)で指定する(ノードの番号idは欠番を含み得るため位置とは異なる)
+ */
+
+#ifndef PRACTICEPATHTRACING_NUMA_H
+#define PRACTICEPATHTRACING_NUMA_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct NumaNode {
+    // カーネルのノード番号
+    int id;
+    // ノードに属するCPUの番号
+    std::vector<int> cpus;
+};
+
+// CPUのリスト("0-3,8-11"の形式)を解釈する
+std::vector<int> parse_cpu_list(const std::string &list);
+
+// システムのNUMAノード(CPUを持たないノードは除く)、初回の呼び出しで読み込んで以降は同じ値を返す
+const std::vector<NumaNode> &numa_nodes();
+
+/*
+ * 呼び出したスレッドをnode番目のノードのCPUに固定する
+ * 固定に失敗した場合(cpusetの制限など)はfalseを返し、スレッドはそのまま動作する
+ */
+bool pin_thread_to_node(int node);
+
+/*
+ * 呼び出したスレッドが動作しているノードの位置を返す
+ * pin_thread_to_nodeで固定したスレッドは固定先、それ以外は現在のCPUから求める(分からない場合は0)
+ */
+int current_numa_node();
+
+/*
+ * node番目のノードに固定したスレッドを生成してfnを実行し、完了を待つ
+ * fnで確保して書き込んだメモリはそのノードに割り当てられる
+ * fnが送出した例外は呼び出し元で送出し直す
+ */
+void run_on_numa_node(int node, const std::function<void()> &fn);
+
+#endif //PRACTICEPATHTRACING_NUMA_H
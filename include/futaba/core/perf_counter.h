@@ -0,0 +1,49 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * CacheCounterクラス
+ * Linuxのperf_event_openでキャッシュミスのハードウェアカウンタを計測する(ベンチマーク用)
+ *
+ * 計測するイベントはCPUに依らず利用できる汎用のもののみとする
+ *  l1d_misses  L1データキャッシュの読み込みミス(L2への参照)
+ *  llc_misses  最終レベルキャッシュのミス(メモリへの参照)
+ * L2のミスは汎用のイベントが無いため、L2を最終レベルとしないCPUではllc_missesを目安とする
+ *
+ * 計測の開始後に生成したスレッドも計測に含める(生成済みのスレッドは含まない)
+ * 生成したスレッドの値はそのスレッドの終了時に加算されるため、stopの前にスレッドを終了させておく
+ * Linux以外やカウンタを利用できない環境(perf_event_paranoid、仮想マシン)ではavailableがfalseとなり値は0となる
+ */
+
+#ifndef PRACTICEPATHTRACING_PERF_COUNTER_H
+#define PRACTICEPATHTRACING_PERF_COUNTER_H
+
+#include <cstdint>
+
+class CacheCounter {
+public:
+    CacheCounter();
+
+    CacheCounter(const CacheCounter &) = delete;
+
+    CacheCounter &operator=(const CacheCounter &) = delete;
+
+    ~CacheCounter();
+
+    bool available() const {
+        return fds[0] >= 0 || fds[1] >= 0;
+    }
+
+    // カウンタを0にして計測を開始する
+    void start();
+
+    // 計測を終了してl1d_missesとllc_missesを更新する
+    void stop();
+
+    uint64_t l1d_misses = 0;
+    uint64_t llc_misses = 0;
+
+private:
+    int fds[2];
+};
+
+#endif //PRACTICEPATHTRACING_PERF_COUNTER_H
@@ -0,0 +1,212 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * RayPacketクラス
+ * N本(4の倍数)のレイを成分毎の配列(SoA)にまとめ、1つのボックスとの判定を全てのレイについてまとめて行う
+ *
+ * カメラからの一次レイは隣接する画素で始点が同じで方向もほぼ揃っているため、BVHのほぼ同じノードを辿る
+ * パケットでは各ノードのボックスを1回読み込んでN本のレイと判定し、判定はSSEで4本ずつ行う
+ * SSEを利用できない環境ではAABB::is_hittableをレイ毎に呼び出す(どちらも結果は同一)
+ *
+ * 全てのレイの方向の各成分の符号が揃っている場合(coherent)は、始点と方向の逆数の範囲から
+ * 区間演算でパケット全体の入る距離の下限と出る距離の上限を求め、どのレイも衝突し得ないボックスをレイ毎の判定の前に除く
+ * 範囲の計算は丸めの向きを含めて単調であるため、レイ毎の判定で衝突するボックスを除くことはない
+ * 後回しにしたノードは各レーンの入る距離を保持し、取り出す際はt_maxとの比較のみで判定し直す
+ *
+ * 各レイのt_maxはtraverseの呼び出し中に衝突判定の結果で更新する
+ * プリミティブ側もパケットとの判定を持つ場合(Mesh::candidate_mask)は、葉でもレーンをまとめて判定できる
+ */
+
+#ifndef PRACTICEPATHTRACING_RAY_PACKET_H
+#define PRACTICEPATHTRACING_RAY_PACKET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "futaba/core/aabb.h"
+#include "futaba/core/ray.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+template<int N>
+class RayPacket {
+    static_assert(N % 4 == 0 && N <= 32, "RayPacket: N must be a multiple of 4 up to 32");
+
+public:
+    alignas(16) float origin[3][N];
+    alignas(16) float direction[3][N];
+    alignas(16) float inv_direction[3][N];
+    alignas(16) float t_max[N];
+    // 有効なレイのマスク(count本未満のパケットの残りのレーンは無効とする)
+    uint32_t valid;
+    // 全てのレイの方向の各成分の符号が揃い、区間演算による枝刈りを利用できる
+    bool coherent;
+
+    /*
+     * rays[0, count)をまとめる
+     * t_maxは全てのレイで共通の初期値
+     */
+    RayPacket(const Ray *rays, int count, float _t_max) {
+        count = std::min(std::max(count, 1), N);
+        valid = count == 32 ? 0xffffffffu : (1u << static_cast<uint32_t>(count)) - 1u;
+        for (int i = 0; i < N; i++) {
+            // 無効なレーンは先頭のレイで埋め、判定の結果はマスクで捨てる
+            const Ray &ray = rays[i < count ? i : 0];
+            for (int k = 0; k < 3; k++) {
+                origin[k][i] = ray.origin.elements[k];
+                direction[k][i] = ray.direction.elements[k];
+                inv_direction[k][i] = 1.0f / ray.direction.elements[k];
+            }
+            t_max[i] = _t_max;
+        }
+
+        coherent = true;
+        for (int k = 0; k < 3; k++) {
+            origin_min[k] = origin_max[k] = origin[k][0];
+            inv_min[k] = inv_max[k] = inv_direction[k][0];
+            for (int i = 1; i < N; i++) {
+                origin_min[k] = std::min(origin_min[k], origin[k][i]);
+                origin_max[k] = std::max(origin_max[k], origin[k][i]);
+                inv_min[k] = std::min(inv_min[k], inv_direction[k][i]);
+                inv_max[k] = std::max(inv_max[k], inv_direction[k][i]);
+            }
+            // 符号の異なる成分や0の成分(逆数が無限大)を含む場合は区間演算を行わない
+            if (!(inv_min[k] > 0.0f || inv_max[k] < 0.0f) || std::isinf(inv_min[k]) || std::isinf(inv_max[k]))
+                coherent = false;
+        }
+    }
+
+    Vec3 lane_origin(int i) const {
+        return {origin[0][i], origin[1][i], origin[2][i]};
+    }
+
+    Vec3 lane_inv_direction(int i) const {
+        return {inv_direction[0][i], inv_direction[1][i], inv_direction[2][i]};
+    }
+
+    /*
+     * パケットのどのレイもboxと衝突し得ない場合にtrueを返す(coherentの場合のみ判定する)
+     * falseの場合でも衝突するとは限らないため、続けてhit_maskで判定する
+     * 判定の手間はSSEの4本分の判定とほぼ同じため、16本未満のパケットでは効果がなく行わない
+     */
+    bool culled(const AABB &box, float t_min) const {
+        if (!coherent || N < 16)
+            return false;
+        float near_lo = t_min;
+        float far_hi = max_t_max();
+        for (int k = 0; k < 3; k++) {
+            // 方向が正の軸はminの面から入りmaxの面から出る、負の軸はその逆
+            bool positive = inv_min[k] > 0.0f;
+            float entry = positive ? box.min.elements[k] : box.max.elements[k];
+            float exit = positive ? box.max.elements[k] : box.min.elements[k];
+            float lo, hi;
+            interval_mul(entry - origin_max[k], entry - origin_min[k], inv_min[k], inv_max[k], lo, hi);
+            near_lo = std::max(near_lo, lo);
+            interval_mul(exit - origin_max[k], exit - origin_min[k], inv_min[k], inv_max[k], lo, hi);
+            far_hi = std::min(far_hi, hi * AABB::SLAB_MARGIN);
+        }
+        return near_lo > far_hi;
+    }
+
+    /*
+     * activeのレーンのレイとboxの判定を行い、衝突したレーンのマスクを返す
+     * t_enterには衝突したレーンのボックスに入る距離を設定する
+     * 各レーンの結果はAABB::is_hittableと同一となる
+     */
+    uint32_t hit_mask(const AABB &box, float t_min, uint32_t active, float *t_enter) const {
+        uint32_t mask = 0;
+#ifdef __SSE2__
+        const __m128 margin = _mm_set1_ps(AABB::SLAB_MARGIN);
+        // 方向の符号が揃っている場合は入る面と出る面が全てのレーンで共通のため、入れ替えの判定を省く
+        float entry[3] = {}, exit[3] = {};
+        if (coherent) {
+            for (int k = 0; k < 3; k++) {
+                bool positive = inv_min[k] > 0.0f;
+                entry[k] = positive ? box.min.elements[k] : box.max.elements[k];
+                exit[k] = positive ? box.max.elements[k] : box.min.elements[k];
+            }
+        }
+        for (int g = 0; g < N; g += 4) {
+            if (((active >> static_cast<uint32_t>(g)) & 0xfu) == 0)
+                continue;
+            __m128 near = _mm_set1_ps(t_min);
+            __m128 far = _mm_load_ps(t_max + g);
+            for (int k = 0; k < 3; k++) {
+                __m128 o = _mm_load_ps(origin[k] + g);
+                __m128 inv = _mm_load_ps(inv_direction[k] + g);
+                __m128 lo, hi;
+                if (coherent) {
+                    lo = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(entry[k]), o), inv);
+                    hi = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(exit[k]), o), inv);
+                } else {
+                    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.elements[k]), o), inv);
+                    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.elements[k]), o), inv);
+                    // t0 > t1の場合のみ入れ替える(NaNは入れ替えない)
+                    __m128 swap = _mm_cmpgt_ps(t0, t1);
+                    lo = _mm_or_ps(_mm_and_ps(swap, t1), _mm_andnot_ps(swap, t0));
+                    hi = _mm_or_ps(_mm_and_ps(swap, t0), _mm_andnot_ps(swap, t1));
+                }
+                hi = _mm_mul_ps(hi, margin);
+                // _mm_max_ps(a, b)は(a > b ? a : b)で、NaNの場合はbを返すためis_hittableの比較と一致する
+                near = _mm_max_ps(lo, near);
+                far = _mm_min_ps(hi, far);
+            }
+            auto hit = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(near, far)));
+            _mm_storeu_ps(t_enter + g, near);
+            mask |= hit << static_cast<uint32_t>(g);
+        }
+        return mask & active;
+#else
+        for (int i = 0; i < N; i++) {
+            if ((active >> static_cast<uint32_t>(i) & 1u) &&
+                box.is_hittable(lane_origin(i), lane_inv_direction(i), t_min, t_max[i], t_enter[i]))
+                mask |= 1u << static_cast<uint32_t>(i);
+        }
+        return mask;
+#endif
+    }
+
+    // activeのレーンのうちt_enter <= t_maxのレーンのマスク(後回しにしたノードに入るかの判定)
+    uint32_t closer_mask(const float *t_enter, uint32_t active) const {
+        uint32_t mask = 0;
+#ifdef __SSE2__
+        for (int g = 0; g < N; g += 4) {
+            auto closer = static_cast<uint32_t>(_mm_movemask_ps(
+                    _mm_cmple_ps(_mm_load_ps(t_enter + g), _mm_load_ps(t_max + g))));
+            mask |= closer << static_cast<uint32_t>(g);
+        }
+#else
+        for (int i = 0; i < N; i++) {
+            if (t_enter[i] <= t_max[i])
+                mask |= 1u << static_cast<uint32_t>(i);
+        }
+#endif
+        return mask & active;
+    }
+
+private:
+    float origin_min[3];
+    float origin_max[3];
+    float inv_min[3];
+    float inv_max[3];
+
+    float max_t_max() const {
+        float t = t_max[0];
+        for (int i = 1; i < N; i++) {
+            if (valid >> static_cast<uint32_t>(i) & 1u)
+                t = std::max(t, t_max[i]);
+        }
+        return t;
+    }
+
+    // 区間の積[a0, a1] * [b0, b1]
+    static void interval_mul(float a0, float a1, float b0, float b1, float &lo, float &hi) {
+        float p0 = a0 * b0, p1 = a0 * b1, p2 = a1 * b0, p3 = a1 * b1;
+        lo = std::min(std::min(p0, p1), std::min(p2, p3));
+        hi = std::max(std::max(p0, p1), std::max(p2, p3));
+    }
+};
+
+#endif //PRACTICEPATHTRACING_RAY_PACKET_H
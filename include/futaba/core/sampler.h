@@ -0,0 +1,57 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Samplerクラス
+ * (シード, 画素のインデックス, サンプル番号)の組から一意に決まる乱数列を生成する
+ *
+ * util.cppのrnd()はグローバルなメルセンヌ・ツイスタを共有するため
+ * スレッド数やタイルの処理順によって各画素が受け取る乱数が変わってしまう
+ * Samplerでは乱数列が上記の組のみで決まるため、どの順番で処理しても同じ画像が得られる
+ * また中断したレンダリングは各画素のサンプル数さえ分かれば、続きのサンプルから正確に再開できる
+ *
+ * 乱数生成器にはPCG32を利用する
+ * https://www.pcg-random.org/
+ */
+
+#ifndef PRACTICEPATHTRACING_SAMPLER_H
+#define PRACTICEPATHTRACING_SAMPLER_H
+
+#include <cstdint>
+
+class Sampler {
+public:
+    Sampler(uint64_t seed, uint64_t pixel_index, uint64_t sample_index) {
+        // 画素毎に異なるストリームを選び、初期状態はシードとサンプル番号から決める
+        inc = (splitmix64(seed ^ splitmix64(pixel_index)) << 1u) | 1u;
+        state = 0;
+        next_uint();
+        state += splitmix64(seed + sample_index * 0x9e3779b97f4a7c15ull);
+        next_uint();
+    }
+
+    uint32_t next_uint() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + inc;
+        auto xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        auto rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+    }
+
+    // [0, 1)の一様乱数
+    float next() {
+        return static_cast<float>(next_uint() >> 8u) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint64_t state;
+    uint64_t inc;
+
+    static uint64_t splitmix64(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31u);
+    }
+};
+
+#endif //PRACTICEPATHTRACING_SAMPLER_H
@@ -0,0 +1,124 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Socketクラス
+ * プロセス間でメッセージを送受信するためのソケット
+ *
+ * アドレスの形式:
+ *  unix:/path/to/socket  Unixドメインソケット(同一マシン内)
+ *  tcp:host:port         TCPソケット
+ *
+ * メッセージの形式:
+ *  [type(uint32)][length(uint64)][payload(lengthバイト)]
+ *  送受信するプロセスは同一のエンディアンであることを前提とする
+ */
+
+#ifndef PRACTICEPATHTRACING_SOCKET_H
+#define PRACTICEPATHTRACING_SOCKET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Message {
+    uint32_t type = 0;
+    std::vector<uint8_t> payload;
+};
+
+class Socket {
+public:
+    Socket() = default;
+
+    explicit Socket(int _fd) : fd(_fd) {};
+
+    Socket(const Socket &) = delete;
+
+    Socket &operator=(const Socket &) = delete;
+
+    Socket(Socket &&src) noexcept;
+
+    Socket &operator=(Socket &&src) noexcept;
+
+    ~Socket();
+
+    // 待ち受け用のソケットを作成する(Unixドメインソケットの場合は既存のファイルを削除する)
+    static Socket listen(const std::string &address);
+
+    static Socket connect(const std::string &address);
+
+    Socket accept() const;
+
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    int handle() const {
+        return fd;
+    }
+
+    void close();
+
+    // 送受信を打ち切り、他のスレッドでブロックしている送受信を失敗させる
+    void shutdown() const;
+
+    // 受信がseconds秒以上停止した場合にrecv_messageを失敗させる(0で無効)
+    void set_recv_timeout(double seconds) const;
+
+    /*
+     * 送受信は全てのバイトを処理するまでブロックする
+     * 接続が切断された場合は例外を送出する
+     */
+    void send_message(uint32_t type, const void *payload, size_t size) const;
+
+    void send_message(uint32_t type, const std::vector<uint8_t> &payload) const {
+        send_message(type, payload.data(), payload.size());
+    }
+
+    Message recv_message() const;
+
+private:
+    int fd = -1;
+
+    void send_all(const void *data, size_t size) const;
+
+    void recv_all(void *data, size_t size) const;
+};
+
+/*
+ * メッセージのペイロードを組み立てる/読み出すための補助関数
+ * PODのみを対象とする
+ */
+template<typename T>
+void put_value(std::vector<uint8_t> &buf, const T &v) {
+    auto p = reinterpret_cast<const uint8_t *>(&v);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+T get_value(const std::vector<uint8_t> &buf, size_t &offset) {
+    T v;
+    if (offset + sizeof(T) > buf.size())
+        throw std::runtime_error("message is too short");
+    std::copy(buf.begin() + offset, buf.begin() + offset + sizeof(T), reinterpret_cast<uint8_t *>(&v));
+    offset += sizeof(T);
+    return v;
+}
+
+inline void put_string(std::vector<uint8_t> &buf, const std::string &s) {
+    put_value(buf, static_cast<uint32_t>(s.size()));
+    buf.insert(buf.end(), s.begin(), s.end());
+}
+
+inline std::string get_string(const std::vector<uint8_t> &buf, size_t &offset) {
+    auto size = get_value<uint32_t>(buf, offset);
+    if (offset + size > buf.size())
+        throw std::runtime_error("message is too short");
+    std::string s(buf.begin() + offset, buf.begin() + offset + size);
+    offset += size;
+    return s;
+}
+
+#endif //PRACTICEPATHTRACING_SOCKET_H
@@ -0,0 +1,85 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * ThreadPoolクラス
+ * 生成時に起動したスレッドを破棄するまで使い回す
+ * レンダリングの度にスレッドを生成・破棄するコストを避けるために利用する
+ *
+ * 複数のスレッドから同時にparallel_forを呼び出してもよい
+ * 呼び出し元のスレッドも処理に参加するため、プール内のスレッドが全て埋まっていても処理は進む
+ *
+ * numaを指定した場合は各スレッドをNUMAのノード(numa.h)に均等に割り振って固定する
+ * parallel_for_nodesはインデックスをノード毎の連続した範囲に分け、各スレッドは自身のノードの範囲から取得する
+ * 同じ数で繰り返し呼び出せば同じインデックスは同じノードで処理されるため、
+ * 各インデックスの書き込む領域は最初の呼び出しで(first-touchにより)そのノードのメモリに置かれる
+ * 自身の範囲を処理し終えたスレッドは他のノードの範囲を引き受けるため、負荷の偏りで待つことはない
+ */
+
+#ifndef PRACTICEPATHTRACING_THREAD_POOL_H
+#define PRACTICEPATHTRACING_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    /*
+     * threadsが0の場合はハードウェアの並列数を利用する(呼び出し元のスレッドを含めた数)
+     * numaがtrueの場合はプール内のスレッドをノードに固定する(呼び出し元のスレッドは固定しない)
+     */
+    explicit ThreadPool(int threads = 0, bool numa = false);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool();
+
+    // 呼び出し元のスレッドを含めた並列数
+    int size() const {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    // parallel_for_nodesでインデックスを分ける数(numaを指定しない場合は1)
+    int node_count() const {
+        return partitions;
+    }
+
+    /*
+     * [0, count)の各インデックスに対してfnを並列に呼び出し、全て完了するまで待つ
+     * インデックスは早く処理を終えたスレッドから順に取得される
+     * fnが例外を送出した場合は未着手のインデックスを処理せず、全てのスレッドの終了を待ってから最初の例外を送出する
+     */
+    void parallel_for(int count, const std::function<void(int)> &fn);
+
+    /*
+     * parallel_forと同様に[0, count)の各インデックスに対してfnを呼び出す
+     * インデックスはnode_count個の連続した範囲に分け、node番目の範囲はそのノードのスレッドが優先して処理する
+     * node_countが1の場合はparallel_forと同じ
+     */
+    void parallel_for_nodes(int count, const std::function<void(int)> &fn);
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    int partitions = 1;
+
+    // nodeが0以上の場合はそのノードに固定してからタスクを待つ
+    void worker_loop(int node);
+
+    /*
+     * fnをプール内のhelpers個のスレッドと呼び出し元で実行し、全て終了するまで待つ
+     * fnが例外を送出した場合はfnに渡すフラグを立て、全て終了した後に最初の例外を送出する
+     */
+    void run_parallel(int helpers, const std::function<void(const std::atomic<bool> &)> &fn);
+};
+
+#endif //PRACTICEPATHTRACING_THREAD_POOL_H
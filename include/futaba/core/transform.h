@@ -0,0 +1,133 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Transformクラス
+ * 3x4行列によるアフィン変換(回転・拡大縮小・平行移動の組み合わせ)を表す
+ *
+ * 点には平行移動を含めて適用し、方向ベクトルには平行移動を含めずに適用する
+ * 法線は非一様な拡大縮小で向きが変わるため、逆変換の転置行列を適用する(apply_normalには逆変換を渡す)
+ */
+
+#ifndef PRACTICEPATHTRACING_TRANSFORM_H
+#define PRACTICEPATHTRACING_TRANSFORM_H
+
+#include <cmath>
+#include <stdexcept>
+#include "futaba/core/aabb.h"
+#include "futaba/core/vec3.h"
+
+class Transform {
+public:
+    // m[row][col]、4列目は平行移動
+    float m[3][4];
+
+    // 恒等変換
+    Transform() {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 4; c++)
+                m[r][c] = r == c ? 1.0f : 0.0f;
+        }
+    }
+
+    static Transform translate(const Vec3 &t) {
+        Transform tr;
+        for (int r = 0; r < 3; r++)
+            tr.m[r][3] = t.elements[r];
+        return tr;
+    }
+
+    static Transform scale(const Vec3 &s) {
+        Transform tr;
+        for (int r = 0; r < 3; r++)
+            tr.m[r][r] = s.elements[r];
+        return tr;
+    }
+
+    // axis(0: x, 1: y, 2: z)周りにtheta[rad]回転する
+    static Transform rotate(int axis, float theta) {
+        Transform tr;
+        int a = (axis + 1) % 3;
+        int b = (axis + 2) % 3;
+        float cos_t = std::cos(theta);
+        float sin_t = std::sin(theta);
+        tr.m[a][a] = cos_t;
+        tr.m[a][b] = -sin_t;
+        tr.m[b][a] = sin_t;
+        tr.m[b][b] = cos_t;
+        return tr;
+    }
+
+    // 右から順に適用する(this * rhsはrhsを先に適用する)
+    Transform operator*(const Transform &rhs) const {
+        Transform tr;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 4; c++) {
+                float v = c == 3 ? m[r][3] : 0.0f;
+                for (int k = 0; k < 3; k++)
+                    v += m[r][k] * rhs.m[k][c];
+                tr.m[r][c] = v;
+            }
+        }
+        return tr;
+    }
+
+    Transform inverse() const {
+        // 3x3部分の余因子行列から逆行列を求める
+        float a[3][3];
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                int r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+                int c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+                // 転置した位置に格納する
+                a[c][r] = m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1];
+            }
+        }
+        float det = m[0][0] * a[0][0] + m[0][1] * a[1][0] + m[0][2] * a[2][0];
+        if (det == 0.0f)
+            throw std::runtime_error("transform is not invertible");
+
+        Transform tr;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++)
+                tr.m[r][c] = a[r][c] / det;
+        }
+        for (int r = 0; r < 3; r++)
+            tr.m[r][3] = -(tr.m[r][0] * m[0][3] + tr.m[r][1] * m[1][3] + tr.m[r][2] * m[2][3]);
+        return tr;
+    }
+
+    Vec3 apply_point(const Vec3 &p) const {
+        return {m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+                m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+                m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]};
+    }
+
+    Vec3 apply_vector(const Vec3 &v) const {
+        return {m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+                m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+                m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z()};
+    }
+
+    // thisは法線を変換したい変換の逆変換、結果は正規化しない
+    Vec3 apply_normal(const Vec3 &n) const {
+        return {m[0][0] * n.x() + m[1][0] * n.y() + m[2][0] * n.z(),
+                m[0][1] * n.x() + m[1][1] * n.y() + m[2][1] * n.z(),
+                m[0][2] * n.x() + m[1][2] * n.y() + m[2][2] * n.z()};
+    }
+
+    // 変換後の8頂点を含むAABB
+    AABB apply_bounds(const AABB &box) const {
+        AABB result;
+        if (box.is_empty())
+            return result;
+        for (int i = 0; i < 8; i++) {
+            Vec3 corner((i & 1) ? box.max.x() : box.min.x(),
+                        (i & 2) ? box.max.y() : box.min.y(),
+                        (i & 4) ? box.max.z() : box.min.z());
+            result.expand(apply_point(corner));
+        }
+        return result;
+    }
+};
+
+#endif //PRACTICEPATHTRACING_TRANSFORM_H
@@ -0,0 +1,45 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 2次元の格子を走査する順序(空間充填曲線)
+ *
+ * 走査線順では行の末尾から次の行の先頭へ移るたびに画面上で離れた位置に飛び、
+ * 連続して追跡するレイがBVHやジオメトリの異なる領域を参照するためキャッシュの再利用が減る
+ * Morton順(Z順)とHilbert順は近い番号の格子点が空間的にも近くに集まる
+ *  Morton  xとyのビットを交互に並べた値の順、計算は軽いが各象限の間で大きく飛ぶことがある
+ *  Hilbert 隣り合う番号の格子点が常に隣接する、Morton順より局所性が高い
+ *
+ * 幅と高さが2の冪でない場合は両方を覆う2の冪の正方形の曲線を辿り、範囲外の点を除く
+ */
+
+#ifndef PRACTICEPATHTRACING_TRAVERSAL_ORDER_H
+#define PRACTICEPATHTRACING_TRAVERSAL_ORDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum TraversalOrder {
+    ORDER_SCANLINE = 0,
+    ORDER_MORTON,
+    ORDER_HILBERT
+};
+
+// "scanline", "morton", "hilbert"から変換する、未知の名前の場合は例外を送出する
+TraversalOrder traversal_order_from_name(const std::string &name);
+
+const char *traversal_order_name(TraversalOrder order);
+
+// Morton順の番号dの格子点
+void morton_d2xy(uint32_t d, uint32_t &x, uint32_t &y);
+
+// 3次元の格子点(各軸10ビットまで)のMorton符号
+uint32_t morton_encode3(uint32_t x, uint32_t y, uint32_t z);
+
+// 一辺n(2の冪)のHilbert曲線の番号dの格子点
+void hilbert_d2xy(uint32_t n, uint32_t d, uint32_t &x, uint32_t &y);
+
+// width x heightの格子点をorderの順に並べ、各点をy * width + xで返す
+std::vector<uint32_t> traversal_order(int width, int height, TraversalOrder order);
+
+#endif //PRACTICEPATHTRACING_TRAVERSAL_ORDER_H
@@ -0,0 +1,106 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Vec3Arrayクラス
+ *
+ * 連続した(N, 3)のfloatの配列をVec3の列として扱う
+ * Pythonから100万点の座標を変換する場合に、Vec3を1つずつ生成して演算するとpybindの呼び出しとオブジェクトの生成が
+ * 要素毎に発生するため、配列全体に対する演算をC++のループとしてまとめて行う
+ *
+ * 配列は自身で確保するか、外部のバッファを複製せずに参照する(ownerはバッファの所有者)
+ * NumPyの配列とは互いに複製せずにメモリを共有できる
+ * 読み取り専用のバッファも参照でき、その場合は入力としてのみ利用できる(書き込むとstd::runtime_errorを送出する)
+ *
+ * 各演算はvec3.hの同名の関数を要素毎に適用したものと同じ結果となる
+ * 2つ目以降の引数はVec3Array(要素毎)もしくはVec3(全要素で共通)のどちらも指定できる
+ * 結果はoutに書き込み、outは入力と同じ配列でも良い
+ */
+
+#ifndef PRACTICEPATHTRACING_VEC3_ARRAY_H
+#define PRACTICEPATHTRACING_VEC3_ARRAY_H
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include "futaba/core/vec3.h"
+
+class Vec3Array {
+public:
+    // count要素を0で初期化して確保する
+    explicit Vec3Array(size_t _count = 0);
+
+    // 外部の(count, 3)の配列を複製せずに参照する
+    Vec3Array(float *_data, size_t _count, std::shared_ptr<void> _owner) :
+            owner(std::move(_owner)), buffer(_data), n(_count) {};
+
+    // 外部の読み取り専用の(count, 3)の配列を複製せずに参照する
+    Vec3Array(const float *_data, size_t _count, std::shared_ptr<void> _owner) :
+            owner(std::move(_owner)), buffer(const_cast<float *>(_data)), n(_count), writeable(false) {};
+
+    size_t size() const {
+        return n;
+    }
+
+    bool is_writeable() const {
+        return writeable;
+    }
+
+    float *data() {
+        check_writeable();
+        return buffer;
+    }
+
+    const float *data() const {
+        return buffer;
+    }
+
+    Vec3 get(size_t i) const {
+        const float *p = buffer + 3 * i;
+        return {p[0], p[1], p[2]};
+    }
+
+    void set(size_t i, const Vec3 &v) {
+        check_writeable();
+        float *p = buffer + 3 * i;
+        p[0] = v.x();
+        p[1] = v.y();
+        p[2] = v.z();
+    }
+
+private:
+    std::shared_ptr<void> owner;
+    float *buffer;
+    size_t n;
+    bool writeable = true;
+
+    void check_writeable() const {
+        if (!writeable)
+            throw std::runtime_error("Vec3Array: array is read-only");
+    }
+};
+
+void dot(const Vec3Array &a, const Vec3Array &b, float *out);
+
+void dot(const Vec3Array &a, const Vec3 &b, float *out);
+
+void cross(const Vec3Array &a, const Vec3Array &b, Vec3Array &out);
+
+void cross(const Vec3Array &a, const Vec3 &b, Vec3Array &out);
+
+void unit_vec(const Vec3Array &v, Vec3Array &out);
+
+void rotation_x(const Vec3Array &v, float theta, Vec3Array &out);
+
+void rotation_y(const Vec3Array &v, float theta, Vec3Array &out);
+
+void rotation_z(const Vec3Array &v, float theta, Vec3Array &out);
+
+void world_2_local(const Vec3Array &v, const Vec3Array &s, const Vec3Array &n, const Vec3Array &t, Vec3Array &out);
+
+void world_2_local(const Vec3Array &v, const Vec3 &s, const Vec3 &n, const Vec3 &t, Vec3Array &out);
+
+void local_2_world(const Vec3Array &v, const Vec3Array &s, const Vec3Array &n, const Vec3Array &t, Vec3Array &out);
+
+void local_2_world(const Vec3Array &v, const Vec3 &s, const Vec3 &n, const Vec3 &t, Vec3Array &out);
+
+#endif //PRACTICEPATHTRACING_VEC3_ARRAY_H
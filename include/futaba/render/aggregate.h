@@ -1,5 +1,24 @@
 /*
  * Created by okn-yu on 2022/06/04.
+ *
+ * シーン中の全てのオブジェクトを保持し、レイとの最も近い衝突を求める
+ *
+ * オブジェクトはプリミティブの種類毎の配列に値として保持する(primitive.h)
+ * Sphere、Meshの三角形、SphereCloudの球、Instanceは1つのBVHにまとめて登録される
+ * Instanceは変換後の範囲として登録され、その内部はプロトタイプのBVHで判定する
+ * buildを呼び出すまではBVHを利用せずに全てのプリミティブと総当たりで判定する
+ * addでオブジェクトを追加するとBVHは破棄されるため、追加が終わった後に改めてbuildを呼び出す
+ * 配列を直接変更した場合も同様にbuildを呼び出し直す必要がある
+ *
+ * HitRecord::hit_idにはPrimitiveTypesの順(Sphere、Mesh、SphereCloud、Instance)に
+ * 通し番号としたオブジェクトのインデックスを設定する
+ *
+ * buildでは発光する材質のSphere、Meshの三角形、SphereCloudの球からライトBVH(light_bvh.h)も構築する
+ * Instanceのプロトタイプに含まれる発光体は光源として登録せず、経路が衝突した場合のみ寄与する
+ *
+ * 複数のNUMAノードを持つ計算機ではreplicate_bvhでBVHの配列をノード毎に複製できる
+ * 衝突判定は呼び出したスレッドのノードの複製を辿るため、全てのスレッドが1つのノードのメモリを読み合うことがない
+ * 複製するのはBVHのみで、ジオメトリの配列とInstanceのプロトタイプのBVHは共有する
  */
 
 #ifndef PRACTICEPATHTRACING_AGGREGATE_HPP
@@ -7,38 +26,156 @@
 
 #include <memory>
 #include <vector>
+#include "futaba/core/numa.h"
 #include "futaba/core/ray.h"
+#include "futaba/render/bvh.h"
 #include "futaba/render/hit.h"
+#include "futaba/render/instance.h"
+#include "futaba/render/light_bvh.h"
+#include "futaba/render/material.h"
+#include "futaba/render/mesh.h"
+#include "futaba/render/primitive.h"
 #include "futaba/render/sphere.h"
+#include "futaba/render/sphere_cloud.h"
+
+typedef TypeList<Sphere, Mesh, SphereCloud, Instance> PrimitiveTypes;
 
 class Aggregate {
 public:
-    std::vector<std::shared_ptr<Sphere>> spheres;
+    typedef VectorTuple<PrimitiveTypes>::type Storage;
+
+    // 各プリミティブのmaterialが参照する材質
+    MaterialTable materials;
+    // 発光するプリミティブの階層、buildで構築する
+    LightBVH lights;
 
     Aggregate() = default;;
 
     explicit Aggregate(const std::vector<std::shared_ptr<Sphere>> &_spheres) {
-        spheres = _spheres;
+        for (const auto &s: _spheres)
+            add(*s);
+    }
+
+    template<typename T>
+    void add(const T &prim) {
+        primitives<T>().push_back(prim);
+        bvh = BVH();
+        bvh_replicas.clear();
+        lights = LightBVH();
+    }
+
+    template<typename T>
+    void add(const std::shared_ptr<T> &prim) {
+        add(*prim);
+    }
+
+    // 種類Tのプリミティブの配列
+    template<typename T>
+    std::vector<T> &primitives() {
+        return std::get<TypeIndex<T, PrimitiveTypes>::value>(storage);
+    }
+
+    template<typename T>
+    const std::vector<T> &primitives() const {
+        return std::get<TypeIndex<T, PrimitiveTypes>::value>(storage);
     }
 
-    void add(const std::shared_ptr<Sphere> &s) {
-        spheres.push_back(s);
+    std::vector<Sphere> &spheres() {
+        return primitives<Sphere>();
     }
 
-    bool intersect(Ray &ray, HitRecord &hit_rec) const {
-        bool is_hit = false;
+    const std::vector<Sphere> &spheres() const {
+        return primitives<Sphere>();
+    }
+
+    std::vector<Mesh> &meshes() {
+        return primitives<Mesh>();
+    }
+
+    const std::vector<Mesh> &meshes() const {
+        return primitives<Mesh>();
+    }
 
-        for (const auto &s: spheres) {
-            HitRecord hit_temp = HitRecord();
-            if (s->is_hittable(ray, hit_temp)) {
-                if (hit_temp.t < hit_rec.t) {
-                    is_hit = true;
-                    hit_rec = hit_temp;
-                }
-            }
-        }
-        return is_hit;
+    std::vector<SphereCloud> &clouds() {
+        return primitives<SphereCloud>();
     }
+
+    const std::vector<SphereCloud> &clouds() const {
+        return primitives<SphereCloud>();
+    }
+
+    std::vector<Instance> &instances() {
+        return primitives<Instance>();
+    }
+
+    const std::vector<Instance> &instances() const {
+        return primitives<Instance>();
+    }
+
+    // 全てのオブジェクトからBVHとライトBVHを構築する
+    void build();
+
+    /*
+     * 構築済みのBVH(シーンファイルや共有メモリに格納したもの)を用いる
+     * BVHのプリミティブは現在のオブジェクトの並びに対応している必要があり、範囲外を参照する場合は例外を送出する
+     * ライトBVHはbuildと同様に構築する
+     */
+    void use_bvh(const BVH &prebuilt);
+
+    /*
+     * 構築済みのBVHの配列をNUMAのノード毎に、そのノードに固定したスレッドで複製する(first-touchでノードに置かれる)
+     * ノードが1つの場合やBVHを構築していない場合は何もしない
+     * build、use_bvh、addで複製は破棄されるため、その後に改めて呼び出す
+     */
+    void replicate_bvh();
+
+    // ノード毎の複製の数(複製していない場合は0)
+    size_t replica_count() const {
+        return bvh_replicas.size();
+    }
+
+    bool is_built() const {
+        return !bvh.empty();
+    }
+
+    const BVH &acceleration() const {
+        return bvh;
+    }
+
+    // 全てのオブジェクトを含む範囲
+    AABB bounds() const;
+
+    bool intersect(Ray &ray, HitRecord &hit_rec) const;
+
+    /*
+     * count本のレイの最近接の衝突判定をまとめて行う(一次レイのように始点と方向の揃ったレイ向け)
+     * packet_size(4, 8, 16)本ずつパケットとしてBVHを辿り、結果はレイ毎のintersectと同じとなる
+     * is_hitには各レイが衝突したか(0もしくは1)を返す
+     */
+    void intersect_packet(Ray *rays, HitRecord *hits, uint8_t *is_hit, size_t count, int packet_size = 16) const;
+
+    /*
+     * (HIT_DISTANCE_MIN, t_max)の範囲にレイを遮る物体があるかを判定する(シャドウレイ)
+     * 最も近い衝突は求めず、最初に見つかった時点で探索を打ち切る
+     */
+    bool occluded(const Ray &ray, float t_max) const;
+
+private:
+    Storage storage;
+    BVH bvh;
+    // numa_nodesの位置毎のBVHの複製(replicate_bvh)
+    std::vector<BVH> bvh_replicas;
+
+    // 呼び出したスレッドのノードのBVH
+    const BVH &local_bvh() const {
+        return bvh_replicas.empty() ? bvh : bvh_replicas[current_numa_node() % bvh_replicas.size()];
+    }
+
+    bool intersect_prim(const PrimRef &ref, Ray &ray, HitRecord &hit_rec) const;
+
+    // 最大N本のレイをパケットとして判定する
+    template<int N>
+    void intersect_packet_n(Ray *rays, HitRecord *hits, uint8_t *is_hit, int count) const;
 };
 
 #endif //PRACTICEPATHTRACING_AGGREGATE_HPP
@@ -0,0 +1,272 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * プリミティブの種類に依存しないBVH(Bounding Volume Hierarchy)
+ *
+ * 葉にはPrimRef(プリミティブの種類, オブジェクトのインデックス, オブジェクト内のプリミティブ番号)を格納する
+ * SphereもMeshの三角形も同じPrimRefとして扱うため、1つのBVHに全てのプリミティブを登録できる
+ * 実際の衝突判定はtraverseに渡す関数で行い、BVH自体はSphereやMeshを参照しない
+ *
+ * 構築はビン分割によるSAH(Surface Area Heuristic)で行う
+ * ノードは深さ優先の順で1つの配列に格納し、左の子は常に親の直後に置くため右の子のインデックスのみを保持する
+ *
+ * 一次レイのように揃ったレイはtraverse_packetでパケット(ray_packet.h)として一緒に辿ることもできる
+ *
+ * ノードとプリミティブの配列は構築後に変更しないため、BVHをコピーしても配列は共有する
+ * attachで外部の配列(シーンファイルや共有メモリ)を複製せずに参照することもできる
+ */
+
+#ifndef PRACTICEPATHTRACING_BVH_H
+#define PRACTICEPATHTRACING_BVH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "futaba/core/aabb.h"
+#include "futaba/core/ray.h"
+#include "futaba/core/ray_packet.h"
+#include "futaba/render/hit.h"
+
+// 木の深さの上限、トラバーサルのスタックの大きさと一致させる
+const int BVH_DEPTH_MAX = 64;
+// パケットのレイのうち子ノードを辿る割合がこの分の1以下になった場合は1本ずつ辿る
+const int PACKET_FALLBACK_DIVISOR = 4;
+
+struct PrimRef {
+    PrimitiveType type;
+    uint32_t object;
+    uint32_t prim;
+};
+
+struct BVHNode {
+    AABB bounds;
+    // 葉の場合はprimsの先頭のインデックス、内部ノードの場合は右の子のインデックス
+    uint32_t offset;
+    // 葉に含まれるプリミティブの数、内部ノードの場合は0
+    uint32_t count;
+};
+
+class BVH {
+public:
+    /*
+     * refsとboundsは同じ順で対応させる
+     * 構築中に並べ替えるため値で受け取る(呼び出し元で不要であればstd::moveで渡すと複製しない)
+     * 既存の木は破棄して構築し直す
+     */
+    void build(std::vector<PrimRef> refs, std::vector<AABB> bounds);
+
+    /*
+     * 構築済みの配列を複製せずに参照する、ownerは配列の所有者
+     * 配列の内容は検証しないため、呼び出し側で確認する
+     */
+    void attach(const BVHNode *_nodes, size_t _node_count, const PrimRef *_prims, size_t _prim_count,
+                std::shared_ptr<const void> _owner);
+
+    bool empty() const {
+        return n_nodes == 0;
+    }
+
+    const BVHNode *nodes() const {
+        return node_data;
+    }
+
+    size_t node_count() const {
+        return n_nodes;
+    }
+
+    const PrimRef *prims() const {
+        return prim_data;
+    }
+
+    size_t prim_count() const {
+        return n_prims;
+    }
+
+    /*
+     * レイと交差する葉のプリミティブ毎にintersect(const PrimRef &, float &t_max)を呼び出す
+     * intersectは衝突した場合にt_maxを衝突距離に更新してtrueを返す
+     * 近い方の子から辿り、t_maxより遠いノードは枝刈りする
+     */
+    template<typename F>
+    bool traverse(const Ray &ray, float t_max, F &&intersect) const {
+        if (empty())
+            return false;
+        Vec3 inv_direction(1.0f / ray.direction.x(), 1.0f / ray.direction.y(), 1.0f / ray.direction.z());
+        float t_enter;
+        if (!node_data[0].bounds.is_hittable(ray.origin, inv_direction, HIT_DISTANCE_MIN, t_max, t_enter))
+            return false;
+        return traverse_from(0, ray.origin, inv_direction, t_max, intersect);
+    }
+
+    /*
+     * パケットの有効なレイについてtraverseと同じ判定をまとめて行う
+     * intersect(const PrimRef &, uint32_t lanes)は葉のプリミティブ毎に葉に入るレーンのマスクを渡して呼び出す
+     * intersectは衝突したレーンのpacket.t_maxを衝突距離に更新し、衝突したレーンのマスクを返す
+     * 各ノードのボックスはパケットの全てのレイとまとめて判定し、区間演算でどのレイも衝突し得ないノードを除く
+     * 子ノードを辿るレイがPACKET_FALLBACK_DIVISOR分の1以下に減った場合は、残りのレイをその子から1本ずつ辿る
+     * 戻り値は衝突したレーンのマスク
+     */
+    template<int N, typename F>
+    uint32_t traverse_packet(RayPacket<N> &packet, F &&intersect) const {
+        if (empty())
+            return 0;
+        const BVHNode *nodes = node_data;
+        const PrimRef *prims = prim_data;
+
+        alignas(16) float t_left[N];
+        alignas(16) float t_right[N];
+        uint32_t is_hit = 0;
+        uint32_t active = packet.culled(nodes[0].bounds, HIT_DISTANCE_MIN)
+                          ? 0 : packet.hit_mask(nodes[0].bounds, HIT_DISTANCE_MIN, packet.valid, t_left);
+
+        // 後回しにしたノード、そのノードに入るレーンのマスクと各レーンの入る距離
+        uint32_t stack[BVH_DEPTH_MAX];
+        uint32_t stack_mask[BVH_DEPTH_MAX];
+        alignas(16) float stack_t[BVH_DEPTH_MAX][N];
+        int stack_size = 0;
+        uint32_t index = 0;
+        for (;;) {
+            if (active != 0 && popcount(active) * PACKET_FALLBACK_DIVISOR <= N) {
+                // レイが分散したため1本ずつ辿る
+                for (int lane = 0; lane < N; lane++) {
+                    if (!(active >> static_cast<uint32_t>(lane) & 1u))
+                        continue;
+                    // t_maxはpacket.t_max[lane]を指すため、intersectによる更新がそのまま反映される
+                    uint32_t bit = 1u << static_cast<uint32_t>(lane);
+                    if (traverse_from(index, packet.lane_origin(lane), packet.lane_inv_direction(lane),
+                                      packet.t_max[lane], [&](const PrimRef &ref, float &) {
+                                return intersect(ref, bit) != 0;
+                            }))
+                        is_hit |= 1u << static_cast<uint32_t>(lane);
+                }
+                active = 0;
+            }
+            if (active != 0) {
+                const BVHNode &node = nodes[index];
+                if (node.count > 0) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                        is_hit |= intersect(prims[i], active);
+                } else {
+                    uint32_t left = index + 1;
+                    uint32_t right = node.offset;
+                    uint32_t hit_left = packet.culled(nodes[left].bounds, HIT_DISTANCE_MIN)
+                                        ? 0 : packet.hit_mask(nodes[left].bounds, HIT_DISTANCE_MIN, active, t_left);
+                    uint32_t hit_right = packet.culled(nodes[right].bounds, HIT_DISTANCE_MIN)
+                                         ? 0 : packet.hit_mask(nodes[right].bounds, HIT_DISTANCE_MIN, active, t_right);
+                    if (hit_left != 0 && hit_right != 0) {
+                        // 両方に入る最初のレーンから見て遠い方の子を後回しにする
+                        int lane = lowest_lane(hit_left & hit_right ? hit_left & hit_right : hit_left);
+                        bool left_first = !(hit_right >> static_cast<uint32_t>(lane) & 1u) ||
+                                          t_left[lane] <= t_right[lane];
+                        std::copy(left_first ? t_right : t_left, (left_first ? t_right : t_left) + N,
+                                  stack_t[stack_size]);
+                        stack[stack_size] = left_first ? right : left;
+                        stack_mask[stack_size++] = left_first ? hit_right : hit_left;
+                        index = left_first ? left : right;
+                        active = left_first ? hit_left : hit_right;
+                        continue;
+                    }
+                    if (hit_left != 0 || hit_right != 0) {
+                        index = hit_left != 0 ? left : right;
+                        active = hit_left != 0 ? hit_left : hit_right;
+                        continue;
+                    }
+                }
+            }
+            // 後回しにした間により近い衝突が見つかったレーンは除く
+            do {
+                if (stack_size == 0)
+                    return is_hit;
+                stack_size--;
+                index = stack[stack_size];
+                active = packet.closer_mask(stack_t[stack_size], stack_mask[stack_size]);
+            } while (active == 0);
+        }
+    }
+
+private:
+    std::shared_ptr<const void> owner;
+    const BVHNode *node_data = nullptr;
+    size_t n_nodes = 0;
+    const PrimRef *prim_data = nullptr;
+    size_t n_prims = 0;
+
+    /*
+     * ボックスと衝突することを確認済みのノードrootから辿る
+     * intersectで更新したt_maxは呼び出し元に返す
+     */
+    template<typename F>
+    bool traverse_from(uint32_t root, const Vec3 &origin, const Vec3 &inv_direction, float &t_max,
+                       F &&intersect) const {
+        const BVHNode *nodes = node_data;
+        const PrimRef *prims = prim_data;
+        bool is_hit = false;
+
+        // 後回しにしたノードとそのノードに入る距離
+        uint32_t stack[BVH_DEPTH_MAX];
+        float stack_t[BVH_DEPTH_MAX];
+        int stack_size = 0;
+        uint32_t index = root;
+        for (;;) {
+            const BVHNode &node = nodes[index];
+            if (node.count > 0) {
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                    if (intersect(prims[i], t_max))
+                        is_hit = true;
+                }
+            } else {
+                uint32_t left = index + 1;
+                uint32_t right = node.offset;
+                float t_left, t_right;
+                bool hit_left = nodes[left].bounds.is_hittable(origin, inv_direction, HIT_DISTANCE_MIN, t_max, t_left);
+                bool hit_right = nodes[right].bounds.is_hittable(origin, inv_direction, HIT_DISTANCE_MIN, t_max,
+                                                                 t_right);
+                if (hit_left && hit_right) {
+                    // 遠い方の子を後回しにする
+                    if (t_left <= t_right) {
+                        stack_t[stack_size] = t_right;
+                        stack[stack_size++] = right;
+                        index = left;
+                    } else {
+                        stack_t[stack_size] = t_left;
+                        stack[stack_size++] = left;
+                        index = right;
+                    }
+                    continue;
+                }
+                if (hit_left || hit_right) {
+                    index = hit_left ? left : right;
+                    continue;
+                }
+            }
+            // 後回しにした間により近い衝突が見つかったノードは辿らない
+            do {
+                if (stack_size == 0)
+                    return is_hit;
+                stack_size--;
+            } while (stack_t[stack_size] > t_max);
+            index = stack[stack_size];
+        }
+    }
+
+    static int popcount(uint32_t v) {
+        int n = 0;
+        for (; v != 0; v &= v - 1)
+            n++;
+        return n;
+    }
+
+    static int lowest_lane(uint32_t v) {
+        int lane = 0;
+        while (!(v >> static_cast<uint32_t>(lane) & 1u))
+            lane++;
+        return lane;
+    }
+
+    static uint32_t build_recursive(std::vector<BVHNode> &nodes, std::vector<PrimRef> &refs, std::vector<AABB> &bounds,
+                                    std::vector<Vec3> &centroids, uint32_t begin, uint32_t end, int depth);
+};
+
+#endif //PRACTICEPATHTRACING_BVH_H
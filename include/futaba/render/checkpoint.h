@@ -0,0 +1,37 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 漸進的なレンダリングのチェックポイント
+ *
+ * 保存する内容:
+ *  Framebufferの全タイル(BeautyとAlbedoの平均、AOV_SAMPLE_COUNTの画素毎のサンプル数、幾何情報のAOV)
+ *  Samplerの状態(シードと1パスあたりのサンプル数、完了したパス数)
+ * Samplerの乱数は(シード, 画素, サンプル番号)のみで決まるため、上記から中断した位置の乱数列を正確に復元できる
+ *
+ * ファイル形式:
+ *  gzipで圧縮したヘッダ("FTBCKPT1", CheckpointHeader)とFramebufferの領域
+ *  保存中に強制終了しても直前のチェックポイントが壊れないよう、一時ファイルに書き込んでからrenameする
+ */
+
+#ifndef PRACTICEPATHTRACING_CHECKPOINT_H
+#define PRACTICEPATHTRACING_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include "futaba/core/framebuffer.h"
+
+struct RenderState {
+    uint64_t seed;
+    int spp;
+    int passes;
+};
+
+void save_checkpoint(const std::string &path, const Framebuffer &fb, const RenderState &state);
+
+/*
+ * チェックポイントが存在しない場合はfalseを返す
+ * Framebufferの解像度やAOVなどの構成が一致しない場合は例外を送出する
+ */
+bool load_checkpoint(const std::string &path, Framebuffer &fb, RenderState &state);
+
+#endif //PRACTICEPATHTRACING_CHECKPOINT_H
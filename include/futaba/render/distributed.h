@@ -0,0 +1,92 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 複数プロセスによるタイル単位の分散レンダリング
+ *
+ * コーディネータ:
+ *  Framebufferを保持し、ワーカからの要求に応じて未処理のタイルを1つずつ割り当てる
+ *  ワーカから返されたタイルの浮動小数点データをFramebufferの該当タイルにそのままコピーする
+ *  タイルはワーカが要求した時点で割り当てる(pull型)ため、速いワーカほど多くのタイルを処理する
+ *  ワーカとの接続が切断された場合や、tile_timeout秒以内に結果が返らない場合はそのワーカを切り離し、
+ *  処理中だったタイルを再び未処理のタイルに戻す
+ *
+ * ワーカ:
+ *  シーン(AggregateとCamera)を一度だけ構築してからコーディネータに接続する
+ *  フレームの設定を受け取った後はタイルの要求とレンダリングを繰り返す
+ *  スレッド毎に接続を張り、各スレッドが1タイルずつ並行してレンダリングする
+ *  (コーディネータからは接続毎に別のワーカに見えるため、プロトコルは1接続1タイルのまま)
+ *  Framebufferは無名の領域に割り当てるため、実際に物理メモリを消費するのは担当したタイルのみ
+ *
+ * プロトコル(Socketのメッセージのtype):
+ *  W->C DIST_HELLO                  接続開始
+ *  C->W DIST_FRAME   FrameSettings  フレームの設定
+ *  W->C DIST_REQUEST                タイルの要求
+ *  C->W DIST_TILE    tile(uint32)   割り当てたタイルの番号
+ *  C->W DIST_DONE                   全てのタイルが完了した
+ *  W->C DIST_RESULT  tile(uint32), float[tile_floats]  次のタイルの要求を兼ねる
+ */
+
+#ifndef PRACTICEPATHTRACING_DISTRIBUTED_H
+#define PRACTICEPATHTRACING_DISTRIBUTED_H
+
+#include <cstdint>
+#include <string>
+#include "futaba/core/framebuffer.h"
+#include "futaba/render/aggregate.h"
+#include "futaba/render/camera.h"
+#include "futaba/render/renderer.h"
+
+enum DistMessageType : uint32_t {
+    DIST_HELLO = 1,
+    DIST_FRAME,
+    DIST_REQUEST,
+    DIST_TILE,
+    DIST_DONE,
+    DIST_RESULT
+};
+
+struct FrameSettings {
+    uint32_t width;
+    uint32_t height;
+    uint32_t aov_mask;
+    uint32_t tile_size;
+    uint32_t spp;
+    uint32_t passes;
+    uint64_t seed;
+    // Renderer::pixel_orderとPathIntegratorの設定(environmentとcacheは送れないため対象外)
+    uint32_t pixel_order;
+    uint32_t mode;
+    uint32_t max_depth;
+    uint32_t roulette_depth;
+    float roulette;
+    float background[3];
+    uint32_t packet_size;
+    uint32_t ray_order;
+    uint32_t ray_order_bits;
+};
+
+class TileCoordinator {
+public:
+    std::string address;
+    // 0以下の場合はタイムアウトしない
+    double tile_timeout;
+
+    explicit TileCoordinator(std::string _address, double _tile_timeout = 0.0) :
+            address(std::move(_address)), tile_timeout(_tile_timeout) {};
+
+    /*
+     * 全てのタイルが揃うまでワーカを受け付けてfbに結果を集める
+     * 各タイルはrendererの設定でpassesパス分レンダリングされる
+     * ワーカに送れない設定(integratorのenvironmentとcache)がある場合は例外を送出する
+     */
+    void run(Framebuffer &fb, const Renderer &renderer, int passes) const;
+};
+
+/*
+ * ワーカとしてコーディネータに接続し、DIST_DONEを受信するまでタイルをレンダリングする
+ * threads個(0の場合はハードウェアの並列数)の接続を並行して処理し、シーンは全ての接続で共有する
+ * 戻り値はレンダリングしたタイルの数
+ */
+int run_tile_worker(const std::string &address, const Aggregate &aggregate, const Camera &camera, int threads = 0);
+
+#endif //PRACTICEPATHTRACING_DISTRIBUTED_H
@@ -0,0 +1,65 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * HDR画像による環境光
+ *
+ * 画像は正距円筒図法(緯度経度)とし、画像の上端を+y方向、uが1周する方向を経度とする
+ * 屋外のシーンでは太陽などの小さく明るい領域が照明の大半を占めるため、一様な方向のサンプリングでは収束が遅い
+ * 各画素の輝度に立体角の補正(sinθ)を掛けた分布を行の周辺分布と行毎の条件付き分布に分け、
+ * それぞれをAliasTableとして構築しておくことで、明るい方向をO(1)でサンプリングする
+ */
+
+#ifndef PRACTICEPATHTRACING_ENVIRONMENT_H
+#define PRACTICEPATHTRACING_ENVIRONMENT_H
+
+#include <string>
+#include <vector>
+#include "futaba/core/alias_table.h"
+#include "futaba/core/sampler.h"
+#include "futaba/core/vec3.h"
+
+class EnvironmentLight {
+public:
+    // 放射輝度に掛ける倍率
+    float scale;
+
+    // stbで読み込める画像(.hdrなど)から構築する
+    explicit EnvironmentLight(const std::string &path, float _scale = 1.0f);
+
+    // 行優先のRGBの配列から構築する
+    EnvironmentLight(int _width, int _height, std::vector<float> _rgb, float _scale = 1.0f);
+
+    int width() const {
+        return w;
+    }
+
+    int height() const {
+        return h;
+    }
+
+    // 方向directionから届く放射輝度
+    Vec3 eval(const Vec3 &direction) const;
+
+    /*
+     * 輝度に比例する分布で方向wiをサンプリングし、その方向の放射輝度を返す
+     * pdfは立体角に関する確率密度
+     */
+    Vec3 sample(Sampler &sampler, Vec3 &wi, float &pdf) const;
+
+    // sampleで方向directionが選ばれる立体角に関する確率密度
+    float pdf(const Vec3 &direction) const;
+
+private:
+    int w;
+    int h;
+    std::vector<float> rgb;
+    AliasTable rows;
+    std::vector<AliasTable> columns;
+
+    void build();
+
+    // 方向に対応する画素と、その緯度のsinθ
+    void pixel_of(const Vec3 &direction, int &x, int &y, float &sin_theta) const;
+};
+
+#endif //PRACTICEPATHTRACING_ENVIRONMENT_H
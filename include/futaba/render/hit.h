@@ -10,17 +10,50 @@
 #include "futaba/core/config.h"
 #include "futaba/core/ray.h"
 #include "futaba/core/vec3.h"
+#include "futaba/render/material.h"
 
-class Sphere;
+#include <cstdint>
+
+/*
+ * Aggregateが保持するプリミティブの種類
+ * 衝突したオブジェクトは(種類, 種類毎のインデックス, オブジェクト内のプリミティブ番号)で識別する
+ */
+enum PrimitiveType : uint32_t {
+    PRIM_SPHERE = 0,
+    PRIM_TRIANGLE,
+    PRIM_SPHERE_CLOUD,
+    PRIM_INSTANCE
+};
 
 class HitRecord {
 public:
     Vec3 hit_pos;
     Vec3 hit_normal;
-    const Sphere *hit_object;
+    PrimitiveType hit_type;
+    // Aggregate内でのオブジェクトのインデックス(ObjectIdのAOVに利用)
+    int hit_id;
+    // オブジェクト内のプリミティブ番号(Meshの三角形の番号、SphereCloudの球の番号、Sphereでは常に0)
+    // Instanceの場合はプロトタイプ内で衝突したプリミティブの番号
+    uint32_t hit_prim;
+    // 三角形の重心座標(b1, b2)、頂点属性の補間に利用する
+    float hit_u;
+    float hit_v;
+    /*
+     * テクスチャ座標(u, v)の1単位に対応するワールド空間での長さの目安
+     * テクスチャのMIPレベルの選択に利用する(球は経線の長さ、三角形は面積の2倍の平方根)
+     */
+    float hit_uv_extent;
+    // 衝突したプリミティブの材質(Aggregate::materialsの番号)
+    MaterialId hit_material;
     float t;
 
     HitRecord() {
+        hit_type = PRIM_SPHERE;
+        hit_id = -1;
+        hit_prim = 0;
+        hit_u = hit_v = 0.0f;
+        hit_uv_extent = 1.0f;
+        hit_material = 0;
         t = HIT_DISTANCE_MAX;
     }
 };
@@ -0,0 +1,59 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * インスタンス
+ * 共有するAggregate(プロトタイプ)とアフィン変換の組
+ *
+ * 同じ形状を何度も配置する場合に形状を複製せず、プロトタイプのBVHを全てのインスタンスで共有する
+ * Aggregateの上位のBVHにはインスタンスの変換後の範囲のみを登録し、
+ * トラバーサル中にインスタンスに到達した時点でレイをプロトタイプの座標系に変換して下位のBVHを辿る(2階層のBVH)
+ * そのためメモリ消費量はインスタンスの数ではなく固有の形状の量に比例する
+ *
+ * プロトタイプは予めAggregate::buildで構築しておく
+ * プロトタイプ内のプリミティブの材質の番号は、プロトタイプではなくレンダリングするAggregateのmaterialsの番号として扱う
+ * プロトタイプがインスタンスを含むことで多段にしてもよい
+ */
+
+#ifndef PRACTICEPATHTRACING_INSTANCE_H
+#define PRACTICEPATHTRACING_INSTANCE_H
+
+#include <memory>
+#include "futaba/core/aabb.h"
+#include "futaba/core/ray.h"
+#include "futaba/core/transform.h"
+#include "futaba/render/hit.h"
+
+class Aggregate;
+
+class Instance {
+public:
+    std::shared_ptr<const Aggregate> prototype;
+    // プロトタイプの座標系からワールド座標系への変換とその逆変換
+    Transform to_world;
+    Transform to_local;
+
+    Instance(std::shared_ptr<const Aggregate> _prototype, const Transform &_to_world);
+
+    // Aggregateに登録するプリミティブの数
+    size_t primitive_count() const {
+        return 1;
+    }
+
+    AABB bounds() const;
+
+    AABB bounds(uint32_t) const {
+        return bounds();
+    }
+
+    bool is_hittable(uint32_t, Ray &ray, HitRecord &hit_record) const {
+        return is_hittable(ray, hit_record);
+    }
+
+    /*
+     * レイをプロトタイプの座標系に変換して衝突判定を行い、結果をワールド座標系に戻す
+     * hit_recordのhit_primにはプロトタイプ内のプリミティブ番号が入る
+     */
+    bool is_hittable(Ray &ray, HitRecord &hit_record) const;
+};
+
+#endif //PRACTICEPATHTRACING_INSTANCE_H
@@ -0,0 +1,157 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * パストレーシングの積分器
+ *
+ * 経路は1本ずつ最後まで追跡せず、まとめて1反射ずつ進める
+ *  1. 生存している全ての経路の衝突判定を行う
+ *  2. 衝突した経路を材質の番号順に並べ替える
+ *  3. 同じ材質の経路の連続した区間毎に、材質の種類に応じた散乱の処理をまとめて行う
+ * 同じ材質の経路を続けて処理するため、MaterialTableの参照はキャッシュに載った同じ要素の繰り返しとなり、
+ * 材質の種類による分岐も経路毎ではなく区間毎に1回となる
+ *
+ * 経路の長さはmax_depthで打ち切り、roulette_depth以降の反射ではrouletteの確率で経路を継続する(ロシアンルーレット)
+ * 何にも衝突しなかった経路はbackgroundの放射輝度を受け取る
+ *
+ * environmentを設定した場合はbackgroundの代わりに環境光を用いる
+ * 光源の扱いはmodeで切り替える
+ *  INTEGRATOR_BSDF  散乱の方向のみをサンプリングし、経路が光源や環境光に到達した場合に放射を加える
+ *  INTEGRATOR_NEE   拡散反射の面で次のイベント推定(NEE)を行う
+ *                   環境光とAggregate::lights(ライトBVH)から光源上の点をサンプリングし、
+ *                   シャドウレイで遮蔽を判定して直接光を加える
+ *                   拡散反射の後に到達した環境光とライトBVHの光源はNEEで既に数えているため加えない
+ *  INTEGRATOR_MIS   NEEと散乱の方向のサンプリングの両方で光源の寄与を求め、パワーヒューリスティックで重み付けして加える
+ *                   小さな光源はNEEで、近くの大きな光源は散乱のサンプリングで効率良く求まる
+ * 金属と誘電体は方向がほぼ1つに定まりNEEの効果がないため、その後に到達した光源の放射はどのモードでもそのまま加える
+ * ライトBVHに登録されない発光体(Instanceのプロトタイプ内)は散乱のサンプリングでのみ寄与する
+ *
+ * cacheを設定した場合は2回目以降の拡散反射で放射輝度キャッシュ(radiance_cache.h)を参照し、
+ * 値が得られれば経路をそこで終了する
+ * 各経路は最初のPATH_CACHE_RECORDS回の拡散反射を記録し、経路の終了時にそこから先の放射輝度をキャッシュに加える
+ *
+ * packet_sizeを設定した場合は、経路の順(タイル内の画素の順)に並んだ一次レイをパケットにまとめてBVHを辿る
+ * 画素の順をHilbert順やMorton順にすると各パケットが画面上の正方形に近い範囲となり、パケットのレイはより揃う
+ *
+ * ray_orderを設定した場合は2回目以降の衝突判定の前に経路を並べ替える
+ * 拡散反射の後のレイは始点も方向もばらばらで、経路の順に追跡するとBVHの異なる枝を交互に辿りキャッシュを使い回せない
+ * 始点をシーンの範囲で量子化したMorton符号(と方向の象限)をキーにして並べ替え、
+ * 近い始点から似た方向に進むレイを続けて追跡する
+ *  RAY_ORDER_ORIGIN          始点のMorton符号のみ
+ *  RAY_ORDER_OCTANT_ORIGIN   方向の象限(各成分の符号)を上位に置き、同じ象限の中で始点のMorton符号順とする
+ * ray_order_bitsは始点の各軸の量子化のビット数で、小さいほどまとまりは粗く大きいほど細かくなる
+ * 並べ替えるのは衝突判定の順序のみで、散乱の処理の順序と結果は変わらない
+ *
+ * テクスチャのMIPレベルはレイコーンで選ぶ
+ * 各経路はレイの幅(cone_width)と単位距離あたりの広がり(cone_spread)を持ち、衝突位置での幅をfootprintとする
+ * 拡散反射と粗い金属の反射の後は、反射の広がりに合わせてcone_spreadを大きくする
+ */
+
+#ifndef PRACTICEPATHTRACING_INTEGRATOR_H
+#define PRACTICEPATHTRACING_INTEGRATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "futaba/core/config.h"
+#include "futaba/core/ray.h"
+#include "futaba/core/sampler.h"
+#include "futaba/core/vec3.h"
+#include "futaba/render/aggregate.h"
+#include "futaba/render/environment.h"
+#include "futaba/render/hit.h"
+#include "futaba/render/radiance_cache.h"
+
+// 放射輝度キャッシュに加えるために記録する拡散反射の回数
+const int PATH_CACHE_RECORDS = 2;
+
+// 並べ替えを行う経路の数の下限(少数の経路では並べ替えの費用に見合わない)
+const size_t RAY_ORDER_MIN_RAYS = 64;
+
+enum RayOrder {
+    RAY_ORDER_NONE = 0,
+    RAY_ORDER_ORIGIN,
+    RAY_ORDER_OCTANT_ORIGIN
+};
+
+// 計測用の集計、複数のスレッドのtraceから加算する
+struct TraceStats {
+    std::atomic<uint64_t> primary_rays{0};
+    std::atomic<uint64_t> secondary_rays{0};
+    // 最初の衝突判定にかかった時間の全スレッドの合計
+    std::atomic<uint64_t> primary_nanoseconds{0};
+    // 2回目以降の衝突判定(並べ替えを含む)にかかった時間の全スレッドの合計
+    std::atomic<uint64_t> secondary_nanoseconds{0};
+};
+
+enum IntegratorMode {
+    INTEGRATOR_BSDF = 0,
+    INTEGRATOR_NEE,
+    INTEGRATOR_MIS
+};
+
+// 放射輝度キャッシュに加えるために記録した拡散反射
+struct CacheRecord {
+    Vec3 position;
+    Vec3 normal;
+    // 拡散反射の前までに得ていた放射輝度
+    Vec3 radiance;
+    // 拡散反射の位置でのthroughput * albedo、終了時の放射輝度との差をこれで割った値をキャッシュに加える
+    Vec3 weight;
+};
+
+struct PathState {
+    Ray ray;
+    Sampler sampler;
+    Vec3 throughput;
+    Vec3 radiance;
+    float cone_width;
+    float cone_spread;
+    // 直前の反射でNEEを行っていない(カメラからのレイもしくは金属と誘電体の反射)
+    bool specular;
+    // 直前の拡散反射の位置、光を受ける側の法線、散乱の方向の確率密度(MISの重みに利用する)
+    Vec3 prev_pos;
+    Vec3 prev_normal;
+    float bsdf_pdf;
+    int diffuse_bounces;
+    int cache_records;
+    CacheRecord records[PATH_CACHE_RECORDS];
+
+    PathState(const Ray &_ray, const Sampler &_sampler, float _cone_spread = 0.0f) :
+            ray(_ray), sampler(_sampler), throughput(1.0f), radiance(), cone_width(0.0f),
+            cone_spread(_cone_spread), specular(true), prev_pos(), prev_normal(), bsdf_pdf(0.0f),
+            diffuse_bounces(0), cache_records(0) {};
+};
+
+class PathIntegrator {
+public:
+    int max_depth;
+    float roulette;
+    int roulette_depth;
+    Vec3 background;
+    IntegratorMode mode;
+    // 放射輝度キャッシュ、設定した場合は複数のスレッドのtraceで共有して構築と参照を行う
+    std::shared_ptr<RadianceCache> cache;
+    // 環境光、設定した場合はbackgroundを用いない
+    std::shared_ptr<const EnvironmentLight> environment;
+    // 0以外(4, 8, 16)の場合は最初の衝突判定をこの本数のパケットで行う(Aggregate::intersect_packet)
+    int packet_size = 0;
+    RayOrder ray_order = RAY_ORDER_NONE;
+    int ray_order_bits = 6;
+    // 計測用、設定した場合は各traceで最近接の衝突判定を行ったレイの数(シャドウレイを除く)と時間を加える
+    TraceStats *stats = nullptr;
+
+    explicit PathIntegrator(int _max_depth = MAX_DEPTH, float _roulette = ROULETTE, int _roulette_depth = 3,
+                            const Vec3 &_background = Vec3(1.0f), IntegratorMode _mode = INTEGRATOR_MIS) :
+            max_depth(_max_depth), roulette(_roulette), roulette_depth(_roulette_depth), background(_background),
+            mode(_mode) {};
+
+    /*
+     * pathsの全ての経路を終了するまで追跡し、各経路のradianceに結果を残す
+     * first_hitsとfirst_is_hitには各経路の最初の衝突結果を返す(AOVに利用する)
+     */
+    void trace(const Aggregate &aggregate, std::vector<PathState> &paths, std::vector<HitRecord> &first_hits,
+               std::vector<uint8_t> &first_is_hit) const;
+};
+
+#endif //PRACTICEPATHTRACING_INTEGRATOR_H
@@ -0,0 +1,119 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 発光するプリミティブの階層(ライトBVH)
+ *
+ * 光源が数千個ある場合、一様に1つ選ぶと寄与の小さい遠くの光源ばかりが選ばれ、寄与の大きい光源を稀に選んだ際にホタルが生じる
+ * LightBVHは光源を範囲(AABB)、放射の向きの範囲(方向コーン)、放射束(power)で束ねた2分木で、
+ * シェーディング点から各ノードの寄与の上限の目安(importance)を求め、根から葉まで寄与に比例する確率で子を選ぶ
+ * 選択はO(log N)で、選んだ光源の確率は同じ経路の確率の積となる
+ *
+ * 方向コーン(axis, theta_o, theta_e)はPBRT 4版の12.6節に従う
+ *  axisを中心に角度theta_oの範囲の法線を持ち、各法線からtheta_eの範囲に放射する
+ *  球と両面発光の三角形はtheta_o = π、theta_e = π / 2とする
+ * 構築は放射束、範囲の表面積、方向コーンの立体角の積をコストとするビン分割で行う
+ *
+ * 光源は構築時の形状と放射輝度を複製して保持するため、プリミティブや材質を変更した場合は構築し直す
+ * 各光源はHitRecordのhit_idとhit_primで識別し、経路が光源に衝突した際にfindで光源の番号を求める
+ */
+
+#ifndef PRACTICEPATHTRACING_LIGHT_BVH_H
+#define PRACTICEPATHTRACING_LIGHT_BVH_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "futaba/core/aabb.h"
+#include "futaba/core/sampler.h"
+#include "futaba/core/vec3.h"
+
+enum LightShape : uint32_t {
+    LIGHT_SPHERE = 0,
+    LIGHT_TRIANGLE
+};
+
+struct Light {
+    LightShape shape;
+    // 球の場合はp0が中心、radiusが半径、三角形の場合はp0, p1, p2が頂点
+    Vec3 p0;
+    Vec3 p1;
+    Vec3 p2;
+    float radius;
+    Vec3 emission;
+    // 光源のプリミティブ(HitRecordのhit_id, hit_prim)
+    int hit_id;
+    uint32_t hit_prim;
+
+    static Light sphere(const Vec3 &center, float radius, const Vec3 &emission, int hit_id, uint32_t hit_prim);
+
+    static Light triangle(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2, const Vec3 &emission, int hit_id,
+                          uint32_t hit_prim);
+
+    float area() const;
+
+    AABB bounds() const;
+
+    // 全方向への放射束(放射輝度の輝度 * 面積 * π)
+    float power() const;
+};
+
+// 光源上のサンプリングした点
+struct LightSample {
+    Vec3 position;
+    Vec3 normal;
+    Vec3 emission;
+    // 光源の選択確率を含めた、シェーディング点から見た立体角に関する確率密度
+    float pdf;
+};
+
+struct LightBVHNode {
+    AABB bounds;
+    Vec3 axis;
+    float cos_theta_o;
+    float cos_theta_e;
+    float power;
+    // 内部ノードの場合は右の子のインデックス、葉の場合は光源の番号
+    uint32_t offset;
+    uint32_t is_leaf;
+};
+
+class LightBVH {
+public:
+    std::vector<Light> lights;
+    std::vector<LightBVHNode> nodes;
+
+    void build(std::vector<Light> _lights);
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    // hit_idとhit_primに対応する光源の番号、光源でない場合は-1
+    int find(int hit_id, uint32_t hit_prim) const;
+
+    /*
+     * 位置p、法線nのシェーディング点から光源を1つ選び、その光源上の点をサンプリングする
+     * nは光を受ける側に向けた法線とする
+     * 全ての光源の寄与が0の場合はfalseを返す
+     */
+    bool sample(const Vec3 &p, const Vec3 &n, Sampler &sampler, LightSample &ls) const;
+
+    // sampleで光源lightの点xが選ばれる、立体角に関する確率密度
+    float pdf(const Vec3 &p, const Vec3 &n, int light, const Vec3 &x) const;
+
+    // sampleで光源lightが選ばれる確率
+    float pmf(const Vec3 &p, const Vec3 &n, int light) const;
+
+private:
+    // 各ノードの親、pmfで葉から根へ遡るために利用する(根は自身を指す)
+    std::vector<uint32_t> parents;
+    // 各光源の葉のノード
+    std::vector<uint32_t> leaf_of;
+    std::unordered_map<uint64_t, uint32_t> index;
+
+    uint32_t build_recursive(std::vector<uint32_t> &order, size_t begin, size_t end, uint32_t parent, int depth);
+
+    static float importance(const LightBVHNode &node, const Vec3 &p, const Vec3 &n);
+};
+
+#endif //PRACTICEPATHTRACING_LIGHT_BVH_H
@@ -0,0 +1,230 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 材質
+ *
+ * 材質はMaterialTableに種類毎の属性を配列として並べたSoA形式で保持し、各プリミティブはその番号(MaterialId)のみを持つ
+ * 材質毎のオブジェクトをヒープに確保する方法と異なり、シェーディングで参照するデータは小さな連続した配列に収まる
+ * MaterialIdは既定で16bit、CMakeのFTB_MATERIAL_ID_32を有効にした場合は32bitとする
+ *
+ * 材質の種類:
+ *  MAT_DIFFUSE     完全拡散反射(albedo)
+ *  MAT_METAL       鏡面反射、roughnessで反射方向をぼかす(albedo, roughness)
+ *  MAT_DIELECTRIC  ガラスなどの屈折物体、反射と屈折をフレネル項(Schlickの近似)で選ぶ(albedo, ior)
+ *  MAT_EMISSIVE    発光のみを行い反射しない(emission)
+ *
+ * 番号0は既定の材質(albedo 0.8の拡散反射)で、材質を指定しないプリミティブはこれを利用する
+ *
+ * albedo_textureを設定した材質はalbedoにtexturesのテクスチャの値を掛ける
+ * テクスチャは画像のパスを参照するため、シーンファイルやRenderServerのシーンには含めない
+ */
+
+#ifndef PRACTICEPATHTRACING_MATERIAL_H
+#define PRACTICEPATHTRACING_MATERIAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "futaba/core/config.h"
+#include "futaba/core/sampler.h"
+#include "futaba/core/vec3.h"
+#include "futaba/render/texture.h"
+
+#ifdef FTB_MATERIAL_ID_32
+typedef uint32_t MaterialId;
+#else
+typedef uint16_t MaterialId;
+#endif
+
+// hit.hがMaterialIdを参照するため前方宣言とする
+class HitRecord;
+
+enum MaterialType : uint8_t {
+    MAT_DIFFUSE = 0,
+    MAT_METAL,
+    MAT_DIELECTRIC,
+    MAT_EMISSIVE,
+    MAT_TYPE_COUNT
+};
+
+class MaterialTable {
+public:
+    std::vector<MaterialType> type;
+    std::vector<Vec3> albedo;
+    std::vector<Vec3> emission;
+    std::vector<float> roughness;
+    std::vector<float> ior;
+    std::vector<TextureId> albedo_texture;
+    // albedo_textureが参照するテクスチャ(複数のMaterialTableで共有できる)
+    std::shared_ptr<TextureCache> textures;
+
+    MaterialTable() {
+        add_diffuse(Vec3(0.8f));
+    }
+
+    size_t size() const {
+        return type.size();
+    }
+
+    MaterialId add_diffuse(const Vec3 &_albedo) {
+        return add(MAT_DIFFUSE, _albedo, Vec3(), 0.0f, 1.0f);
+    }
+
+    MaterialId add_metal(const Vec3 &_albedo, float _roughness) {
+        return add(MAT_METAL, _albedo, Vec3(), _roughness, 1.0f);
+    }
+
+    MaterialId add_dielectric(float _ior, const Vec3 &_albedo = Vec3(1.0f)) {
+        return add(MAT_DIELECTRIC, _albedo, Vec3(), 0.0f, _ior);
+    }
+
+    MaterialId add_emissive(const Vec3 &_emission) {
+        return add(MAT_EMISSIVE, Vec3(), _emission, 0.0f, 1.0f);
+    }
+
+    void set_albedo_texture(MaterialId id, TextureId texture) {
+        if (id >= size())
+            throw std::runtime_error("material id out of range");
+        if (texture != NO_TEXTURE && (!textures || texture < 0 ||
+                                      static_cast<size_t>(texture) >= textures->texture_count()))
+            throw std::runtime_error("texture id out of range");
+        albedo_texture[id] = texture;
+    }
+
+    /*
+     * 衝突位置でのalbedo_textureの値(テクスチャがない場合は1)
+     * cone_widthは衝突位置でのレイの広がり(ワールド空間での幅)で、テクスチャのMIPレベルの選択に利用する
+     */
+    Vec3 texture_at(MaterialId id, const HitRecord &hit, float cone_width) const;
+
+    // 衝突位置でのalbedo
+    Vec3 albedo_at(MaterialId id, const HitRecord &hit, float cone_width) const {
+        return albedo[id] * texture_at(id, hit, cone_width);
+    }
+
+    /*
+     * 番号idの材質を置き換える
+     * idが現在の材質の数と等しい場合は末尾に追加する(シーンファイルなどから材質を順に復元する場合に利用する)
+     */
+    void set(MaterialId id, MaterialType _type, const Vec3 &_albedo, const Vec3 &_emission, float _roughness,
+             float _ior) {
+        if (id == size()) {
+            add(_type, _albedo, _emission, _roughness, _ior);
+            return;
+        }
+        if (id > size())
+            throw std::runtime_error("material id out of range");
+        type[id] = _type;
+        albedo[id] = _albedo;
+        emission[id] = _emission;
+        roughness[id] = _roughness;
+        ior[id] = _ior;
+        albedo_texture[id] = NO_TEXTURE;
+    }
+
+private:
+    MaterialId add(MaterialType _type, const Vec3 &_albedo, const Vec3 &_emission, float _roughness, float _ior) {
+        if (type.size() > static_cast<size_t>(static_cast<MaterialId>(-1)))
+            throw std::runtime_error("too many materials for MaterialId");
+        type.push_back(_type);
+        albedo.push_back(_albedo);
+        emission.push_back(_emission);
+        roughness.push_back(_roughness);
+        ior.push_back(_ior);
+        albedo_texture.push_back(NO_TEXTURE);
+        return static_cast<MaterialId>(type.size() - 1);
+    }
+};
+
+/*
+ * 衝突位置のテクスチャ座標
+ * 三角形は重心座標をそのまま用い、球は法線の経度と緯度から求める
+ */
+void surface_uv(const HitRecord &hit, float &u, float &v);
+
+/*
+ * 散乱方向のサンプリング
+ * 各関数は入射方向d(正規化済み、表面に向かう向き)と幾何法線nから次の方向を求め、
+ * 経路のスループットに掛ける重み(BSDF * cos / pdf)を返す
+ * 散乱しない(表面の下に向かった)場合はfalseを返す
+ */
+
+// nを第3軸とする正規直交基底
+inline void make_basis(const Vec3 &n, Vec3 &s, Vec3 &t) {
+    Vec3 a = std::abs(n.x()) > 0.9f ? Vec3(0.0f, 1.0f, 0.0f) : Vec3(1.0f, 0.0f, 0.0f);
+    s = unit_vec(cross(a, n));
+    t = cross(n, s);
+}
+
+// nの側の半球からcosに比例する方向をサンプリングする(pdf = cos / pi)
+inline Vec3 sample_cosine_hemisphere(const Vec3 &n, Sampler &sampler) {
+    float u1 = sampler.next();
+    float u2 = sampler.next();
+    float r = std::sqrt(u1);
+    float phi = 2.0f * PI * u2;
+    Vec3 s, t;
+    make_basis(n, s, t);
+    return unit_vec(r * std::cos(phi) * s + r * std::sin(phi) * t + std::sqrt(std::max(0.0f, 1.0f - u1)) * n);
+}
+
+inline Vec3 reflect(const Vec3 &d, const Vec3 &n) {
+    return d - 2.0f * dot(d, n) * n;
+}
+
+inline bool scatter_diffuse(const MaterialTable &table, MaterialId id, const Vec3 &d, const Vec3 &n,
+                            Sampler &sampler, Vec3 &wi, Vec3 &weight) {
+    // 裏面から当たった場合も表側として扱う
+    Vec3 ns = dot(d, n) < 0.0f ? n : -n;
+    wi = sample_cosine_hemisphere(ns, sampler);
+    // (albedo / pi) * cos / (cos / pi)
+    weight = table.albedo[id];
+    return true;
+}
+
+inline bool scatter_metal(const MaterialTable &table, MaterialId id, const Vec3 &d, const Vec3 &n,
+                          Sampler &sampler, Vec3 &wi, Vec3 &weight) {
+    Vec3 ns = dot(d, n) < 0.0f ? n : -n;
+    Vec3 r = reflect(d, ns);
+    float roughness = table.roughness[id];
+    if (roughness > 0.0f) {
+        // 単位球内の一様な点でぼかす
+        Vec3 p;
+        do {
+            p = Vec3(2.0f * sampler.next() - 1.0f, 2.0f * sampler.next() - 1.0f, 2.0f * sampler.next() - 1.0f);
+        } while (p.squared_length() >= 1.0f);
+        r = unit_vec(r + roughness * p);
+    }
+    if (dot(r, ns) <= 0.0f)
+        return false;
+    wi = r;
+    weight = table.albedo[id];
+    return true;
+}
+
+inline bool scatter_dielectric(const MaterialTable &table, MaterialId id, const Vec3 &d, const Vec3 &n,
+                               Sampler &sampler, Vec3 &wi, Vec3 &weight) {
+    bool front = dot(d, n) < 0.0f;
+    Vec3 ns = front ? n : -n;
+    float eta = front ? 1.0f / table.ior[id] : table.ior[id];
+
+    float cos_i = std::min(-dot(d, ns), 1.0f);
+    float sin2_t = eta * eta * (1.0f - cos_i * cos_i);
+    float r0 = (1.0f - eta) / (1.0f + eta);
+    r0 = r0 * r0;
+    float fresnel = r0 + (1.0f - r0) * std::pow(1.0f - cos_i, 5.0f);
+
+    // 全反射もしくはフレネル項の確率で反射する
+    if (sin2_t >= 1.0f || sampler.next() < fresnel) {
+        wi = reflect(d, ns);
+    } else {
+        float cos_t = std::sqrt(1.0f - sin2_t);
+        wi = unit_vec(eta * d + (eta * cos_i - cos_t) * ns);
+    }
+    weight = table.albedo[id];
+    return true;
+}
+
+#endif //PRACTICEPATHTRACING_MATERIAL_H
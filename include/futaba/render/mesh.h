@@ -0,0 +1,296 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * インデックス付き三角形メッシュ
+ *
+ * 三角形毎にオブジェクトを生成せず、頂点座標(x, y, zの連続した配列)と頂点インデックス(3つで1つの三角形)の
+ * 2つのバッファのみを保持する
+ * Mesh自体はバッファへのポインタとその所有者(owner)のみを持つビューで、コピーしてもバッファは複製されない
+ * バッファはvectorから生成した共有の領域か、mmapしたシーンファイルなどの外部の領域を参照する
+ * 外部の領域を参照する場合はownerにその領域の所有者を渡し、Meshが存在する間は解放されないようにする
+ * BVHには(Meshのインデックス, 三角形の番号)の組として三角形を1つずつ登録するため、Sphereと同一のBVHに入る
+ *
+ * 衝突判定はWoop, Benthin, Wald "Watertight Ray/Triangle Intersection" (JCGT 2013) による
+ * レイの方向の最大成分をz軸とするせん断変換で三角形をレイ空間に射影し、辺関数の符号で内外を判定する
+ * 隣接する三角形の共有辺上では辺関数が厳密に一致するため、辺や頂点をすり抜けるレイが発生しない
+ */
+
+#ifndef PRACTICEPATHTRACING_MESH_H
+#define PRACTICEPATHTRACING_MESH_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "futaba/core/aabb.h"
+#include "futaba/core/config.h"
+#include "futaba/core/ray.h"
+#include "futaba/core/ray_packet.h"
+#include "futaba/core/vec3.h"
+#include "futaba/render/hit.h"
+
+// パケットの各レイの水密な判定のせん断変換、軸は全てのレイで共通の場合のみ利用する
+template<int N>
+struct TriangleShear {
+    bool shared;
+    int kx;
+    int ky;
+    int kz;
+    alignas(16) float s[3][N];
+};
+
+class Mesh {
+public:
+    // 全ての三角形で共通の材質
+    MaterialId material = 0;
+
+    // vectorの所有権を共有の領域に移す
+    Mesh(std::vector<float> _positions, std::vector<uint32_t> _indices) {
+        if (_positions.size() % 3 != 0)
+            throw std::runtime_error("mesh buffer size must be a multiple of 3");
+        auto storage = std::make_shared<std::pair<std::vector<float>, std::vector<uint32_t>>>(
+                std::move(_positions), std::move(_indices));
+        init(storage->first.data(), storage->first.size() / 3, storage->second.data(), storage->second.size());
+        owner = storage;
+    };
+
+    // 外部のバッファを複製せずに参照する
+    Mesh(const float *_positions, size_t _vertex_count, const uint32_t *_indices, size_t _index_count,
+         std::shared_ptr<const void> _owner) : owner(std::move(_owner)) {
+        init(_positions, _vertex_count, _indices, _index_count);
+    };
+
+    // x0, y0, z0, x1, y1, z1, ...
+    const float *positions() const {
+        return position_data;
+    }
+
+    // 3つで1つの三角形、反時計回りを表とする
+    const uint32_t *indices() const {
+        return index_data;
+    }
+
+    size_t vertex_count() const {
+        return n_vertices;
+    }
+
+    size_t index_count() const {
+        return n_indices;
+    }
+
+    size_t triangle_count() const {
+        return n_indices / 3;
+    }
+
+    Vec3 vertex(uint32_t i) const {
+        const float *p = position_data + 3 * static_cast<size_t>(i);
+        return {p[0], p[1], p[2]};
+    }
+
+    // Aggregateに登録するプリミティブの数
+    size_t primitive_count() const {
+        return triangle_count();
+    }
+
+    AABB bounds(uint32_t tri) const {
+        AABB box;
+        for (int k = 0; k < 3; k++)
+            box.expand(vertex(index_data[3 * static_cast<size_t>(tri) + k]));
+        return box;
+    }
+
+    /*
+     * tri番目の三角形とレイの衝突判定
+     * Sphere::is_hittableと同様にHIT_DISTANCE_MIN < t < HIT_DISTANCE_MAXの場合のみ衝突とする
+     * 法線は頂点の並び順による幾何法線
+     */
+    bool is_hittable(uint32_t tri, Ray &ray, HitRecord &hit_record) const {
+        const Vec3 &d = ray.direction;
+        int kx, ky, kz;
+        shear_axes(d, kx, ky, kz);
+
+        float sx = d.elements[kx] / d.elements[kz];
+        float sy = d.elements[ky] / d.elements[kz];
+        float sz = 1.0f / d.elements[kz];
+
+        size_t base = 3 * static_cast<size_t>(tri);
+        Vec3 a = vertex(index_data[base]) - ray.origin;
+        Vec3 b = vertex(index_data[base + 1]) - ray.origin;
+        Vec3 c = vertex(index_data[base + 2]) - ray.origin;
+
+        float ax = a.elements[kx] - sx * a.elements[kz];
+        float ay = a.elements[ky] - sy * a.elements[kz];
+        float bx = b.elements[kx] - sx * b.elements[kz];
+        float by = b.elements[ky] - sy * b.elements[kz];
+        float cx = c.elements[kx] - sx * c.elements[kz];
+        float cy = c.elements[ky] - sy * c.elements[kz];
+
+        float u = cx * by - cy * bx;
+        float v = ax * cy - ay * cx;
+        float w = bx * ay - by * ax;
+
+        // 辺上では単精度の丸めで符号が決まらないため、倍精度で計算し直す
+        if (u == 0.0f || v == 0.0f || w == 0.0f) {
+            u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+            v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+            w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+        }
+
+        if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+            return false;
+
+        float det = u + v + w;
+        if (det == 0.0f)
+            return false;
+
+        float az = sz * a.elements[kz];
+        float bz = sz * b.elements[kz];
+        float cz = sz * c.elements[kz];
+        float t = (u * az + v * bz + w * cz) / det;
+        if (!(t > HIT_DISTANCE_MIN && t < HIT_DISTANCE_MAX))
+            return false;
+
+        hit_record.t = t;
+        hit_record.hit_type = PRIM_TRIANGLE;
+        hit_record.hit_prim = tri;
+        hit_record.hit_material = material;
+        hit_record.hit_u = v / det;
+        hit_record.hit_v = w / det;
+        hit_record.hit_pos = ray(t);
+        Vec3 n = cross(b - a, c - a);
+        float n_length = n.length();
+        hit_record.hit_normal = n / n_length;
+        hit_record.hit_uv_extent = std::sqrt(n_length);
+
+        return true;
+    }
+
+    // レイの方向の最大成分の軸をkzとし、残りの2軸を右手系になるように選ぶ
+    static void shear_axes(const Vec3 &d, int &kx, int &ky, int &kz) {
+        kz = std::abs(d.x()) > std::abs(d.y()) ? (std::abs(d.x()) > std::abs(d.z()) ? 0 : 2)
+                                               : (std::abs(d.y()) > std::abs(d.z()) ? 1 : 2);
+        kx = kz == 2 ? 0 : kz + 1;
+        ky = kx == 2 ? 0 : kx + 1;
+        if (d.elements[kz] < 0.0f)
+            std::swap(kx, ky);
+    }
+
+    // パケットの各レイのせん断変換を求める
+    template<int N>
+    static void shear(const RayPacket<N> &packet, TriangleShear<N> &shear) {
+        shear.shared = true;
+        for (int i = 0; i < N; i++) {
+            Vec3 d(packet.direction[0][i], packet.direction[1][i], packet.direction[2][i]);
+            int kx, ky, kz;
+            shear_axes(d, kx, ky, kz);
+            if (i == 0) {
+                shear.kx = kx;
+                shear.ky = ky;
+                shear.kz = kz;
+            } else if ((packet.valid >> static_cast<uint32_t>(i) & 1u) &&
+                       (kx != shear.kx || ky != shear.ky || kz != shear.kz)) {
+                shear.shared = false;
+            }
+            shear.s[0][i] = d.elements[kx] / d.elements[kz];
+            shear.s[1][i] = d.elements[ky] / d.elements[kz];
+            shear.s[2][i] = 1.0f / d.elements[kz];
+        }
+    }
+
+    /*
+     * パケットのlanesのレイとtri番目の三角形の判定をSSEで4本ずつ行い、衝突し得るレーンのマスクを返す
+     * 各レーンの計算はis_hittableと同じ演算の順で行うため、除いたレーンはis_hittableでも衝突しない
+     * 返したレーン(t < t_maxで衝突するレーンと、辺上で倍精度の計算が必要なレーン)は呼び出し側でis_hittableにより確定させる
+     * せん断の軸がレーン毎に異なる場合やSSEを利用できない場合はlanesをそのまま返す
+     */
+    template<int N>
+    uint32_t candidate_mask(uint32_t tri, const RayPacket<N> &packet, const TriangleShear<N> &shear,
+                            uint32_t lanes) const {
+#ifdef __SSE2__
+        if (!shear.shared)
+            return lanes;
+        size_t base = 3 * static_cast<size_t>(tri);
+        const float *pa = position_data + 3 * static_cast<size_t>(index_data[base]);
+        const float *pb = position_data + 3 * static_cast<size_t>(index_data[base + 1]);
+        const float *pc = position_data + 3 * static_cast<size_t>(index_data[base + 2]);
+        const int kx = shear.kx, ky = shear.ky, kz = shear.kz;
+        const __m128 zero = _mm_setzero_ps();
+        uint32_t mask = 0;
+        for (int g = 0; g < N; g += 4) {
+            if (((lanes >> static_cast<uint32_t>(g)) & 0xfu) == 0)
+                continue;
+            __m128 ox = _mm_load_ps(packet.origin[kx] + g);
+            __m128 oy = _mm_load_ps(packet.origin[ky] + g);
+            __m128 oz = _mm_load_ps(packet.origin[kz] + g);
+            __m128 sx = _mm_load_ps(shear.s[0] + g);
+            __m128 sy = _mm_load_ps(shear.s[1] + g);
+            __m128 sz = _mm_load_ps(shear.s[2] + g);
+
+            __m128 a_z = _mm_sub_ps(_mm_set1_ps(pa[kz]), oz);
+            __m128 b_z = _mm_sub_ps(_mm_set1_ps(pb[kz]), oz);
+            __m128 c_z = _mm_sub_ps(_mm_set1_ps(pc[kz]), oz);
+            __m128 ax = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pa[kx]), ox), _mm_mul_ps(sx, a_z));
+            __m128 ay = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pa[ky]), oy), _mm_mul_ps(sy, a_z));
+            __m128 bx = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pb[kx]), ox), _mm_mul_ps(sx, b_z));
+            __m128 by = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pb[ky]), oy), _mm_mul_ps(sy, b_z));
+            __m128 cx = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pc[kx]), ox), _mm_mul_ps(sx, c_z));
+            __m128 cy = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(pc[ky]), oy), _mm_mul_ps(sy, c_z));
+
+            __m128 u = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+            __m128 v = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+            __m128 w = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+            // 辺関数が0のレーンはis_hittableで倍精度の計算を行うため候補に残す
+            __m128 on_edge = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(u, zero), _mm_cmpeq_ps(v, zero)),
+                                       _mm_cmpeq_ps(w, zero));
+            __m128 any_negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)),
+                                            _mm_cmplt_ps(w, zero));
+            __m128 any_positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)),
+                                            _mm_cmpgt_ps(w, zero));
+            __m128 inside = _mm_andnot_ps(_mm_and_ps(any_negative, any_positive), _mm_cmpeq_ps(zero, zero));
+
+            __m128 det = _mm_add_ps(_mm_add_ps(u, v), w);
+            __m128 t_num = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, _mm_mul_ps(sz, a_z)), _mm_mul_ps(v, _mm_mul_ps(sz, b_z))),
+                                      _mm_mul_ps(w, _mm_mul_ps(sz, c_z)));
+            __m128 t = _mm_div_ps(t_num, det);
+            __m128 in_range = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(HIT_DISTANCE_MIN)),
+                                                    _mm_cmplt_ps(t, _mm_set1_ps(HIT_DISTANCE_MAX))),
+                                         _mm_cmplt_ps(t, _mm_load_ps(packet.t_max + g)));
+            __m128 hit = _mm_and_ps(_mm_and_ps(inside, _mm_cmpneq_ps(det, zero)), in_range);
+            auto candidate = static_cast<uint32_t>(_mm_movemask_ps(_mm_or_ps(on_edge, hit)));
+            mask |= candidate << static_cast<uint32_t>(g);
+        }
+        return mask & lanes;
+#else
+        (void) tri;
+        (void) packet;
+        (void) shear;
+        return lanes;
+#endif
+    }
+
+private:
+    std::shared_ptr<const void> owner;
+
+    const float *position_data = nullptr;
+    const uint32_t *index_data = nullptr;
+    size_t n_vertices = 0;
+    size_t n_indices = 0;
+
+    void init(const float *_positions, size_t _vertex_count, const uint32_t *_indices, size_t _index_count) {
+        if (_index_count % 3 != 0)
+            throw std::runtime_error("mesh buffer size must be a multiple of 3");
+        for (size_t i = 0; i < _index_count; i++) {
+            if (_indices[i] >= _vertex_count)
+                throw std::runtime_error("mesh index out of range");
+        }
+        position_data = _positions;
+        index_data = _indices;
+        n_vertices = _vertex_count;
+        n_indices = _index_count;
+    }
+};
+
+#endif //PRACTICEPATHTRACING_MESH_H
@@ -0,0 +1,52 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * プリミティブの型リスト
+ *
+ * Aggregateはプリミティブの種類毎に値を直接並べた配列を持ち、衝突判定は型リストから生成したテンプレートで呼び分ける
+ * 基底クラスの仮想関数とshared_ptrで保持する方法では、全ての衝突判定で間接呼び出しとポインタの参照が発生するため用いない
+ *
+ * プリミティブの種類を追加する場合は以下の2点のみを行う
+ *  1. PrimitiveTypesに型を追加する
+ *  2. PrimitiveType(hit.h)に型リストと同じ位置の値を追加する
+ *
+ * 各プリミティブの型は以下のメンバ関数を持つ
+ *  size_t primitive_count() const                                  BVHに登録するプリミティブの数
+ *  AABB bounds(uint32_t prim) const                                prim番目のプリミティブの範囲
+ *  bool is_hittable(uint32_t prim, Ray &ray, HitRecord &hit) const  prim番目のプリミティブとの衝突判定
+ */
+
+#ifndef PRACTICEPATHTRACING_PRIMITIVE_H
+#define PRACTICEPATHTRACING_PRIMITIVE_H
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+template<typename... Ts>
+struct TypeList {
+};
+
+// 型リスト内でのTの位置
+template<typename T, typename List>
+struct TypeIndex;
+
+template<typename T, typename... Ts>
+struct TypeIndex<T, TypeList<T, Ts...>> : std::integral_constant<size_t, 0> {
+};
+
+template<typename T, typename U, typename... Ts>
+struct TypeIndex<T, TypeList<U, Ts...>> : std::integral_constant<size_t, 1 + TypeIndex<T, TypeList<Ts...>>::value> {
+};
+
+// 型リストの各型の配列をまとめたtuple
+template<typename List>
+struct VectorTuple;
+
+template<typename... Ts>
+struct VectorTuple<TypeList<Ts...>> {
+    typedef std::tuple<std::vector<Ts>...> type;
+};
+
+#endif //PRACTICEPATHTRACING_PRIMITIVE_H
@@ -0,0 +1,83 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * ハッシュグリッドによる拡散反射面の放射輝度キャッシュ
+ *
+ * 拡散反射を何度も繰り返す経路の後半は低周波の寄与しか持たないにもかかわらず、経路の大半を占める
+ * RadianceCacheはワールド空間を一辺cell_sizeの格子に分け、格子の位置と法線の向き(主軸の6方向)毎のセルに
+ * 拡散反射面から出る放射輝度をalbedoで割った値(入射照度 / π)の平均を蓄える
+ * 積分器は1回目の拡散反射より後の拡散反射でセルを参照し、十分なサンプルがあれば経路を継続せずにその値を用いる
+ *
+ * キャッシュはレンダリング中に漸進的に構築する
+ * 経路は最初の数回の拡散反射の位置を記録しておき、経路の終了時にその位置から先で得た放射輝度をセルに加える
+ *
+ * バイアスはcell_size(空間の解像度)とmin_samples(参照に必要なサンプル数)で調整する
+ * 参照はレイコーンの幅がcell_size以上の場合に限るため、キャッシュの誤差は画素の見込む範囲より細かい変化に留まる
+ * cell_sizeを小さくするほどバイアスは減るが、各セルのサンプルが集まりにくくなり参照される割合も減る
+ *
+ * セルはオープンアドレス法(線形探索)の固定長の表で、キーと和の更新はatomicのCASで行うためロックを持たない
+ * 表が埋まった場合は新しいセルを作らずにサンプルを捨てる
+ * 各セルの和はmax_samplesに達した時点で更新を止める(十分に収束しており、floatの和の精度の低下も防ぐ)
+ * キャッシュを共有したレンダリングの結果はスレッドの実行順に依存する
+ */
+
+#ifndef PRACTICEPATHTRACING_RADIANCE_CACHE_H
+#define PRACTICEPATHTRACING_RADIANCE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "futaba/core/vec3.h"
+
+class RadianceCache {
+public:
+    float cell_size;
+    uint32_t min_samples;
+    uint32_t max_samples;
+
+    // capacityはセルの数(2の冪に切り上げる)
+    explicit RadianceCache(float _cell_size, uint32_t _min_samples = 16, size_t capacity = 1u << 20u,
+                           uint32_t _max_samples = 1u << 16u);
+
+    RadianceCache(const RadianceCache &) = delete;
+
+    RadianceCache &operator=(const RadianceCache &) = delete;
+
+    /*
+     * 位置p、光を受ける側の法線nのセルの平均を返す
+     * セルが存在しないかサンプルがmin_samples未満の場合はfalseを返す
+     */
+    bool lookup(const Vec3 &p, const Vec3 &n, Vec3 &value) const;
+
+    // 位置p、法線nのセルにサンプルを加える
+    void add(const Vec3 &p, const Vec3 &n, const Vec3 &value);
+
+    // 全てのセルを空にする(レンダリングと並行して呼び出してはならない)
+    void clear();
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // 使用中のセルの数
+    size_t cell_count() const;
+
+private:
+    struct Cell {
+        // 0は空のセル
+        std::atomic<uint64_t> key;
+        std::atomic<uint32_t> count;
+        std::atomic<float> sum[3];
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    uint64_t cell_key(const Vec3 &p, const Vec3 &n) const;
+
+    // keyのセル、createの場合は存在しなければ作成する
+    Cell *find(uint64_t key, bool create) const;
+};
+
+#endif //PRACTICEPATHTRACING_RADIANCE_CACHE_H
@@ -0,0 +1,115 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * Rendererクラス
+ * カメラから画素毎にレイを射出しAggregateとの衝突結果をFramebufferに書き込むレンダリングドライバ
+ *
+ * 各サンプルの経路はPathIntegratorで追跡し、タイル内の全画素の経路をまとめて1反射ずつ進める
+ * Albedoと幾何情報のAOVは経路の最初の衝突結果から書き出される
+ * 画面はタイルに分割され、各スレッドは未処理のタイルを順に取得して処理する
+ * タイルの大きさを省略した場合はFramebufferのタイルと一致させ、各スレッドが連続した領域のみに書き込むようにする
+ *
+ * タイルを取得する順序(tile_order)とタイル内の画素を並べる順序(pixel_order)は走査線順、Morton順、Hilbert順から選ぶ
+ * タイル内の経路はpixel_orderの順に並べて追跡するため(積分器は同じ材質の経路をこの順に処理する)、
+ * Hilbert順では続けて追跡するレイが画面上で隣接し、BVHとジオメトリの同じ領域を参照し続ける
+ * 各サンプルの乱数は画素で決まるため、順序を変えても放射輝度キャッシュを用いない限り結果は変わらない
+ *
+ * numaを設定した場合はスレッドをNUMAのノードに固定し、タイルをtile_orderの順にノードの数の連続した範囲に分けて
+ * 各範囲をそのノードのスレッドが優先して描画する(ThreadPool::parallel_for_nodes)
+ * Framebufferを無名の領域(backing_fileに空文字列)として確保すると、各タイルのページは最初のパスで
+ * そのタイルを描画したノードに置かれ、以降のパスも同じノードが読み書きする
+ * (ヒープのFramebufferは確保したスレッドが初期化するため、全てのページがそのスレッドのノードに置かれる)
+ * BVHのノード毎の複製はAggregate::replicate_bvhで行う
+ *
+ * progressを設定した場合はタイルの完了毎に呼び出す
+ * cancelがtrueになった時点で未着手のタイルを処理せずに終了する(処理中のタイルは最後まで描画する)
+ * 中断したパスでも描画済みのタイルは画素毎のサンプル数と共に書き込まれるため、Framebufferの各画素の平均は正しい
+ */
+
+#ifndef PRACTICEPATHTRACING_RENDERER_H
+#define PRACTICEPATHTRACING_RENDERER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "futaba/core/framebuffer.h"
+#include "futaba/core/thread_pool.h"
+#include "futaba/core/traversal_order.h"
+#include "futaba/core/ray.h"
+#include "futaba/render/aggregate.h"
+#include "futaba/render/camera.h"
+#include "futaba/render/hit.h"
+#include "futaba/render/integrator.h"
+
+class Renderer {
+public:
+    // 1画素あたりのサンプル数
+    int spp;
+    // 0の場合はハードウェアの並列数を利用する(poolを指定した場合は無視する)
+    int threads;
+    // 0の場合はFramebufferのタイルの大きさを利用する
+    int tile_size;
+    // Samplerのシード
+    uint64_t seed;
+    // タイルの処理順(スレッドは並列に取得するため、近い番号のタイルが同時に処理される)
+    TraversalOrder tile_order = ORDER_SCANLINE;
+    // タイル内の画素の追跡順
+    TraversalOrder pixel_order = ORDER_SCANLINE;
+    // renderの呼び出し毎に生成するスレッドをNUMAのノードに固定する(poolを指定した場合はpoolの設定に従う)
+    bool numa = false;
+    /*
+     * 常駐させたスレッドプール
+     * 指定しない場合はrenderの呼び出し毎にスレッドを生成する
+     */
+    ThreadPool *pool;
+    PathIntegrator integrator;
+    /*
+     * タイルが完了する毎に(パス内の完了したタイル数, パス内の全タイル数)で呼び出す
+     * タイルを処理したスレッドから並行して呼び出されるため、呼び出し先で排他制御を行う
+     */
+    std::function<void(int, int)> progress;
+    // 協調的な中断の要求
+    const std::atomic<bool> *cancel = nullptr;
+
+    explicit Renderer(int _spp = 1, int _threads = 0, int _tile_size = 0, uint64_t _seed = 0,
+                      ThreadPool *_pool = nullptr) :
+            spp(_spp), threads(_threads), tile_size(_tile_size), seed(_seed), pool(_pool) {};
+
+    /*
+     * 全画素にsppサンプルずつ追加する(1パス)
+     * BeautyとAlbedoはAOV_SAMPLE_COUNTに記録された既存のサンプル数との平均として累積される
+     * 各サンプルの乱数は(seed, 画素, サンプル番号)のみで決まるため、スレッド数やタイルの処理順に依存しない
+     */
+    void render(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb) const;
+
+    bool is_cancelled() const {
+        return cancel && cancel->load(std::memory_order_relaxed);
+    }
+
+    /*
+     * passesパスに達するまで漸進的にレンダリングする
+     * checkpoint_pathを指定した場合はcheckpoint_interval秒毎と終了時にチェックポイントを保存する
+     * 既にチェックポイントが存在する場合はその状態から再開するため、中断しない場合と同一の画像が得られる
+     * cancelにより中断した場合は途中のパスを数えずに終了する
+     * 戻り値は完了したパス数
+     */
+    int render_progressive(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb, int passes,
+                           const std::string &checkpoint_path = "", double checkpoint_interval = 60.0) const;
+
+    /*
+     * [x0, x1) x [y0, y1)の矩形領域のみをレンダリングする
+     * 衝突しなかった画素も含めて領域内の全ての画素の全てのAOVを書き込む
+     */
+    void render_tile(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb,
+                     int x0, int y0, int x1, int y1) const;
+
+private:
+    /*
+     * 画素(x, y)内の(dx, dy)の位置を通るレイを生成する
+     * ピンホールカメラではセンサ上の像は上下左右が反転するため、画像の左上はセンサの右下に対応する
+     */
+    static Ray primary_ray(const Camera &camera, const Framebuffer &fb, int x, int y, float dx, float dy);
+};
+
+#endif //PRACTICEPATHTRACING_RENDERER_H
@@ -0,0 +1,119 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * mmapしてそのまま利用できるバイナリのシーンファイル
+ *
+ * テキスト形式のメッシュは読み込み時の解析に時間がかかり、解析中は文字列と配列の両方を保持するためメモリも倍になる
+ * シーンファイルは頂点座標や頂点インデックスなどの配列をメモリ上と同じ表現で格納するため、
+ * 読み込みはmmapのみで完了し、MeshとSphereCloudはファイル上の領域を複製せずに直接参照する
+ * 実際にディスクから読み込まれるのはBVHの構築やレンダリングで参照したページのみとなる
+ *
+ * 形式(全てリトルエンディアン、各配列の先頭は64バイト境界に揃える):
+ *  SceneFileHeader                         magic "FTBSCN01", version, entry_count
+ *  SceneFileEntry[entry_count]             各要素の種類と配列の位置
+ *  配列
+ *
+ *  SCENE_ENTRY_SPHERES    offset0: float[4 * count0]  (cx, cy, cz, radius)の並び
+ *                         Aggregate::spheresは材質毎に、各SphereCloudはそれぞれ1つの要素として書き出す
+ *  SCENE_ENTRY_MESH       offset0: float[3 * count0]  頂点座標
+ *                         offset1: uint32[count1]     頂点インデックス
+ *  SCENE_ENTRY_MATERIALS  offset0: SceneFileMaterial[count0]  Aggregate::materialsの全ての材質
+ *  SCENE_ENTRY_BVH        offset0: BVHNode[count0]    構築済みのBVHのノード
+ *                         offset1: PrimRef[count1]    プリミティブ(読み込み後のオブジェクトの並びに対応する)
+ *
+ * SPHERESとMESHの要素のmaterialはその要素の材質の番号
+ * MATERIALSの要素を含まないファイルは既定の材質のみを持つ
+ *
+ * BVHの要素を含むファイルは読み込み時にBVHを構築せず、ファイル上のノードをそのまま参照する
+ *
+ * 未知の種類の要素は読み飛ばすため、要素の種類を追加してもversionを上げる必要はない
+ * 既存の要素の解釈を変える場合のみversionを上げる
+ */
+
+#ifndef PRACTICEPATHTRACING_SCENE_FILE_H
+#define PRACTICEPATHTRACING_SCENE_FILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "futaba/render/aggregate.h"
+#include "futaba/render/mesh.h"
+
+const uint32_t SCENE_FILE_VERSION = 1;
+
+enum SceneEntryType : uint32_t {
+    SCENE_ENTRY_SPHERES = 1,
+    SCENE_ENTRY_MESH = 2,
+    SCENE_ENTRY_MATERIALS = 3,
+    SCENE_ENTRY_BVH = 4
+};
+
+struct SceneFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+};
+
+struct SceneFileEntry {
+    uint32_t type;
+    uint32_t material;
+    uint64_t offset0;
+    uint64_t count0;
+    uint64_t offset1;
+    uint64_t count1;
+};
+
+struct SceneFileMaterial {
+    uint32_t type;
+    float albedo[3];
+    float emission[3];
+    float roughness;
+    float ior;
+};
+
+/*
+ * aggregateの材質とSphere、Mesh、SphereCloudをシーンファイルに書き出す
+ * Instanceを含む場合は例外を送出する
+ * 一時ファイルに書き出してから置き換えるため、書き出しに失敗しても既存のファイルは壊れない
+ */
+void save_scene_file(const std::string &path, const Aggregate &aggregate);
+
+/*
+ * シーンファイルをmmapしてAggregateを構築する
+ * 球はSphereではなくSphereCloudとして読み込む
+ * MeshとSphereCloudはファイルの領域を参照し、ファイルの割り当てはそれらが全て破棄されるまで維持される
+ * BVHの要素を含む場合はそれを用い、含まない場合はBVHを構築しないため必要に応じてAggregate::buildを呼び出す
+ */
+Aggregate load_scene_file(const std::string &path);
+
+/*
+ * aggregateをシーンファイルと同じ形式でPOSIX共有メモリ(名前は"/scene"の形式)に書き出す
+ * 複数のワーカープロセスがload_shared_sceneで同じ領域を読み取り専用で割り当て、ジオメトリとBVHを1つだけ共有する
+ * aggregateを構築済み(Aggregate::build)にしておくと、各プロセスはBVHの構築も省略できる
+ * 同名の共有メモリが既に存在する場合は例外を送出する
+ * 共有メモリは割り当てたプロセスが全て終了しても残るため、不要になればremove_shared_sceneで削除する
+ */
+void save_shared_scene(const std::string &name, const Aggregate &aggregate);
+
+/*
+ * save_shared_sceneで書き出した共有メモリを割り当ててAggregateを構築する
+ * 各プロセスはライトBVHのみを構築し、それ以外は共有メモリを直接参照する
+ */
+Aggregate load_shared_scene(const std::string &name);
+
+// 共有メモリの名前を削除する(割り当て済みのプロセスは引き続き利用できる)
+void remove_shared_scene(const std::string &name);
+
+/*
+ * テキスト形式のメッシュを読み込む
+ * OBJ: vとfのみを解釈する(多角形は扇状に三角形分割する、負のインデックスにも対応する)
+ * PLY: ascii, binary_little_endian, binary_big_endianのvertex(x, y, z)とface(vertex_indices)を解釈する
+ * 形式は拡張子(.obj, .ply)で判定する
+ */
+std::shared_ptr<Mesh> import_mesh(const std::string &path);
+
+std::shared_ptr<Mesh> import_obj(const std::string &path);
+
+std::shared_ptr<Mesh> import_ply(const std::string &path);
+
+#endif //PRACTICEPATHTRACING_SCENE_FILE_H
@@ -0,0 +1,148 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 常駐型のレンダリングサーバ
+ *
+ * Pythonからジョブを実行する度にSphereからAggregateを構築すると、小さな画像では構築の方がレンダリングより遅くなる
+ * RenderServerは名前付きのシーン(Aggregate)とスレッドプールを常駐させ、
+ * ローカルのソケット経由でレンダリングや問い合わせの要求を受け付ける
+ * シーンは登録時に一度だけ構築し、レンダリングの要求毎には再構築しない
+ *
+ * 要求はクライアントの接続毎のスレッドで受け付け、レンダリング自体は共有のスレッドプールで行う
+ * 接続毎のスレッドは切り離して生成し、切断と共に終了する(runは停止時に全ての接続のスレッドの終了を待つ)
+ * acceptに失敗した場合(ファイル記述子の枯渇など)はエラーを出力して受け付けを続ける
+ * シーンはshared_ptr<const Scene>で保持するため、レンダリング中に同名のシーンが置き換えられても安全
+ *
+ * プロトコル(Socketのメッセージのtype):
+ *  SRV_PUT_SCENE   name, material_count(uint64), (type(uint32), albedo(float[3]), emission(float[3]),
+ *                  roughness, ior)[material_count],
+ *                  count(uint64), (cx, cy, cz, radius, material(uint32))[count],
+ *                  mesh_count(uint64), (vertex_count(uint64), index_count(uint64), material(uint32),
+ *                  float[3 * vertex_count], uint32[index_count])[mesh_count],
+ *                  cloud_count(uint64), (sphere_count(uint64), material(uint32), float centers[3 * sphere_count],
+ *                  float radii[sphere_count])[cloud_count]  -> SRV_OK
+ *  SRV_DROP_SCENE  name                                              -> SRV_OK
+ *  SRV_LIST        -                                                 -> SRV_OK count(uint32), name[count]
+ *  SRV_RENDER      RenderRequest, name                               -> SRV_FRAME width, height, channels(各uint32), float[]
+ *  SRV_STATS       -                                                 -> SRV_OK 統計情報の文字列
+ *  SRV_SHUTDOWN    -                                                 -> SRV_OK
+ *  失敗した場合はSRV_ERRORとエラーメッセージの文字列を返す
+ */
+
+#ifndef PRACTICEPATHTRACING_SERVER_H
+#define PRACTICEPATHTRACING_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "futaba/core/framebuffer.h"
+#include "futaba/core/socket.h"
+#include "futaba/core/thread_pool.h"
+#include "futaba/render/aggregate.h"
+
+enum ServerMessageType : uint32_t {
+    SRV_PUT_SCENE = 100,
+    SRV_DROP_SCENE,
+    SRV_LIST,
+    SRV_RENDER,
+    SRV_STATS,
+    SRV_SHUTDOWN,
+    SRV_OK,
+    SRV_FRAME,
+    SRV_ERROR
+};
+
+struct RenderRequest {
+    float cam_sensor_pos[3];
+    float cam_sight_vec[3];
+    float cam_sensor_width;
+    float cam_sensor_height;
+    float cam_sensor_dist;
+    uint32_t width;
+    uint32_t height;
+    uint32_t spp;
+    uint32_t passes;
+    uint64_t seed;
+    // 返却するAOV(AOVType)
+    uint32_t aov;
+};
+
+struct Scene {
+    Aggregate aggregate;
+};
+
+class RenderServer {
+public:
+    std::string address;
+
+    explicit RenderServer(std::string _address, int _threads = 0) :
+            address(std::move(_address)), pool(_threads) {};
+
+    // SRV_SHUTDOWNを受信するまで要求を受け付ける
+    void run();
+
+private:
+    ThreadPool pool;
+
+    std::mutex scenes_mtx;
+    std::map<std::string, std::shared_ptr<const Scene>> scenes;
+
+    std::atomic<bool> stopping{false};
+    std::mutex clients_mtx;
+    std::set<const Socket *> clients;
+    // 終了していない接続毎のスレッドの数、0になるとclients_cvで通知する
+    size_t live_clients = 0;
+    std::condition_variable clients_cv;
+
+    // 直近のレンダリング要求の処理時間(ミリ秒)、統計情報に利用する
+    std::mutex stats_mtx;
+    uint64_t render_count = 0;
+    std::vector<double> latencies;
+
+    void serve_client(Socket socket);
+
+    // 接続毎のスレッドの終了をrunに通知する
+    void finish_client();
+
+    Message handle(const Message &request);
+
+    Message render(const std::vector<uint8_t> &payload);
+
+    std::string stats();
+};
+
+/*
+ * RenderServerに接続するクライアント
+ */
+class RenderClient {
+public:
+    explicit RenderClient(const std::string &address) : socket(Socket::connect(address)) {};
+
+    void put_scene(const std::string &name, const Aggregate &aggregate);
+
+    void drop_scene(const std::string &name);
+
+    std::vector<std::string> list_scenes();
+
+    /*
+     * 行優先でチャンネルをインターリーブした浮動小数点の画像を返す
+     */
+    std::vector<float> render(const std::string &name, const RenderRequest &request, int &channels);
+
+    std::string stats();
+
+    void shutdown_server();
+
+private:
+    Socket socket;
+
+    Message call(uint32_t type, const std::vector<uint8_t> &payload);
+};
+
+#endif //PRACTICEPATHTRACING_SERVER_H
@@ -8,58 +8,93 @@
 #include <cmath>
 #include <memory>
 #include <utility>
+#include "futaba/core/aabb.h"
 #include "futaba/core/config.h"
 #include "futaba/core/ray.h"
 #include "futaba/core/vec3.h"
 #include "futaba/render/hit.h"
 
+/*
+ * 中心center、半径radiusの球とレイの衝突判定
+ * 衝突した場合はtに衝突距離を設定する
+ * SphereとSphereCloudで共有する
+ */
+inline bool intersect_sphere(const Vec3 &center, float radius, const Ray &ray, float &t) {
+    float b = dot(ray.direction, ray.origin - center);
+    float c = (ray.origin - center).squared_length() - radius * radius;
+    float D = b * b - c;
+
+    if (D < 0) {
+        return false;
+    } else {
+        // t1 <= t2
+        float t1 = -b - std::sqrt(D);
+        float t2 = -b + std::sqrt(D);
+
+        // HIT_DISTANCE_MAX < t1 < t2
+        if (t1 > HIT_DISTANCE_MAX)
+            return false;
+        // t1 < t2 < HIT_DISTANCE_MIN
+        if (t2 < HIT_DISTANCE_MIN)
+            return false;
+        // t1 < HIT_DISTANCE_MIN, HIT_DISTANCE_MAX < t2
+        if (t1 < HIT_DISTANCE_MIN & HIT_DISTANCE_MAX < t2)
+            return false;
+
+        // 衝突の結果t1もしくはt2が採用される
+        // t1が採用されるのは下の場合のみ
+        // HIT_DISTANCE_MIN < t1　< HIT_DISTANCE_MAX,  t2とHIT_DISTANCE_MAXの関係は任意
+        if (t1 > HIT_DISTANCE_MIN)
+            t = t1;
+            // t2が採用されるのは以下の場合のみ
+            // t1 < HIT_DISTANCE_MIN < t2　< HIT_DISTANCE_MAX
+        else
+            t = t2;
+
+        return true;
+    }
+}
 
 class Sphere {
 public:
     Vec3 center;
     float radius;
-    Sphere(const Vec3 &_center, float _radius) : center(_center), radius(_radius) {};
+    MaterialId material;
+
+    Sphere(const Vec3 &_center, float _radius, MaterialId _material = 0) :
+            center(_center), radius(_radius), material(_material) {};
+
+    // Aggregateに登録するプリミティブの数
+    size_t primitive_count() const {
+        return 1;
+    }
+
+    AABB bounds() const {
+        return {center - radius, center + radius};
+    }
+
+    AABB bounds(uint32_t) const {
+        return bounds();
+    }
+
+    bool is_hittable(uint32_t, Ray &ray, HitRecord &hit_record) const {
+        return is_hittable(ray, hit_record);
+    }
 
     bool is_hittable(Ray &ray, HitRecord &hit_record) const {
-        float b = dot(ray.direction, ray.origin - center);
-        float c = (ray.origin - center).squared_length() - radius * radius;
-        float D = b * b - c;
         float t;
-
-        if (D < 0) {
+        if (!intersect_sphere(center, radius, ray, t))
             return false;
-        } else {
-            // t1 <= t2
-            float t1 = -b - std::sqrt(D);
-            float t2 = -b + std::sqrt(D);
-
-            // HIT_DISTANCE_MAX < t1 < t2
-            if (t1 > HIT_DISTANCE_MAX)
-                return false;
-            // t1 < t2 < HIT_DISTANCE_MIN
-            if (t2 < HIT_DISTANCE_MIN)
-                return false;
-            // t1 < HIT_DISTANCE_MIN, HIT_DISTANCE_MAX < t2
-            if (t1 < HIT_DISTANCE_MIN & HIT_DISTANCE_MAX < t2)
-                return false;
-
-            // 衝突の結果t1もしくはt2が採用される
-            // t1が採用されるのは下の場合のみ
-            // HIT_DISTANCE_MIN < t1　< HIT_DISTANCE_MAX,  t2とHIT_DISTANCE_MAXの関係は任意
-            if (t1 > HIT_DISTANCE_MIN)
-                t = t1;
-                // t2が採用されるのは以下の場合のみ
-                // t1 < HIT_DISTANCE_MIN < t2　< HIT_DISTANCE_MAX
-            else
-                t = t2;
-
-            hit_record.t = t;
-            hit_record.hit_object = this;
-            hit_record.hit_pos = ray(t);
-            hit_record.hit_normal = unit_vec(hit_record.hit_pos - center);
-
-            return true;
-        }
+
+        hit_record.t = t;
+        hit_record.hit_type = PRIM_SPHERE;
+        hit_record.hit_prim = 0;
+        hit_record.hit_material = material;
+        hit_record.hit_uv_extent = PI * radius;
+        hit_record.hit_pos = ray(t);
+        hit_record.hit_normal = unit_vec(hit_record.hit_pos - center);
+
+        return true;
     }
 };
 
@@ -0,0 +1,111 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * 大量の球(粒子)をまとめて保持するプリミティブ
+ *
+ * Sphereを1つずつshared_ptrで生成してAggregateに追加すると、数千万個の粒子では確保と登録だけで数分かかる
+ * SphereCloudは中心座標と半径を連続した配列として保持し、球毎のオブジェクトは生成しない
+ * BVHには(SphereCloudのインデックス, 球の番号)の組として登録する
+ *
+ * SphereCloud自体は配列へのポインタとその所有者(owner)のみを持つビューで、コピーしても配列は複製されない
+ * 配列は要素間の間隔(float単位)を持つビューとして参照するため、以下のいずれの配置もそのまま扱える
+ *  中心座標と半径を別の配列に持つ場合         centers: x, y, z, x, y, z, ...(間隔3)  radii: r, r, ...(間隔1)
+ *  (x, y, z, r)を並べた配列の場合(シーンファイル) centers: 先頭(間隔4)                  radii: 先頭 + 3(間隔4)
+ *  全ての半径が等しい場合                     radii: 1つの値(間隔0)
+ *
+ * 粒子ファイルの形式(リトルエンディアン、拡張子は.ptcl):
+ *  magic "FTBPTCL1", count(uint64), float centers[3 * count], float radii[count]
+ */
+
+#ifndef PRACTICEPATHTRACING_SPHERE_CLOUD_H
+#define PRACTICEPATHTRACING_SPHERE_CLOUD_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "futaba/core/aabb.h"
+#include "futaba/core/ray.h"
+#include "futaba/core/vec3.h"
+#include "futaba/render/hit.h"
+#include "futaba/render/sphere.h"
+
+class SphereCloud {
+public:
+    // 全ての球で共通の材質
+    MaterialId material = 0;
+
+    // 外部の配列を複製せずに参照する、ownerは配列の所有者
+    SphereCloud(const float *_centers, size_t _center_stride, const float *_radii, size_t _radius_stride,
+                size_t _count, std::shared_ptr<const void> _owner) :
+            owner(std::move(_owner)), centers(_centers), radii(_radii), center_stride(_center_stride),
+            radius_stride(_radius_stride), n_spheres(_count) {};
+
+    /*
+     * 中心座標(3 * count)と半径(count)の配列から連続した配列に複製する
+     * radiiがnullptrの場合は全ての球の半径をuniform_radiusとする
+     * 複製はthreads並列で行う(0の場合はハードウェアの並列数)
+     */
+    static std::shared_ptr<SphereCloud> from_arrays(const float *_centers, const float *_radii, size_t _count,
+                                                    float uniform_radius = 1.0f, int threads = 0);
+
+    /*
+     * 粒子ファイルを読み込む
+     * ファイルの各区間を複数のスレッドから直接格納先の配列に読み込むため、中間のバッファは確保しない
+     */
+    static std::shared_ptr<SphereCloud> load(const std::string &path, int threads = 0);
+
+    // 粒子ファイルに書き出す
+    void save(const std::string &path) const;
+
+    size_t count() const {
+        return n_spheres;
+    }
+
+    Vec3 center(size_t i) const {
+        const float *c = centers + i * center_stride;
+        return {c[0], c[1], c[2]};
+    }
+
+    float radius(size_t i) const {
+        return radii[i * radius_stride];
+    }
+
+    // Aggregateに登録するプリミティブの数
+    size_t primitive_count() const {
+        return n_spheres;
+    }
+
+    AABB bounds(size_t i) const {
+        Vec3 c = center(i);
+        float r = radius(i);
+        return {c - r, c + r};
+    }
+
+    bool is_hittable(uint32_t i, const Ray &ray, HitRecord &hit_record) const {
+        Vec3 c = center(i);
+        float r = radius(i);
+        float t;
+        if (!intersect_sphere(c, r, ray, t))
+            return false;
+
+        hit_record.t = t;
+        hit_record.hit_type = PRIM_SPHERE_CLOUD;
+        hit_record.hit_prim = i;
+        hit_record.hit_material = material;
+        hit_record.hit_uv_extent = PI * r;
+        hit_record.hit_pos = ray(t);
+        hit_record.hit_normal = unit_vec(hit_record.hit_pos - c);
+        return true;
+    }
+
+private:
+    std::shared_ptr<const void> owner;
+    const float *centers;
+    const float *radii;
+    size_t center_stride;
+    size_t radius_stride;
+    size_t n_spheres;
+};
+
+#endif //PRACTICEPATHTRACING_SPHERE_CLOUD_H
@@ -0,0 +1,145 @@
+/*
+ * Created by okn-yu on 2026/10/19.
+ *
+ * タイル分割とMIPマップによるテクスチャキャッシュ
+ *
+ * 全てのテクスチャを最大解像度のまま読み込むと、大きな画像が数百枚あるシーンではメモリに収まらない
+ * TextureCacheは画像をTEXTURE_TILE_SIZE四方のタイルに分割したMIPマップとして一時ファイルに保持し、
+ * 参照されたタイルのみをメモリに読み込む
+ * 読み込んだタイルの合計がmemory_limitを超えた場合は最も長く参照されていないタイルから破棄する(LRU)
+ *
+ * 画像(stbで読み込める形式)の変換はaddを呼び出したスレッドで直ちに行う
+ * 変換中のみ画像全体を保持するが、変換後は破棄するため常駐するのはキャッシュ内のタイルのみとなる
+ * 変換は1枚ずつ行うため、memory_limitの外で一時的に必要となるのは最大の画像1枚分に限られる
+ * (レンダリング中のスレッドで変換すると複数の画像を同時に展開し、読み込みの失敗もレンダリング中に発生する)
+ *
+ * キャッシュは複数のシャードに分割し、シャード毎に排他制御とLRUを持つ
+ * タイルはshared_ptrで返すため、参照中に他のスレッドが破棄しても安全
+ * addはレンダリング前に呼び出すこと(参照と並行して呼び出してはならない)
+ *
+ * テクスチャ座標はuが右向き、vが上向きで、[0, 1)の外側は繰り返す
+ */
+
+#ifndef PRACTICEPATHTRACING_TEXTURE_H
+#define PRACTICEPATHTRACING_TEXTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "futaba/core/vec3.h"
+
+typedef int32_t TextureId;
+
+const TextureId NO_TEXTURE = -1;
+
+const int TEXTURE_TILE_SIZE = 32;
+
+class TextureCache {
+public:
+    // タイルの合計の上限(バイト)
+    size_t memory_limit;
+    // タイル化した画像を書き出す一時ファイルのディレクトリ、空の場合はTMPDIRもしくは/tmpを利用する
+    std::string tile_dir;
+
+    explicit TextureCache(size_t _memory_limit = 256u << 20u, std::string _tile_dir = "");
+
+    ~TextureCache();
+
+    TextureCache(const TextureCache &) = delete;
+
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    /*
+     * 画像を読み込んでタイル化したMIPマップに変換し、登録する
+     * 読み込みや変換に失敗した場合は例外を送出し、キャッシュは変更しない
+     */
+    TextureId add(const std::string &path);
+
+    size_t texture_count() const {
+        return textures.size();
+    }
+
+    int width(TextureId id) const;
+
+    int height(TextureId id) const;
+
+    // MIPマップのレベル数(レベル0が最大解像度)
+    int levels(TextureId id) const;
+
+    // levelの画素(x, y)、範囲外の座標は繰り返す
+    Vec3 texel(TextureId id, int level, int x, int y);
+
+    // levelをバイリニア補間で参照する
+    Vec3 bilinear(TextureId id, int level, float u, float v);
+
+    /*
+     * テクスチャ座標での大きさfootprintの領域の平均を近似する
+     * footprintに応じたMIPレベルを選び、隣接する2レベルをトライリニア補間する
+     */
+    Vec3 lookup(TextureId id, float u, float v, float footprint);
+
+    // キャッシュ内のタイルの合計(バイト)
+    size_t memory_usage() const;
+
+    uint64_t hit_count() const {
+        return hits.load();
+    }
+
+    uint64_t miss_count() const {
+        return misses.load();
+    }
+
+private:
+    struct Tile {
+        float rgb[3 * TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE];
+    };
+
+    struct Level {
+        int width;
+        int height;
+        int tiles_x;
+        int tiles_y;
+        // 一時ファイル内の先頭のタイルの位置
+        uint64_t offset;
+    };
+
+    struct Texture {
+        std::string path;
+        int width;
+        int height;
+        std::vector<Level> levels;
+        int fd = -1;
+    };
+
+    typedef std::list<std::pair<uint64_t, std::shared_ptr<const Tile>>> LruList;
+
+    struct Shard {
+        mutable std::mutex mtx;
+        // 先頭が最も新しく参照されたタイル
+        LruList lru;
+        std::unordered_map<uint64_t, LruList::iterator> index;
+        size_t memory = 0;
+    };
+
+    static const int SHARD_COUNT = 16;
+
+    std::vector<std::unique_ptr<Texture>> textures;
+    Shard shards[SHARD_COUNT];
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    Texture &texture(TextureId id) const;
+
+    // 画像を読み込んでMIPマップを生成し、タイル単位で一時ファイルに書き出す
+    void convert(Texture &tex) const;
+
+    std::shared_ptr<const Tile> tile(TextureId id, int level, int tile_x, int tile_y);
+};
+
+#endif //PRACTICEPATHTRACING_TEXTURE_H
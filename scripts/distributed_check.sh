@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Created by okn-yu on 2026/10/19.
+#
+# 分散レンダリングの動作確認
+# コーディネータとN個のワーカを起動し、レンダリングの途中でワーカを1つ強制終了させる
+# 残りのワーカが切り離されたワーカのタイルを引き継ぎ、ローカルでのレンダリングとバイト単位で一致することを確認する
+#
+# usage: distributed_check.sh [futaba [workers [width height spp passes]]]
+#
+
+set -eu
+
+FUTABA=${1:-./futaba}
+WORKERS=${2:-3}
+WIDTH=${3:-640}
+HEIGHT=${4:-360}
+SPP=${5:-32}
+PASSES=${6:-2}
+
+WORK=$(mktemp -d)
+ADDRESS="unix:$WORK/coordinator.sock"
+trap 'kill $(jobs -p) 2>/dev/null || true; rm -rf "$WORK"' EXIT
+
+"$FUTABA" render "$WORK/local.pfm" "$WIDTH" "$HEIGHT" "$SPP" "$PASSES" > /dev/null
+
+"$FUTABA" coordinator "$ADDRESS" "$WORK/distributed.pfm" "$WIDTH" "$HEIGHT" "$SPP" "$PASSES" > /dev/null &
+COORDINATOR=$!
+while [ ! -S "$WORK/coordinator.sock" ]; do
+    sleep 0.1
+done
+
+# 各ワーカは1スレッドとし、強制終了で失われるタイルを1つに限定する
+PIDS=""
+i=0
+while [ "$i" -lt "$WORKERS" ]; do
+    "$FUTABA" worker "$ADDRESS" - 1 > /dev/null &
+    PIDS="$PIDS $!"
+    i=$((i + 1))
+done
+
+sleep 1
+VICTIM=${PIDS# }
+VICTIM=${VICTIM%% *}
+kill -9 "$VICTIM"
+echo "killed worker $VICTIM"
+
+wait "$COORDINATOR"
+for pid in $PIDS; do
+    [ "$pid" = "$VICTIM" ] || wait "$pid"
+done
+
+if cmp -s "$WORK/local.pfm" "$WORK/distributed.pfm"; then
+    echo "ok: distributed render matches local render"
+else
+    echo "mismatch: distributed render differs from local render" >&2
+    exit 1
+fi
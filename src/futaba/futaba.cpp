@@ -2,17 +2,290 @@
 // Created by okn-yu on 2022/05/06.
 //
 
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include "futaba/core/framebuffer.h"
 #include "futaba/core/image.h"
+#include "futaba/core/numa.h"
+#include "futaba/core/perf_counter.h"
 #include "futaba/core/pixel.h"
 #include "futaba/core/util.h"
+#include "futaba/render/aggregate.h"
+#include "futaba/render/camera.h"
+#include "futaba/render/distributed.h"
+#include "futaba/render/environment.h"
+#include "futaba/render/renderer.h"
+#include "futaba/render/scene_file.h"
+#include "futaba/render/server.h"
 
 using namespace std;
 
-int main() {
-    std::cout << "Hello, Futaba." << std::endl;
+/*
+ * 動作確認用のシーン
+ * 分散レンダリングではコーディネータと全てのワーカが同じシーンを構築する必要がある
+ */
+static Aggregate demo_scene() {
+    Aggregate aggregate;
+    MaterialId red = aggregate.materials.add_diffuse(Vec3(0.7f, 0.2f, 0.2f));
+    MaterialId metal = aggregate.materials.add_metal(Vec3(0.8f, 0.8f, 0.9f), 0.1f);
+    MaterialId glass = aggregate.materials.add_dielectric(1.5f);
+    MaterialId light = aggregate.materials.add_emissive(Vec3(4.0f, 3.6f, 3.0f));
+
+    aggregate.add(Sphere(Vec3(0.0f, 0.0f, 5.0f), 1.0f, red));
+    aggregate.add(Sphere(Vec3(-2.2f, -0.5f, 6.0f), 0.5f, metal));
+    aggregate.add(Sphere(Vec3(2.2f, -0.3f, 4.5f), 0.7f, glass));
+    aggregate.add(Sphere(Vec3(0.0f, -101.0f, 5.0f), 100.0f));
+    // 床の上に置いた発光する四面体
+    Mesh tetra(std::vector<float>{-1.2f, -1.0f, 3.2f, -0.4f, -1.0f, 3.2f, -0.8f, -1.0f, 3.9f, -0.8f, -0.3f, 3.5f},
+               std::vector<uint32_t>{0, 2, 1, 0, 1, 3, 1, 2, 3, 2, 0, 3});
+    tetra.material = light;
+    aggregate.add(tetra);
+    aggregate.build();
+    return aggregate;
+}
+
+static PinholeCamera demo_camera() {
+    return {Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, 1.0f), 1.6f, 0.9f, 1.0f};
 }
 
+static int arg_int(int argc, char *argv[], int index, int default_value) {
+    return index < argc ? std::atoi(argv[index]) : default_value;
+}
+
+static bool has_extension(const std::string &filename, const std::string &extension) {
+    return filename.size() > extension.size() &&
+           filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
 
+// 拡張子が.pngの場合は8bitのPNG、それ以外は浮動小数点のPFMとしてBeautyを書き出す
+static void write_beauty(const Framebuffer &fb, const std::string &filename) {
+    if (has_extension(filename, ".png"))
+        fb.png_output(AOV_BEAUTY, filename);
+    else
+        fb.pfm_output(AOV_BEAUTY, filename);
+}
 
+static IntegratorMode integrator_mode(const std::string &name) {
+    if (name == "bsdf")
+        return INTEGRATOR_BSDF;
+    if (name == "nee")
+        return INTEGRATOR_NEE;
+    if (name == "mis")
+        return INTEGRATOR_MIS;
+    throw std::runtime_error("unknown integrator: " + name);
+}
+
+// ベンチマークの1つの設定の計測結果
+struct BenchResult {
+    double seconds;
+    uint64_t primary_rays;
+    uint64_t secondary_rays;
+    double primary_seconds;
+    double secondary_seconds;
+    uint64_t l1d_misses;
+    uint64_t llc_misses;
+    bool counted;
+};
+
+static Framebuffer bench_framebuffer(int width, int height, bool anonymous) {
+    uint32_t mask = aov_bit(AOV_BEAUTY) | aov_bit(AOV_SAMPLE_COUNT);
+    return anonymous ? Framebuffer(height, width, mask, "") : Framebuffer(height, width, mask);
+}
+
+/*
+ * 一度描画してページとキャッシュを温めてから3回計測し、最も速かった回の値を返す
+ * キャッシュミスはレンダリングの全体(スレッドの生成を含む)で計測する
+ * anonymousの場合はFramebufferを無名の領域として毎回確保し、ページの配置(first-touch)も計測に含める
+ */
+static BenchResult bench_render(const Aggregate &aggregate, Renderer &renderer, int width, int height,
+                                bool anonymous = false) {
+    const int repeats = 3;
+    {
+        Framebuffer warmup = bench_framebuffer(width, height, anonymous);
+        renderer.render(aggregate, demo_camera(), warmup);
+    }
+
+    BenchResult best{};
+    for (int r = 0; r < repeats; r++) {
+        Framebuffer fb = bench_framebuffer(width, height, anonymous);
+        TraceStats stats;
+        renderer.integrator.stats = &stats;
+        CacheCounter counter;
+        counter.start();
+        auto begin = std::chrono::steady_clock::now();
+        renderer.render(aggregate, demo_camera(), fb);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        counter.stop();
+        renderer.integrator.stats = nullptr;
+        if (r > 0 && seconds >= best.seconds)
+            continue;
+        best = {seconds, stats.primary_rays.load(), stats.secondary_rays.load(),
+                static_cast<double>(stats.primary_nanoseconds.load()) * 1e-9,
+                static_cast<double>(stats.secondary_nanoseconds.load()) * 1e-9, counter.l1d_misses,
+                counter.llc_misses, counter.available()};
+    }
+    return best;
+}
+
+static void bench_row(const std::string &name, const BenchResult &r) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << r.seconds * 1e3 << std::setprecision(2) << std::setw(12)
+              << static_cast<double>(r.primary_rays + r.secondary_rays) / r.seconds * 1e-6 << std::setw(14)
+              << (r.primary_seconds > 0.0 ? static_cast<double>(r.primary_rays) / r.primary_seconds * 1e-6 : 0.0)
+              << std::setw(14)
+              << (r.secondary_seconds > 0.0 ? static_cast<double>(r.secondary_rays) / r.secondary_seconds * 1e-6 : 0.0);
+    if (r.counted)
+        std::cout << std::setw(14) << r.l1d_misses << std::setw(14) << r.llc_misses;
+    else
+        std::cout << std::setw(14) << "n/a" << std::setw(14) << "n/a";
+    std::cout << std::endl;
+}
+
+/*
+ * タイルと画素の走査順、二次レイの並べ替え、一次レイのパケット、NUMAの配置毎に
+ * レンダリングの時間、レイの数、キャッシュミスを計測する
+ * Mrays/sは全レイの壁時計時間あたりの数、1st Mrays/sと2nd Mrays/sは一次レイと二次レイ(並べ替えを含む)の
+ * 衝突判定の1スレッドあたりの速度
+ * パケットの計測では隣接する画素がまとまるよう、画素の順をヒルベルト曲線の順とする
+ * NUMAの計測ではFramebufferを無名の領域とし、固定しないスレッド、ノードに固定したスレッド、
+ * 固定に加えてBVHをノード毎に複製した場合を比べ、固定しない場合に対する速度比を表示する
+ */
+static void bench(const Aggregate &aggregate, int width, int height, int spp) {
+    std::cout << std::left << std::setw(16) << "setting" << std::right << std::setw(10) << "ms"
+              << std::setw(12) << "Mrays/s" << std::setw(14) << "1st Mrays/s" << std::setw(14) << "2nd Mrays/s" << std::setw(14) << "L1D misses"
+              << std::setw(14) << "LLC misses" << std::endl;
+
+    const TraversalOrder orders[] = {ORDER_SCANLINE, ORDER_MORTON, ORDER_HILBERT};
+    for (TraversalOrder order: orders) {
+        Renderer renderer(spp);
+        renderer.tile_order = order;
+        renderer.pixel_order = order;
+        bench_row(traversal_order_name(order), bench_render(aggregate, renderer, width, height));
+    }
+
+    const RayOrder ray_orders[] = {RAY_ORDER_NONE, RAY_ORDER_ORIGIN, RAY_ORDER_OCTANT_ORIGIN};
+    const char *ray_order_names[] = {"rays:none", "rays:origin", "rays:octant"};
+    for (RayOrder order: ray_orders) {
+        Renderer renderer(spp);
+        renderer.integrator.ray_order = order;
+        bench_row(ray_order_names[order], bench_render(aggregate, renderer, width, height));
+    }
+
+    const int packet_sizes[] = {0, 4, 8, 16};
+    for (int size: packet_sizes) {
+        Renderer renderer(spp);
+        renderer.pixel_order = ORDER_HILBERT;
+        renderer.integrator.packet_size = size;
+        bench_row(size == 0 ? "packet:off" : "packet:" + std::to_string(size),
+                  bench_render(aggregate, renderer, width, height));
+    }
+
+    Renderer unpinned(spp);
+    BenchResult base = bench_render(aggregate, unpinned, width, height, true);
+    bench_row("numa:off", base);
+    Renderer pinned(spp);
+    pinned.numa = true;
+    BenchResult pinned_result = bench_render(aggregate, pinned, width, height, true);
+    bench_row("numa:pinned", pinned_result);
+    Aggregate replicated = aggregate;
+    replicated.replicate_bvh();
+    BenchResult replicated_result = bench_render(replicated, pinned, width, height, true);
+    bench_row("numa:replicated", replicated_result);
+    std::cout << "numa: " << numa_nodes().size() << " node(s), speedup vs unpinned: pinned x" << std::setprecision(2)
+              << base.seconds / pinned_result.seconds << ", replicated x"
+              << base.seconds / replicated_result.seconds << std::endl;
+}
+
+static void usage() {
+    std::cout << "usage:" << std::endl
+              << "  futaba render <output.pfm|output.png> [width height spp passes [scene [environment.hdr [integrator]]]]" << std::endl
+              << "  futaba bench [width height spp [scene]]" << std::endl
+              << "  futaba convert <output.scene> <input.obj|input.ply|input.ptcl>..." << std::endl
+              << "  futaba coordinator <address> <output.pfm|output.png> [width height spp passes [integrator]]" << std::endl
+              << "  futaba worker <address> [scene [threads]]" << std::endl
+              << "  futaba serve <address> [threads]" << std::endl
+              << "scene: - for the demo scene" << std::endl
+              << "environment.hdr: - for the constant background" << std::endl
+              << "integrator: bsdf, nee or mis (default)" << std::endl
+              << "address: unix:/path/to/socket or tcp:host:port" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "Hello, Futaba." << std::endl;
+    if (argc < 2) {
+        usage();
+        return 0;
+    }
+
+    std::string mode = argv[1];
+    try {
+        if (mode == "render" && argc >= 3) {
+            Framebuffer fb(arg_int(argc, argv, 4, 720), arg_int(argc, argv, 3, 1280), AOV_ALL);
+            Renderer renderer(arg_int(argc, argv, 5, 4));
+            Aggregate aggregate = argc >= 8 && std::string(argv[7]) != "-" ? load_scene_file(argv[7]) : demo_scene();
+            if (argc >= 9 && std::string(argv[8]) != "-")
+                renderer.integrator.environment = std::make_shared<EnvironmentLight>(argv[8]);
+            if (argc >= 10)
+                renderer.integrator.mode = integrator_mode(argv[9]);
+            // シーンファイルに構築済みのBVHが含まれている場合はそのまま利用する
+            if (!aggregate.is_built())
+                aggregate.build();
+            renderer.render_progressive(aggregate, demo_camera(), fb, arg_int(argc, argv, 6, 1));
+            write_beauty(fb, argv[2]);
+        } else if (mode == "bench") {
+            Aggregate aggregate = argc >= 6 && std::string(argv[5]) != "-" ? load_scene_file(argv[5]) : demo_scene();
+            if (!aggregate.is_built())
+                aggregate.build();
+            bench(aggregate, arg_int(argc, argv, 2, 640), arg_int(argc, argv, 3, 360), arg_int(argc, argv, 4, 4));
+        } else if (mode == "convert" && argc >= 4) {
+            Aggregate aggregate;
+            for (int i = 3; i < argc; i++) {
+                std::string input = argv[i];
+                if (has_extension(input, ".ptcl")) {
+                    auto cloud = SphereCloud::load(input);
+                    std::cout << input << ": " << cloud->count() << " spheres" << std::endl;
+                    aggregate.add(cloud);
+                    continue;
+                }
+                auto mesh = import_mesh(argv[i]);
+                std::cout << argv[i] << ": " << mesh->vertex_count() << " vertices, " << mesh->triangle_count()
+                          << " triangles" << std::endl;
+                aggregate.add(mesh);
+            }
+            // 構築したBVHも書き出し、読み込み時に構築し直さずに済むようにする
+            aggregate.build();
+            save_scene_file(argv[2], aggregate);
+        } else if (mode == "coordinator" && argc >= 4) {
+            Framebuffer fb(arg_int(argc, argv, 5, 720), arg_int(argc, argv, 4, 1280), AOV_ALL);
+            Renderer renderer(arg_int(argc, argv, 6, 4));
+            if (argc >= 9)
+                renderer.integrator.mode = integrator_mode(argv[8]);
+            TileCoordinator coordinator(argv[2], 60.0);
+            coordinator.run(fb, renderer, arg_int(argc, argv, 7, 1));
+            write_beauty(fb, argv[3]);
+        } else if (mode == "worker" && argc >= 3) {
+            // シーンは接続前に一度だけ構築し、全てのタイルで使い回す
+            Aggregate aggregate = argc >= 4 && std::string(argv[3]) != "-" ? load_scene_file(argv[3]) : demo_scene();
+            if (!aggregate.is_built())
+                aggregate.build();
+            PinholeCamera camera = demo_camera();
+            int tiles = run_tile_worker(argv[2], aggregate, camera, arg_int(argc, argv, 4, 0));
+            std::cout << "rendered " << tiles << " tiles" << std::endl;
+        } else if (mode == "serve" && argc >= 3) {
+            RenderServer server(argv[2], arg_int(argc, argv, 3, 0));
+            server.run();
+        } else {
+            usage();
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "futaba/core/config.h"
+#include "futaba/core/framebuffer.h"
+#include "futaba/core/pixel.h"
+
+const char *aov_name(AOVType aov) {
+    switch (aov) {
+        case AOV_BEAUTY:
+            return "beauty";
+        case AOV_NORMAL:
+            return "normal";
+        case AOV_DEPTH:
+            return "depth";
+        case AOV_ALBEDO:
+            return "albedo";
+        case AOV_OBJECT_ID:
+            return "object_id";
+        case AOV_SAMPLE_COUNT:
+            return "sample_count";
+        default:
+            throw std::runtime_error("invalid aov");
+    }
+}
+
+void Framebuffer::init_layout() {
+    assert(tile_size > 0);
+    tiles_x = (width + tile_size - 1) / tile_size;
+    tiles_y = (height + tile_size - 1) / tile_size;
+
+    planes = 0;
+    for (int i = 0; i < AOV_COUNT; i++) {
+        auto aov = static_cast<AOVType>(i);
+        if (has_aov(aov)) {
+            first_plane[i] = planes;
+            planes += aov_channel_count(aov);
+        } else {
+            first_plane[i] = -1;
+        }
+    }
+}
+
+Framebuffer::Framebuffer(int _height, int _width, uint32_t _aov_mask, int _tile_size) :
+        width(_width), height(_height), aov_mask((_aov_mask & AOV_ALL) | aov_bit(AOV_SAMPLE_COUNT)),
+        tile_size(_tile_size) {
+    init_layout();
+    heap.resize(tile_floats() * tiles_x * tiles_y, 0.0f);
+    base = heap.data();
+
+    /*
+     * 何にも衝突しなかった画素の初期値
+     * DepthはHitRecordの初期値と同じHIT_DISTANCE_MAX、ObjectIdは-1とする
+     */
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (has_aov(AOV_DEPTH))
+                *at(AOV_DEPTH, 0, x, y) = HIT_DISTANCE_MAX;
+            if (has_aov(AOV_OBJECT_ID))
+                *at(AOV_OBJECT_ID, 0, x, y) = -1.0f;
+        }
+    }
+}
+
+Framebuffer::Framebuffer(int _height, int _width, uint32_t _aov_mask, const std::string &backing_file,
+                         int _tile_size) :
+        width(_width), height(_height), aov_mask((_aov_mask & AOV_ALL) | aov_bit(AOV_SAMPLE_COUNT)),
+        tile_size(_tile_size) {
+    init_layout();
+    size_t size = tile_floats() * tiles_x * tiles_y * sizeof(float);
+    mapped = backing_file.empty() ? MappedFile::anonymous(size) : MappedFile::create(backing_file, size);
+    base = static_cast<float *>(mapped.data());
+}
+
+size_t Framebuffer::offset(AOVType aov, int channel, int x, int y) const {
+    if (!has_aov(aov))
+        throw std::runtime_error(std::string("aov is not enabled: ") + aov_name(aov));
+    assert(0 <= channel && channel < aov_channel_count(aov));
+    assert(0 <= x && x < width && 0 <= y && y < height);
+    size_t in_tile = static_cast<size_t>(first_plane[aov] + channel) * tile_size * tile_size
+                     + (y % tile_size) * tile_size + (x % tile_size);
+    return tile_offset(x / tile_size, y / tile_size) + in_tile;
+}
+
+void Framebuffer::write(AOVType aov, int x, int y, const Vec3 &v) {
+    for (int c = 0; c < aov_channel_count(aov); c++)
+        *at(aov, c, x, y) = v.elements[c];
+}
+
+void Framebuffer::write(AOVType aov, int x, int y, float v) {
+    assert(aov_channel_count(aov) == 1);
+    *at(aov, 0, x, y) = v;
+}
+
+Vec3 Framebuffer::read(AOVType aov, int x, int y) const {
+    if (aov_channel_count(aov) == 1)
+        return Vec3(*at(aov, 0, x, y));
+    return {*at(aov, 0, x, y), *at(aov, 1, x, y), *at(aov, 2, x, y)};
+}
+
+float Framebuffer::read_scalar(AOVType aov, int x, int y) const {
+    assert(aov_channel_count(aov) == 1);
+    return *at(aov, 0, x, y);
+}
+
+void Framebuffer::sync() const {
+    mapped.sync();
+}
+
+void Framebuffer::read_row(AOVType aov, int channel, int y, float *row) const {
+    for (int x0 = 0; x0 < width; x0 += tile_size) {
+        const float *src = at(aov, channel, x0, y);
+        std::copy(src, src + std::min(tile_size, width - x0), row + x0);
+    }
+}
+
+/*
+ * ObjectId用の色の生成
+ * 隣接するIDが似た色にならないように整数ハッシュで撹拌する
+ */
+static Color id_color(int id) {
+    if (id < 0)
+        return {};
+    auto h = static_cast<uint32_t>(id) * 2654435761u;
+    h ^= h >> 16;
+    return {static_cast<float>(h & 0xff) / 255.0f,
+            static_cast<float>((h >> 8) & 0xff) / 255.0f,
+            static_cast<float>((h >> 16) & 0xff) / 255.0f};
+}
+
+float Framebuffer::scalar_max(AOVType aov) const {
+    float result = 0.0f;
+    if (aov != AOV_DEPTH && aov != AOV_SAMPLE_COUNT)
+        return result;
+    std::vector<float> row(width);
+    for (int y = 0; y < height; y++) {
+        read_row(aov, 0, y, row.data());
+        for (float d: row) {
+            if (d < HIT_DISTANCE_MAX)
+                result = std::max(result, d);
+        }
+    }
+    return result;
+}
+
+void Framebuffer::pixel_row(AOVType aov, int y, float max_value, uint8_t *dst) const {
+    int channels = aov_channel_count(aov);
+    std::vector<float> row(static_cast<size_t>(width) * channels);
+    for (int c = 0; c < channels; c++)
+        read_row(aov, c, y, row.data() + static_cast<size_t>(c) * width);
+
+    for (int x = 0; x < width; x++) {
+        std::array<uint8_t, 3> p{};
+        switch (aov) {
+            case AOV_BEAUTY:
+            case AOV_ALBEDO:
+                p = RGBPixel(Color(row[x], row[width + x], row[2 * width + x])).data;
+                break;
+            case AOV_NORMAL:
+                p = NormalPixel(Color(row[x], row[width + x], row[2 * width + x])).data;
+                break;
+            case AOV_DEPTH: {
+                float d = row[x];
+                float g = (d < HIT_DISTANCE_MAX && max_value > 0.0f) ? 1.0f - d / max_value : 0.0f;
+                p = RGBPixel(Color(g)).data;
+                break;
+            }
+            case AOV_SAMPLE_COUNT:
+                p = RGBPixel(Color(max_value > 0.0f ? row[x] / max_value : 0.0f)).data;
+                break;
+            case AOV_OBJECT_ID:
+                p = RGBPixel(id_color(static_cast<int>(row[x]))).data;
+                break;
+            default:
+                throw std::runtime_error("invalid aov");
+        }
+        std::copy(p.begin(), p.end(), dst + x * 3);
+    }
+}
+
+Image Framebuffer::to_image(AOVType aov) const {
+    Image image(height, width);
+    float max_value = scalar_max(aov);
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; y++) {
+        pixel_row(aov, y, max_value, row.data());
+        for (int x = 0; x < width; x++)
+            std::copy(row.begin() + x * 3, row.begin() + x * 3 + 3, image.pixels[y * width + x]->data.begin());
+    }
+    return image;
+}
+
+void Framebuffer::png_output(AOVType aov, const std::string &filename, int level, int threads) const {
+    float max_value = scalar_max(aov);
+    png_write_rows(filename, width, height, 3, [this, aov, max_value](int y, uint8_t *dst) {
+        pixel_row(aov, y, max_value, dst);
+    }, level, threads);
+}
+
+static bool is_little_endian() {
+    uint32_t one = 1;
+    uint8_t head;
+    std::memcpy(&head, &one, 1);
+    return head == 1;
+}
+
+static std::ofstream open_output(const std::string &filename) {
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs)
+        throw std::runtime_error("failed to open: " + filename);
+    return ofs;
+}
+
+void Framebuffer::pfm_output(AOVType aov, const std::string &filename) const {
+    int channels = aov_channel_count(aov);
+    std::ofstream ofs = open_output(filename);
+
+    ofs << (channels == 3 ? "PF" : "Pf") << "\n"
+        << width << " " << height << "\n"
+        << (is_little_endian() ? "-1.0" : "1.0") << "\n";
+
+    // 1行分のみをインターリーブして書き出す
+    std::vector<float> channel_row(width);
+    std::vector<float> row(static_cast<size_t>(width) * channels);
+    for (int y = height - 1; y >= 0; y--) {
+        for (int c = 0; c < channels; c++) {
+            read_row(aov, c, y, channel_row.data());
+            for (int x = 0; x < width; x++)
+                row[x * channels + c] = channel_row[x];
+        }
+        ofs.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)));
+    }
+    if (!ofs)
+        throw std::runtime_error("failed to write: " + filename);
+}
+
+void Framebuffer::raw_output(const std::string &filename, uint32_t mask) const {
+    mask &= aov_mask;
+    uint32_t channels = 0;
+    for (int i = 0; i < AOV_COUNT; i++) {
+        if (mask & aov_bit(static_cast<AOVType>(i)))
+            channels += aov_channel_count(static_cast<AOVType>(i));
+    }
+
+    std::ofstream ofs = open_output(filename);
+    const uint32_t header[] = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), mask, channels};
+    ofs.write("FTBRAW01", 8);
+    ofs.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    std::vector<float> row(width);
+    for (int i = 0; i < AOV_COUNT; i++) {
+        auto aov = static_cast<AOVType>(i);
+        if (!(mask & aov_bit(aov)))
+            continue;
+        for (int c = 0; c < aov_channel_count(aov); c++) {
+            for (int y = 0; y < height; y++) {
+                read_row(aov, c, y, row.data());
+                ofs.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(width * sizeof(float)));
+            }
+        }
+    }
+    if (!ofs)
+        throw std::runtime_error("failed to write: " + filename);
+}
@@ -11,8 +11,15 @@
  * new演算子とdelete演算子を利用する必要性は基本的になく、デストラクタの実装も不要
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <thread>
 #include <vector>
+#include <zlib.h>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
@@ -52,4 +59,216 @@ void Image::png_output(const std::string &filename, int comp) const {
         }
     }
     stbi_write_png(filename.data(), width, height, comp, output.data(), width * pixel_size);
-}
\ No newline at end of file
+}
+
+/*
+ * 並列PNGエンコード
+ *
+ * stbi_write_pngは画像全体を1つのdeflateストリームとして1コアで圧縮する
+ * ここでは画像を水平方向のストリップに分割し、各ストリップを独立したraw deflateストリームとして並列に圧縮する
+ * 最後以外のストリップはZ_SYNC_FLUSHで終端することでバイト境界に揃い、単純に連結しても1つの有効なdeflateストリームになる
+ * zlibのadler32はストリップ毎に計算してadler32_combineで結合する
+ */
+
+namespace {
+    const int PNG_STRIP_BYTES = 256 * 1024;
+
+    void put_u32(std::vector<uint8_t> &buf, uint32_t v) {
+        buf.push_back(static_cast<uint8_t>(v >> 24));
+        buf.push_back(static_cast<uint8_t>(v >> 16));
+        buf.push_back(static_cast<uint8_t>(v >> 8));
+        buf.push_back(static_cast<uint8_t>(v));
+    }
+
+    void write_chunk(std::ofstream &ofs, const char *type, const uint8_t *data, size_t size) {
+        std::vector<uint8_t> head;
+        put_u32(head, static_cast<uint32_t>(size));
+        head.insert(head.end(), type, type + 4);
+        uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(type), 4);
+        if (size > 0)
+            crc = crc32(crc, data, static_cast<uInt>(size));
+        std::vector<uint8_t> tail;
+        put_u32(tail, static_cast<uint32_t>(crc));
+
+        ofs.write(reinterpret_cast<const char *>(head.data()), static_cast<std::streamsize>(head.size()));
+        ofs.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+        ofs.write(reinterpret_cast<const char *>(tail.data()), static_cast<std::streamsize>(tail.size()));
+    }
+
+    uint8_t paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc)
+            return static_cast<uint8_t>(a);
+        return static_cast<uint8_t>(pb <= pc ? b : c);
+    }
+
+    /*
+     * 1行分のフィルタ処理
+     * 5種類のフィルタを全て試し、絶対値の和が最小のものを採用する(stbと同じ経験則)
+     * store(level 0)の場合は圧縮しないためフィルタも行わない
+     */
+    void filter_row(const uint8_t *row, const uint8_t *prev, int stride, int bpp, bool adaptive, uint8_t *out) {
+        if (!adaptive) {
+            out[0] = 0;
+            std::copy(row, row + stride, out + 1);
+            return;
+        }
+        std::vector<uint8_t> trial(stride);
+        long best_sum = -1;
+        for (int type = 0; type < 5; type++) {
+            long sum = 0;
+            for (int i = 0; i < stride; i++) {
+                int a = i >= bpp ? row[i - bpp] : 0;
+                int b = prev ? prev[i] : 0;
+                int c = (prev && i >= bpp) ? prev[i - bpp] : 0;
+                int pred = 0;
+                switch (type) {
+                    case 1: pred = a; break;
+                    case 2: pred = b; break;
+                    case 3: pred = (a + b) / 2; break;
+                    case 4: pred = paeth(a, b, c); break;
+                    default: break;
+                }
+                trial[i] = static_cast<uint8_t>(row[i] - pred);
+                sum += std::abs(static_cast<int8_t>(trial[i]));
+            }
+            if (best_sum < 0 || sum < best_sum) {
+                best_sum = sum;
+                out[0] = static_cast<uint8_t>(type);
+                std::copy(trial.begin(), trial.end(), out + 1);
+            }
+        }
+    }
+}
+
+void Image::png_output_parallel(const std::string &filename, int comp, int level, int threads) const {
+
+    int pixel_size = (*pixels[0]).data.size();
+    assert(comp == pixel_size);
+
+    png_write_rows(filename, width, height, comp, [this, pixel_size](int y, uint8_t *dst) {
+        for (int x = 0; x < width; x++) {
+            const auto &p = (*pixels[y * width + x]).data;
+            std::copy(p.begin(), p.end(), dst + x * pixel_size);
+        }
+    }, level, threads);
+}
+
+void png_write_rows(const std::string &filename, int width, int height, int comp,
+                    const std::function<void(int, uint8_t *)> &row_bytes, int level, int threads) {
+
+    if (comp < 1 || 4 < comp)
+        throw std::runtime_error("invalid component count");
+    if (level < 0 || 9 < level)
+        throw std::runtime_error("invalid compression level");
+
+    int pixel_size = comp;
+    int stride = width * pixel_size;
+    int strip_rows = std::max(1, std::min(height, PNG_STRIP_BYTES / (stride + 1)));
+    int strip_count = (height + strip_rows - 1) / strip_rows;
+
+    std::vector<std::vector<uint8_t>> strips(strip_count);
+    std::vector<uLong> adlers(strip_count);
+    std::vector<uLong> lengths(strip_count);
+    std::vector<int> errors(strip_count, Z_OK);
+
+    auto compress_strip = [&](int s) {
+        int y0 = s * strip_rows;
+        int y1 = std::min(height, y0 + strip_rows);
+
+        z_stream zs{};
+        // windowBitsを負にするとzlibヘッダとadler32を持たないraw deflateになる
+        int ret = deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        if (ret != Z_OK) {
+            errors[s] = ret;
+            return;
+        }
+
+        std::vector<uint8_t> row(stride), prev(stride), filtered(stride + 1);
+        if (y0 > 0)
+            row_bytes(y0 - 1, prev.data());
+
+        auto &out = strips[s];
+        uLong adler = adler32(0L, Z_NULL, 0);
+        for (int y = y0; y < y1; y++) {
+            row_bytes(y, row.data());
+            filter_row(row.data(), y > 0 ? prev.data() : nullptr, stride, pixel_size, level > 0, filtered.data());
+            adler = adler32(adler, filtered.data(), static_cast<uInt>(filtered.size()));
+
+            int flush = y + 1 < y1 ? Z_NO_FLUSH : (y1 == height ? Z_FINISH : Z_SYNC_FLUSH);
+            zs.next_in = filtered.data();
+            zs.avail_in = static_cast<uInt>(filtered.size());
+            do {
+                uint8_t buf[16384];
+                zs.next_out = buf;
+                zs.avail_out = sizeof(buf);
+                ret = deflate(&zs, flush);
+                out.insert(out.end(), buf, buf + (sizeof(buf) - zs.avail_out));
+            } while (zs.avail_out == 0);
+            std::swap(row, prev);
+        }
+        deflateEnd(&zs);
+
+        if (ret != (y1 == height ? Z_STREAM_END : Z_OK))
+            errors[s] = ret;
+        adlers[s] = adler;
+        lengths[s] = static_cast<uLong>(y1 - y0) * (stride + 1);
+    };
+
+    int thread_count = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+    thread_count = std::max(1, std::min(thread_count, strip_count));
+
+    std::atomic<int> next_strip(0);
+    auto worker = [&]() {
+        for (int s = next_strip++; s < strip_count; s = next_strip++)
+            compress_strip(s);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < thread_count; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto &w: workers)
+        w.join();
+
+    for (int e: errors) {
+        if (e != Z_OK)
+            throw std::runtime_error("deflate failed");
+    }
+
+    uLong adler = adlers[0];
+    for (int s = 1; s < strip_count; s++)
+        adler = adler32_combine(adler, adlers[s], static_cast<z_off_t>(lengths[s]));
+
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs)
+        throw std::runtime_error("failed to open: " + filename);
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    ofs.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    // color type: 0=Gray, 4=GrayAlpha, 2=RGB, 6=RGBA
+    const uint8_t color_types[] = {0, 0, 4, 2, 6};
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, static_cast<uint32_t>(width));
+    put_u32(ihdr, static_cast<uint32_t>(height));
+    ihdr.push_back(8);
+    ihdr.push_back(color_types[comp]);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    write_chunk(ofs, "IHDR", ihdr.data(), ihdr.size());
+
+    // zlibヘッダのFLEVELは圧縮レベルの目安のみで展開には影響しない
+    const uint8_t zlib_header[] = {0x78, static_cast<uint8_t>(level <= 1 ? 0x01 : (level < 6 ? 0x5e : (level == 6 ? 0x9c : 0xda)))};
+    write_chunk(ofs, "IDAT", zlib_header, sizeof(zlib_header));
+    for (const auto &strip: strips)
+        write_chunk(ofs, "IDAT", strip.data(), strip.size());
+    std::vector<uint8_t> trailer;
+    put_u32(trailer, static_cast<uint32_t>(adler));
+    write_chunk(ofs, "IDAT", trailer.data(), trailer.size());
+
+    write_chunk(ofs, "IEND", nullptr, 0);
+    if (!ofs)
+        throw std::runtime_error("failed to write: " + filename);
+}
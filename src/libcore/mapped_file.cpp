@@ -0,0 +1,148 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "futaba/core/mapped_file.h"
+
+MappedFile MappedFile::create(const std::string &path, size_t size) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("failed to open: " + path);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        throw std::runtime_error("failed to resize: " + path);
+    }
+
+    MappedFile file;
+    if (size > 0) {
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("failed to mmap: " + path);
+        }
+        file.addr = p;
+        file.length = size;
+    }
+    // 割り当て後はファイルディスクリプタを閉じても領域は有効
+    ::close(fd);
+    return file;
+}
+
+MappedFile MappedFile::anonymous(size_t size) {
+    MappedFile file;
+    if (size > 0) {
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("failed to mmap anonymous memory");
+        file.addr = p;
+        file.length = size;
+    }
+    return file;
+}
+
+namespace {
+    // fdの全体を読み込み専用で割り当ててfdを閉じる
+    void *map_readonly(int fd, const std::string &name, size_t &size) {
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("failed to stat: " + name);
+        }
+        size = static_cast<size_t>(st.st_size);
+        void *p = nullptr;
+        if (size > 0) {
+            p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("failed to mmap: " + name);
+            }
+        }
+        ::close(fd);
+        return p;
+    }
+}
+
+MappedFile MappedFile::open_readonly(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open: " + path);
+    MappedFile file;
+    file.addr = map_readonly(fd, path, file.length);
+    return file;
+}
+
+MappedFile MappedFile::create_shared(const std::string &name, size_t size) {
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        throw std::runtime_error("failed to create shared memory: " + name);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("failed to resize shared memory: " + name);
+    }
+
+    MappedFile file;
+    if (size > 0) {
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("failed to mmap shared memory: " + name);
+        }
+        file.addr = p;
+        file.length = size;
+    }
+    ::close(fd);
+    return file;
+}
+
+MappedFile MappedFile::open_shared_readonly(const std::string &name) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw std::runtime_error("failed to open shared memory: " + name);
+    MappedFile file;
+    file.addr = map_readonly(fd, name, file.length);
+    return file;
+}
+
+void MappedFile::unlink_shared(const std::string &name) {
+    if (::shm_unlink(name.c_str()) != 0)
+        throw std::runtime_error("failed to unlink shared memory: " + name);
+}
+
+MappedFile::MappedFile(MappedFile &&src) noexcept: addr(src.addr), length(src.length) {
+    src.addr = nullptr;
+    src.length = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&src) noexcept {
+    if (this != &src) {
+        unmap();
+        addr = src.addr;
+        length = src.length;
+        src.addr = nullptr;
+        src.length = 0;
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::sync() const {
+    if (addr && ::msync(addr, length, MS_SYNC) != 0)
+        throw std::runtime_error("failed to msync");
+}
+
+void MappedFile::unmap() {
+    if (addr)
+        ::munmap(addr, length);
+    addr = nullptr;
+    length = 0;
+}
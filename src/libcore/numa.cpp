@@ -0,0 +1,134 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "futaba/core/numa.h"
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#endif
+
+namespace {
+    // pin_thread_to_nodeで固定したノードの位置(固定していない場合は-1)
+    thread_local int pinned_node = -1;
+
+    std::vector<NumaNode> single_node() {
+        NumaNode node{0, {}};
+        int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < count; cpu++)
+            node.cpus.push_back(cpu);
+        return {node};
+    }
+
+    std::vector<NumaNode> load_nodes() {
+        std::vector<NumaNode> nodes;
+#ifdef __linux__
+        const std::string root = "/sys/devices/system/node";
+        DIR *dir = opendir(root.c_str());
+        if (!dir)
+            return single_node();
+        while (dirent *entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+            std::ifstream in(root + "/" + name + "/cpulist");
+            std::string list;
+            if (!std::getline(in, list))
+                continue;
+            NumaNode node{std::atoi(name.c_str() + 4), parse_cpu_list(list)};
+            if (!node.cpus.empty())
+                nodes.push_back(node);
+        }
+        closedir(dir);
+        std::sort(nodes.begin(), nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+#endif
+        return nodes.empty() ? single_node() : nodes;
+    }
+}
+
+std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.find_first_not_of(" \t\r\n") == std::string::npos)
+            continue;
+        size_t dash = range.find('-');
+        char *end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = dash == std::string::npos ? first : std::strtol(range.c_str() + dash + 1, &end, 10);
+        if (first < 0 || last < first)
+            throw std::runtime_error("invalid cpu list: " + list);
+        for (long cpu = first; cpu <= last; cpu++)
+            cpus.push_back(static_cast<int>(cpu));
+    }
+    return cpus;
+}
+
+const std::vector<NumaNode> &numa_nodes() {
+    static const std::vector<NumaNode> nodes = load_nodes();
+    return nodes;
+}
+
+bool pin_thread_to_node(int node) {
+    const std::vector<NumaNode> &nodes = numa_nodes();
+    if (node < 0 || node >= static_cast<int>(nodes.size()))
+        throw std::runtime_error("pin_thread_to_node: node out of range");
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: nodes[node].cpus) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return false;
+    pinned_node = node;
+    return true;
+#else
+    return false;
+#endif
+}
+
+int current_numa_node() {
+    if (pinned_node >= 0)
+        return pinned_node;
+#ifdef __linux__
+    const std::vector<NumaNode> &nodes = numa_nodes();
+    if (nodes.size() > 1) {
+        int cpu = sched_getcpu();
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (std::find(nodes[i].cpus.begin(), nodes[i].cpus.end(), cpu) != nodes[i].cpus.end())
+                return static_cast<int>(i);
+        }
+    }
+#endif
+    return 0;
+}
+
+void run_on_numa_node(int node, const std::function<void()> &fn) {
+    std::exception_ptr error;
+    std::thread worker([&]() {
+        try {
+            pin_thread_to_node(node);
+            fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+    worker.join();
+    if (error)
+        std::rethrow_exception(error);
+}
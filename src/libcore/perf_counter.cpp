@@ -0,0 +1,78 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include "futaba/core/perf_counter.h"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    int open_counter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    uint64_t read_counter(int fd) {
+        uint64_t value = 0;
+        if (fd < 0 || read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+            return 0;
+        return value;
+    }
+}
+
+CacheCounter::CacheCounter() {
+    fds[0] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) |
+                                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u));
+    fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+}
+
+CacheCounter::~CacheCounter() {
+    for (int fd: fds) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+void CacheCounter::start() {
+    for (int fd: fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void CacheCounter::stop() {
+    for (int fd: fds) {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    l1d_misses = read_counter(fds[0]);
+    llc_misses = read_counter(fds[1]);
+}
+
+#else
+
+CacheCounter::CacheCounter() : fds{-1, -1} {}
+
+CacheCounter::~CacheCounter() = default;
+
+void CacheCounter::start() {}
+
+void CacheCounter::stop() {}
+
+#endif
@@ -10,5 +10,7 @@ FTB_PY_EXPORT(image) {
             .def(py::init<int, int>())
             .def("read_pixel", &Image::read_pixel)
             .def("write_pixel", &Image::write_pixel)
-            .def("png_output", &Image::png_output);
+            .def("png_output", &Image::png_output)
+            .def("png_output_parallel", &Image::png_output_parallel,
+                 py::arg("filename"), py::arg("comp"), py::arg("level") = 6, py::arg("threads") = 0);
 }
\ No newline at end of file
@@ -11,12 +11,16 @@
  */
 FTB_PY_DECLARE(vec3);
 
+FTB_PY_DECLARE(vec3_array);
+
 FTB_PY_DECLARE(image);
 
 FTB_PY_DECLARE(ray);
 
 FTB_PY_DECLARE(rgb_pixel);
 
+FTB_PY_DECLARE(transform);
+
 /*
  * futaba_pyはCMakeのtargetにも同名の指定が必要
  */
@@ -55,7 +59,9 @@ PYBIND11_MODULE(futaba_py, m) {
     m.attr("FTB_AUTHORS") = FTB_AUTHORS;
 
     FTB_PY_IMPORT(vec3);
+    FTB_PY_IMPORT(vec3_array);
     FTB_PY_IMPORT(image);
     FTB_PY_IMPORT(ray);
     FTB_PY_IMPORT(rgb_pixel);
+    FTB_PY_IMPORT(transform);
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/core/transform.h>
+
+FTB_PY_EXPORT(transform) {
+    py::class_<Transform>(m, "Transform")
+            .def(py::init<>())
+            .def_static("translate", &Transform::translate)
+            .def_static("scale", &Transform::scale)
+            .def_static("rotate", &Transform::rotate)
+            .def("inverse", &Transform::inverse)
+            .def("apply_point", &Transform::apply_point)
+            .def("apply_vector", &Transform::apply_vector)
+            .def(py::self * py::self);
+}
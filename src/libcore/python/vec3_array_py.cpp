@@ -0,0 +1,149 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <stdexcept>
+#include <pybind11/numpy.h>
+#include <futaba/python/python.h>
+#include <futaba/core/vec3_array.h>
+
+namespace {
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+    /*
+     * NumPyの(N, 3)の配列を複製せずに参照する
+     * float32のC連続な配列以外は変換した配列を参照するため、その場合は元の配列とメモリを共有しない
+     * 読み取り専用の配列は読み取り専用のVec3Arrayとして参照する(演算の入力には利用できる)
+     */
+    Vec3Array from_numpy(const py::array &array) {
+        FloatArray converted = FloatArray::ensure(array);
+        if (!converted || converted.ndim() != 2 || converted.shape(1) != 3)
+            throw std::runtime_error("Vec3Array: array must be an (N, 3) array");
+        auto count = static_cast<size_t>(converted.shape(0));
+        // 配列の参照はGILを保持した状態で解放する
+        std::shared_ptr<void> owner(new py::object(converted), [](py::object *p) {
+            py::gil_scoped_acquire gil;
+            delete p;
+        });
+        if (!converted.writeable())
+            return {converted.data(), count, owner};
+        return {converted.mutable_data(), count, owner};
+    }
+
+    // 配列と同じメモリを参照するNumPyの配列、selfを基底として保持する
+    py::array_t<float> to_numpy(const py::object &self) {
+        const auto &a = self.cast<const Vec3Array &>();
+        py::array_t<float> array({static_cast<py::ssize_t>(a.size()), static_cast<py::ssize_t>(3)}, a.data(), self);
+        if (!a.is_writeable())
+            array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+
+    size_t wrap_index(const Vec3Array &a, py::ssize_t i) {
+        if (i < 0)
+            i += static_cast<py::ssize_t>(a.size());
+        if (i < 0 || static_cast<size_t>(i) >= a.size())
+            throw py::index_error();
+        return static_cast<size_t>(i);
+    }
+
+    // 以下の演算はGILを解放してC++のループで配列全体を処理する
+
+    template<typename B>
+    py::array_t<float> dot_py(const Vec3Array &a, const B &b) {
+        py::array_t<float> out(static_cast<py::ssize_t>(a.size()));
+        float *p = out.mutable_data();
+        {
+            py::gil_scoped_release release;
+            dot(a, b, p);
+        }
+        return out;
+    }
+
+    template<typename B>
+    Vec3Array cross_py(const Vec3Array &a, const B &b) {
+        Vec3Array out(a.size());
+        {
+            py::gil_scoped_release release;
+            cross(a, b, out);
+        }
+        return out;
+    }
+
+    Vec3Array unit_vec_py(const Vec3Array &v) {
+        Vec3Array out(v.size());
+        {
+            py::gil_scoped_release release;
+            unit_vec(v, out);
+        }
+        return out;
+    }
+
+    template<void (*Rotation)(const Vec3Array &, float, Vec3Array &)>
+    Vec3Array rotation_py(const Vec3Array &v, float theta) {
+        Vec3Array out(v.size());
+        {
+            py::gil_scoped_release release;
+            Rotation(v, theta, out);
+        }
+        return out;
+    }
+
+    template<typename B>
+    Vec3Array world_2_local_py(const Vec3Array &v, const B &s, const B &n, const B &t) {
+        Vec3Array out(v.size());
+        {
+            py::gil_scoped_release release;
+            world_2_local(v, s, n, t, out);
+        }
+        return out;
+    }
+
+    template<typename B>
+    Vec3Array local_2_world_py(const Vec3Array &v, const B &s, const B &n, const B &t) {
+        Vec3Array out(v.size());
+        {
+            py::gil_scoped_release release;
+            local_2_world(v, s, n, t, out);
+        }
+        return out;
+    }
+}
+
+FTB_PY_EXPORT(vec3_array) {
+    py::class_<Vec3Array>(m, "Vec3Array", py::buffer_protocol())
+            .def(py::init<size_t>(), py::arg("count") = 0)
+            .def(py::init(&from_numpy), py::arg("array"))
+            // np.asarray(a)で複製せずに(N, 3)の配列として参照できる
+            .def_buffer([](Vec3Array &a) -> py::buffer_info {
+                const Vec3Array &view = a;
+                return py::buffer_info(const_cast<float *>(view.data()), sizeof(float),
+                                       py::format_descriptor<float>::format(), 2,
+                                       {static_cast<py::ssize_t>(a.size()), static_cast<py::ssize_t>(3)},
+                                       {static_cast<py::ssize_t>(3 * sizeof(float)),
+                                        static_cast<py::ssize_t>(sizeof(float))},
+                                       !a.is_writeable());
+            })
+            .def("numpy", &to_numpy)
+            .def("__len__", &Vec3Array::size)
+            .def("__getitem__", [](const Vec3Array &a, py::ssize_t i) { return a.get(wrap_index(a, i)); })
+            .def("__setitem__", [](Vec3Array &a, py::ssize_t i, const Vec3 &v) { a.set(wrap_index(a, i), v); })
+
+            // Vec3と同様にVec3Array.dot(a, b)のようにクラス経由でも呼び出せる
+            // 2つ目以降の引数はVec3Array(要素毎)もしくはVec3(全要素で共通)
+            .def("dot", &dot_py<Vec3Array>)
+            .def("dot", &dot_py<Vec3>)
+            .def("cross", &cross_py<Vec3Array>)
+            .def("cross", &cross_py<Vec3>)
+            .def("rotation_x", &rotation_py<rotation_x>)
+            .def("rotation_y", &rotation_py<rotation_y>)
+            .def("rotation_z", &rotation_py<rotation_z>)
+            .def("unit_vec", &unit_vec_py)
+            .def("world_2_local", &world_2_local_py<Vec3Array>)
+            .def("world_2_local", &world_2_local_py<Vec3>)
+            .def("local_2_world", &local_2_world_py<Vec3Array>)
+            .def("local_2_world", &local_2_world_py<Vec3>);
+
+    // NumPyの配列をVec3Arrayの引数に直接渡せるようにする
+    py::implicitly_convertible<py::array, Vec3Array>();
+}
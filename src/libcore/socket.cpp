@@ -0,0 +1,189 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "futaba/core/socket.h"
+
+namespace {
+    // 異常なlengthを受信した場合に巨大な領域を確保しないための上限
+    const uint64_t MESSAGE_SIZE_MAX = 1ull << 34;
+
+    bool starts_with(const std::string &s, const std::string &prefix) {
+        return s.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    sockaddr_un unix_address(const std::string &path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("socket path is too long: " + path);
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        return addr;
+    }
+
+    addrinfo *tcp_address(const std::string &host_port, bool passive) {
+        auto colon = host_port.rfind(':');
+        if (colon == std::string::npos)
+            throw std::runtime_error("invalid tcp address: " + host_port);
+        std::string host = host_port.substr(0, colon);
+        std::string port = host_port.substr(colon + 1);
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        addrinfo *result = nullptr;
+        if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0)
+            throw std::runtime_error("failed to resolve: " + host_port);
+        return result;
+    }
+}
+
+Socket::Socket(Socket &&src) noexcept: fd(src.fd) {
+    src.fd = -1;
+}
+
+Socket &Socket::operator=(Socket &&src) noexcept {
+    if (this != &src) {
+        close();
+        fd = src.fd;
+        src.fd = -1;
+    }
+    return *this;
+}
+
+Socket::~Socket() {
+    close();
+}
+
+void Socket::close() {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+void Socket::shutdown() const {
+    if (fd >= 0)
+        ::shutdown(fd, SHUT_RDWR);
+}
+
+void Socket::set_recv_timeout(double seconds) const {
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(seconds);
+    tv.tv_usec = static_cast<suseconds_t>((seconds - static_cast<double>(tv.tv_sec)) * 1e6);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+Socket Socket::listen(const std::string &address) {
+    if (starts_with(address, "unix:")) {
+        std::string path = address.substr(5);
+        sockaddr_un addr = unix_address(path);
+        ::unlink(path.c_str());
+
+        Socket s(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!s.is_open() || ::bind(s.fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+            ::listen(s.fd, SOMAXCONN) != 0)
+            throw std::runtime_error("failed to listen: " + address);
+        return s;
+    }
+    if (starts_with(address, "tcp:")) {
+        addrinfo *info = tcp_address(address.substr(4), true);
+        Socket s(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        int yes = 1;
+        bool ok = s.is_open() && ::setsockopt(s.fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) == 0 &&
+                  ::bind(s.fd, info->ai_addr, info->ai_addrlen) == 0 && ::listen(s.fd, SOMAXCONN) == 0;
+        ::freeaddrinfo(info);
+        if (!ok)
+            throw std::runtime_error("failed to listen: " + address);
+        return s;
+    }
+    throw std::runtime_error("unknown address: " + address);
+}
+
+Socket Socket::connect(const std::string &address) {
+    if (starts_with(address, "unix:")) {
+        sockaddr_un addr = unix_address(address.substr(5));
+        Socket s(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!s.is_open() || ::connect(s.fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+            throw std::runtime_error("failed to connect: " + address);
+        return s;
+    }
+    if (starts_with(address, "tcp:")) {
+        addrinfo *info = tcp_address(address.substr(4), false);
+        Socket s(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        bool ok = s.is_open() && ::connect(s.fd, info->ai_addr, info->ai_addrlen) == 0;
+        ::freeaddrinfo(info);
+        if (!ok)
+            throw std::runtime_error("failed to connect: " + address);
+        // 小さな要求メッセージが遅延しないようにNagleアルゴリズムを無効にする
+        int yes = 1;
+        ::setsockopt(s.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        return s;
+    }
+    throw std::runtime_error("unknown address: " + address);
+}
+
+Socket Socket::accept() const {
+    int client = ::accept(fd, nullptr, nullptr);
+    if (client < 0)
+        throw std::runtime_error("failed to accept");
+    return Socket(client);
+}
+
+void Socket::send_all(const void *data, size_t size) const {
+    auto p = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        // 相手が切断していた場合にSIGPIPEでプロセスが終了しないようにする
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error("connection lost");
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void Socket::recv_all(void *data, size_t size) const {
+    auto p = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error("connection lost");
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void Socket::send_message(uint32_t type, const void *payload, size_t size) const {
+    auto length = static_cast<uint64_t>(size);
+    uint8_t header[sizeof(type) + sizeof(length)];
+    std::memcpy(header, &type, sizeof(type));
+    std::memcpy(header + sizeof(type), &length, sizeof(length));
+    send_all(header, sizeof(header));
+    send_all(payload, size);
+}
+
+Message Socket::recv_message() const {
+    Message msg;
+    uint64_t length = 0;
+    recv_all(&msg.type, sizeof(msg.type));
+    recv_all(&length, sizeof(length));
+    if (length > MESSAGE_SIZE_MAX)
+        throw std::runtime_error("message is too large");
+    msg.payload.resize(length);
+    recv_all(msg.payload.data(), length);
+    return msg;
+}
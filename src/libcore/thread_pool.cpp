@@ -0,0 +1,129 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include "futaba/core/numa.h"
+#include "futaba/core/thread_pool.h"
+
+ThreadPool::ThreadPool(int threads, bool numa) {
+    int count = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+    int nodes = numa ? static_cast<int>(numa_nodes().size()) : 1;
+    partitions = std::max(1, std::min(nodes, count));
+    // 呼び出し元を0番目として、i番目のスレッドをi * partitions / count番目のノードに割り振る
+    for (int i = 1; i < count; i++)
+        workers.emplace_back(&ThreadPool::worker_loop, this, numa ? i * partitions / count : -1);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &w: workers)
+        w.join();
+}
+
+void ThreadPool::worker_loop(int node) {
+    if (node >= 0)
+        pin_thread_to_node(node);
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+    // 1回の並列処理に参加したプール内のスレッドの終了を待ち合わせる
+    struct ParallelJob {
+        int pending_tasks = 0;
+        std::mutex mtx;
+        std::condition_variable cv;
+        // 最初に送出された例外、設定された後は残りのインデックスを処理しない
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+    };
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)> &fn) {
+    if (count <= 0)
+        return;
+
+    std::atomic<int> next(0);
+    run_parallel(std::min(static_cast<int>(workers.size()), count - 1), [&next, count, &fn](const std::atomic<bool> &failed) {
+        for (int i = next++; i < count && !failed; i = next++)
+            fn(i);
+    });
+}
+
+void ThreadPool::parallel_for_nodes(int count, const std::function<void(int)> &fn) {
+    int parts = std::min(partitions, count);
+    if (parts <= 1) {
+        parallel_for(count, fn);
+        return;
+    }
+
+    // 各範囲の次のインデックス、範囲kは[k * count / parts, (k + 1) * count / parts)
+    std::unique_ptr<std::atomic<int>[]> next(new std::atomic<int>[parts]);
+    for (int k = 0; k < parts; k++)
+        next[k] = k * count / parts;
+    run_parallel(std::min(static_cast<int>(workers.size()), count - 1), [&next, parts, count, &fn](const std::atomic<bool> &failed) {
+        // 自身のノードの範囲から始め、終わったら次のノードの範囲を手伝う
+        int home = current_numa_node() % parts;
+        for (int r = 0; r < parts; r++) {
+            int k = (home + r) % parts;
+            int end = (k + 1) * count / parts;
+            for (int i = next[k]++; i < end && !failed; i = next[k]++)
+                fn(i);
+        }
+    });
+}
+
+void ThreadPool::run_parallel(int helpers, const std::function<void(const std::atomic<bool> &)> &fn) {
+    auto job = std::make_shared<ParallelJob>();
+    auto run = [job, &fn]() {
+        try {
+            fn(job->failed);
+        } catch (...) {
+            // プール内のスレッドから送出させるとプロセスが終了するため、呼び出し元で送出し直す
+            std::lock_guard<std::mutex> lock(job->mtx);
+            if (!job->error)
+                job->error = std::current_exception();
+            job->failed = true;
+        }
+    };
+
+    job->pending_tasks = helpers;
+    if (helpers > 0) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int i = 0; i < helpers; i++) {
+            tasks.emplace_back([job, run]() {
+                run();
+                std::lock_guard<std::mutex> job_lock(job->mtx);
+                if (--job->pending_tasks == 0)
+                    job->cv.notify_all();
+            });
+        }
+    }
+    cv.notify_all();
+
+    run();
+
+    // fnは呼び出し元のスタック上にあるため、例外の場合も含めて全てのタスクが終了するまで戻ってはならない
+    std::unique_lock<std::mutex> lock(job->mtx);
+    job->cv.wait(lock, [&job]() { return job->pending_tasks == 0; });
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
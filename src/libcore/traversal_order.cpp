@@ -0,0 +1,108 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include "futaba/core/traversal_order.h"
+
+namespace {
+    // 偶数番目のビットを下位に詰める
+    uint32_t compact_bits(uint32_t v) {
+        v &= 0x55555555u;
+        v = (v | (v >> 1u)) & 0x33333333u;
+        v = (v | (v >> 2u)) & 0x0f0f0f0fu;
+        v = (v | (v >> 4u)) & 0x00ff00ffu;
+        v = (v | (v >> 8u)) & 0x0000ffffu;
+        return v;
+    }
+
+    // 下位10ビットを3ビット毎に広げる
+    uint32_t spread_bits3(uint32_t v) {
+        v &= 0x3ffu;
+        v = (v | (v << 16u)) & 0x030000ffu;
+        v = (v | (v << 8u)) & 0x0300f00fu;
+        v = (v | (v << 4u)) & 0x030c30c3u;
+        v = (v | (v << 2u)) & 0x09249249u;
+        return v;
+    }
+}
+
+TraversalOrder traversal_order_from_name(const std::string &name) {
+    if (name == "scanline")
+        return ORDER_SCANLINE;
+    if (name == "morton")
+        return ORDER_MORTON;
+    if (name == "hilbert")
+        return ORDER_HILBERT;
+    throw std::runtime_error("unknown traversal order: " + name);
+}
+
+const char *traversal_order_name(TraversalOrder order) {
+    switch (order) {
+        case ORDER_MORTON:
+            return "morton";
+        case ORDER_HILBERT:
+            return "hilbert";
+        case ORDER_SCANLINE:
+        default:
+            return "scanline";
+    }
+}
+
+void morton_d2xy(uint32_t d, uint32_t &x, uint32_t &y) {
+    x = compact_bits(d);
+    y = compact_bits(d >> 1u);
+}
+
+uint32_t morton_encode3(uint32_t x, uint32_t y, uint32_t z) {
+    return spread_bits3(x) | (spread_bits3(y) << 1u) | (spread_bits3(z) << 2u);
+}
+
+void hilbert_d2xy(uint32_t n, uint32_t d, uint32_t &x, uint32_t &y) {
+    x = 0;
+    y = 0;
+    for (uint32_t s = 1; s < n; s *= 2) {
+        uint32_t rx = 1u & (d / 2);
+        uint32_t ry = 1u & (d ^ rx);
+        // 部分曲線の向きを揃える
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+        x += s * rx;
+        y += s * ry;
+        d /= 4;
+    }
+}
+
+std::vector<uint32_t> traversal_order(int width, int height, TraversalOrder order) {
+    std::vector<uint32_t> indices;
+    if (width <= 0 || height <= 0)
+        return indices;
+    auto w = static_cast<uint32_t>(width);
+    auto h = static_cast<uint32_t>(height);
+    indices.reserve(static_cast<size_t>(w) * h);
+    if (order == ORDER_SCANLINE) {
+        for (uint32_t i = 0; i < w * h; i++)
+            indices.push_back(i);
+        return indices;
+    }
+
+    uint32_t n = 1;
+    while (n < std::max(w, h))
+        n *= 2;
+    for (uint64_t d = 0; d < static_cast<uint64_t>(n) * n && indices.size() < indices.capacity(); d++) {
+        uint32_t x, y;
+        if (order == ORDER_MORTON)
+            morton_d2xy(static_cast<uint32_t>(d), x, y);
+        else
+            hilbert_d2xy(n, static_cast<uint32_t>(d), x, y);
+        if (x < w && y < h)
+            indices.push_back(y * w + x);
+    }
+    return indices;
+}
@@ -0,0 +1,124 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <stdexcept>
+#include "futaba/core/vec3_array.h"
+
+namespace {
+    // Vec3は全要素で共通の値として扱う
+    Vec3 element(const Vec3 &v, size_t) {
+        return v;
+    }
+
+    Vec3 element(const Vec3Array &a, size_t i) {
+        return a.get(i);
+    }
+
+    void check_size(const Vec3 &, size_t) {
+    }
+
+    void check_size(const Vec3Array &a, size_t n) {
+        if (a.size() != n)
+            throw std::runtime_error("Vec3Array: size mismatch");
+    }
+
+    template<typename B>
+    void dot_impl(const Vec3Array &a, const B &b, float *out) {
+        check_size(b, a.size());
+        for (size_t i = 0; i < a.size(); i++)
+            out[i] = dot(a.get(i), element(b, i));
+    }
+
+    template<typename B>
+    void cross_impl(const Vec3Array &a, const B &b, Vec3Array &out) {
+        check_size(b, a.size());
+        check_size(out, a.size());
+        for (size_t i = 0; i < a.size(); i++)
+            out.set(i, cross(a.get(i), element(b, i)));
+    }
+
+    template<typename B>
+    void world_2_local_impl(const Vec3Array &v, const B &s, const B &n, const B &t, Vec3Array &out) {
+        check_size(s, v.size());
+        check_size(n, v.size());
+        check_size(t, v.size());
+        check_size(out, v.size());
+        for (size_t i = 0; i < v.size(); i++)
+            out.set(i, world_2_local(v.get(i), element(s, i), element(n, i), element(t, i)));
+    }
+
+    template<typename B>
+    void local_2_world_impl(const Vec3Array &v, const B &s, const B &n, const B &t, Vec3Array &out) {
+        check_size(s, v.size());
+        check_size(n, v.size());
+        check_size(t, v.size());
+        check_size(out, v.size());
+        for (size_t i = 0; i < v.size(); i++) {
+            Vec3 vi = v.get(i), si = element(s, i), ni = element(n, i), ti = element(t, i);
+            out.set(i, local_2_world(vi, si, ni, ti));
+        }
+    }
+
+    template<Vec3 (*Rotation)(Vec3, float)>
+    void rotation_impl(const Vec3Array &v, float theta, Vec3Array &out) {
+        check_size(out, v.size());
+        for (size_t i = 0; i < v.size(); i++)
+            out.set(i, Rotation(v.get(i), theta));
+    }
+}
+
+Vec3Array::Vec3Array(size_t _count) :
+        owner(std::shared_ptr<float>(new float[3 * _count](), std::default_delete<float[]>())), n(_count) {
+    buffer = static_cast<float *>(owner.get());
+}
+
+void dot(const Vec3Array &a, const Vec3Array &b, float *out) {
+    dot_impl(a, b, out);
+}
+
+void dot(const Vec3Array &a, const Vec3 &b, float *out) {
+    dot_impl(a, b, out);
+}
+
+void cross(const Vec3Array &a, const Vec3Array &b, Vec3Array &out) {
+    cross_impl(a, b, out);
+}
+
+void cross(const Vec3Array &a, const Vec3 &b, Vec3Array &out) {
+    cross_impl(a, b, out);
+}
+
+void unit_vec(const Vec3Array &v, Vec3Array &out) {
+    check_size(out, v.size());
+    for (size_t i = 0; i < v.size(); i++)
+        out.set(i, unit_vec(v.get(i)));
+}
+
+void rotation_x(const Vec3Array &v, float theta, Vec3Array &out) {
+    rotation_impl<rotation_x>(v, theta, out);
+}
+
+void rotation_y(const Vec3Array &v, float theta, Vec3Array &out) {
+    rotation_impl<rotation_y>(v, theta, out);
+}
+
+void rotation_z(const Vec3Array &v, float theta, Vec3Array &out) {
+    rotation_impl<rotation_z>(v, theta, out);
+}
+
+void world_2_local(const Vec3Array &v, const Vec3Array &s, const Vec3Array &n, const Vec3Array &t, Vec3Array &out) {
+    world_2_local_impl(v, s, n, t, out);
+}
+
+void world_2_local(const Vec3Array &v, const Vec3 &s, const Vec3 &n, const Vec3 &t, Vec3Array &out) {
+    world_2_local_impl(v, s, n, t, out);
+}
+
+void local_2_world(const Vec3Array &v, const Vec3Array &s, const Vec3Array &n, const Vec3Array &t, Vec3Array &out) {
+    local_2_world_impl(v, s, n, t, out);
+}
+
+void local_2_world(const Vec3Array &v, const Vec3 &s, const Vec3 &n, const Vec3 &t, Vec3Array &out) {
+    local_2_world_impl(v, s, n, t, out);
+}
@@ -0,0 +1,324 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "futaba/render/aggregate.h"
+
+static_assert(TypeIndex<Sphere, PrimitiveTypes>::value == PRIM_SPHERE, "PrimitiveType mismatch");
+static_assert(TypeIndex<Mesh, PrimitiveTypes>::value == PRIM_TRIANGLE, "PrimitiveType mismatch");
+static_assert(TypeIndex<SphereCloud, PrimitiveTypes>::value == PRIM_SPHERE_CLOUD, "PrimitiveType mismatch");
+static_assert(TypeIndex<Instance, PrimitiveTypes>::value == PRIM_INSTANCE, "PrimitiveType mismatch");
+
+namespace {
+    /*
+     * Storageの各配列に対する処理をI番目の型から順に展開する
+     * 呼び出す関数は全てコンパイル時に決まるため、衝突判定は型の番号の比較と直接呼び出しのみとなる
+     */
+    template<size_t I, size_t N = std::tuple_size<Aggregate::Storage>::value>
+    struct PrimitiveLoop {
+        typedef PrimitiveLoop<I + 1, N> Next;
+
+        static size_t primitive_count(const Aggregate::Storage &storage) {
+            size_t count = 0;
+            for (const auto &object: std::get<I>(storage))
+                count += object.primitive_count();
+            return count + Next::primitive_count(storage);
+        }
+
+        static void collect(const Aggregate::Storage &storage, std::vector<PrimRef> &refs, std::vector<AABB> &bounds) {
+            const auto &objects = std::get<I>(storage);
+            for (uint32_t i = 0; i < objects.size(); i++) {
+                for (uint32_t prim = 0; prim < objects[i].primitive_count(); prim++) {
+                    refs.push_back(PrimRef{static_cast<PrimitiveType>(I), i, prim});
+                    bounds.push_back(objects[i].bounds(prim));
+                }
+            }
+            Next::collect(storage, refs, bounds);
+        }
+
+        static void expand(const Aggregate::Storage &storage, AABB &box) {
+            for (const auto &object: std::get<I>(storage)) {
+                for (uint32_t prim = 0; prim < object.primitive_count(); prim++)
+                    box.expand(object.bounds(prim));
+            }
+            Next::expand(storage, box);
+        }
+
+        static bool is_hittable(const Aggregate::Storage &storage, const PrimRef &ref, Ray &ray, HitRecord &hit_rec) {
+            if (ref.type == I)
+                return std::get<I>(storage)[ref.object].is_hittable(ref.prim, ray, hit_rec);
+            return Next::is_hittable(storage, ref, ray, hit_rec);
+        }
+
+        static bool is_valid(const Aggregate::Storage &storage, const PrimRef &ref) {
+            if (ref.type == I) {
+                const auto &objects = std::get<I>(storage);
+                return ref.object < objects.size() && ref.prim < objects[ref.object].primitive_count();
+            }
+            return Next::is_valid(storage, ref);
+        }
+
+        // 種類typeより前の種類のオブジェクトの総数
+        static size_t object_offset(const Aggregate::Storage &storage, uint32_t type) {
+            if (type == I)
+                return 0;
+            return std::get<I>(storage).size() + Next::object_offset(storage, type);
+        }
+
+        template<typename F>
+        static bool for_each_prim(const Aggregate::Storage &storage, F &&fn) {
+            bool is_hit = false;
+            const auto &objects = std::get<I>(storage);
+            for (uint32_t i = 0; i < objects.size(); i++) {
+                for (uint32_t prim = 0; prim < objects[i].primitive_count(); prim++) {
+                    if (fn(PrimRef{static_cast<PrimitiveType>(I), i, prim}))
+                        is_hit = true;
+                }
+            }
+            return Next::for_each_prim(storage, fn) || is_hit;
+        }
+    };
+
+    template<size_t N>
+    struct PrimitiveLoop<N, N> {
+        static size_t primitive_count(const Aggregate::Storage &) {
+            return 0;
+        }
+
+        static void collect(const Aggregate::Storage &, std::vector<PrimRef> &, std::vector<AABB> &) {
+        }
+
+        static void expand(const Aggregate::Storage &, AABB &) {
+        }
+
+        static bool is_hittable(const Aggregate::Storage &, const PrimRef &, Ray &, HitRecord &) {
+            return false;
+        }
+
+        static bool is_valid(const Aggregate::Storage &, const PrimRef &) {
+            return false;
+        }
+
+        static size_t object_offset(const Aggregate::Storage &, uint32_t) {
+            return 0;
+        }
+
+        template<typename F>
+        static bool for_each_prim(const Aggregate::Storage &, F &&) {
+            return false;
+        }
+    };
+
+    typedef PrimitiveLoop<0> AllPrimitives;
+
+    bool is_emissive(const MaterialTable &materials, MaterialId id) {
+        return id < materials.size() && materials.type[id] == MAT_EMISSIVE &&
+               materials.emission[id].squared_length() > 0.0f;
+    }
+
+    // 発光する材質のプリミティブを光源として集める
+    std::vector<Light> collect_lights(const Aggregate::Storage &storage, const MaterialTable &materials) {
+        std::vector<Light> lights;
+        const auto &spheres = std::get<PRIM_SPHERE>(storage);
+        for (uint32_t i = 0; i < spheres.size(); i++) {
+            const Sphere &s = spheres[i];
+            if (is_emissive(materials, s.material))
+                lights.push_back(Light::sphere(s.center, s.radius, materials.emission[s.material], static_cast<int>(i),
+                                               0));
+        }
+
+        const auto &meshes = std::get<PRIM_TRIANGLE>(storage);
+        size_t mesh_offset = AllPrimitives::object_offset(storage, PRIM_TRIANGLE);
+        for (uint32_t i = 0; i < meshes.size(); i++) {
+            const Mesh &mesh = meshes[i];
+            if (!is_emissive(materials, mesh.material))
+                continue;
+            const uint32_t *indices = mesh.indices();
+            for (uint32_t tri = 0; tri < mesh.triangle_count(); tri++) {
+                Vec3 p0 = mesh.vertex(indices[3 * tri]);
+                Vec3 p1 = mesh.vertex(indices[3 * tri + 1]);
+                Vec3 p2 = mesh.vertex(indices[3 * tri + 2]);
+                // 面積が0の三角形はサンプリングできない
+                if (cross(p1 - p0, p2 - p0).squared_length() == 0.0f)
+                    continue;
+                lights.push_back(Light::triangle(p0, p1, p2, materials.emission[mesh.material],
+                                                 static_cast<int>(mesh_offset + i), tri));
+            }
+        }
+
+        const auto &clouds = std::get<PRIM_SPHERE_CLOUD>(storage);
+        size_t cloud_offset = AllPrimitives::object_offset(storage, PRIM_SPHERE_CLOUD);
+        for (uint32_t i = 0; i < clouds.size(); i++) {
+            const SphereCloud &cloud = clouds[i];
+            if (!is_emissive(materials, cloud.material))
+                continue;
+            for (uint32_t j = 0; j < cloud.count(); j++)
+                lights.push_back(Light::sphere(cloud.center(j), cloud.radius(j), materials.emission[cloud.material],
+                                               static_cast<int>(cloud_offset + i), j));
+        }
+        return lights;
+    }
+}
+
+void Aggregate::build() {
+    std::vector<PrimRef> refs;
+    std::vector<AABB> bounds;
+    size_t count = AllPrimitives::primitive_count(storage);
+    refs.reserve(count);
+    bounds.reserve(count);
+    AllPrimitives::collect(storage, refs, bounds);
+    bvh.build(std::move(refs), std::move(bounds));
+    bvh_replicas.clear();
+    lights.build(collect_lights(storage, materials));
+}
+
+void Aggregate::use_bvh(const BVH &prebuilt) {
+    const BVHNode *nodes = prebuilt.nodes();
+    const PrimRef *prims = prebuilt.prims();
+    // 子は常に親より後ろに置かれるため、前から順に深さを伝播してトラバーサルのスタックに収まるかを確かめる
+    std::vector<int> depths(prebuilt.node_count(), 1);
+    for (size_t i = 0; i < prebuilt.node_count(); i++) {
+        const BVHNode &node = nodes[i];
+        bool valid = node.count > 0 ? node.offset <= prebuilt.prim_count() &&
+                                      node.count <= prebuilt.prim_count() - node.offset
+                                    : node.offset > i + 1 && node.offset < prebuilt.node_count();
+        if (!valid || depths[i] > BVH_DEPTH_MAX)
+            throw std::runtime_error("Aggregate::use_bvh: corrupt node");
+        if (node.count == 0)
+            depths[i + 1] = depths[node.offset] = depths[i] + 1;
+    }
+    for (size_t i = 0; i < prebuilt.prim_count(); i++) {
+        const PrimRef &ref = prims[i];
+        if (ref.type > PRIM_INSTANCE || !AllPrimitives::is_valid(storage, ref))
+            throw std::runtime_error("Aggregate::use_bvh: primitive out of range");
+    }
+    bvh = prebuilt;
+    bvh_replicas.clear();
+    lights.build(collect_lights(storage, materials));
+}
+
+void Aggregate::replicate_bvh() {
+    bvh_replicas.clear();
+    const std::vector<NumaNode> &nodes = numa_nodes();
+    if (bvh.empty() || nodes.size() <= 1)
+        return;
+
+    typedef std::pair<std::vector<BVHNode>, std::vector<PrimRef>> Arrays;
+    std::vector<BVH> replicas(nodes.size());
+    for (size_t k = 0; k < nodes.size(); k++) {
+        run_on_numa_node(static_cast<int>(k), [&]() {
+            // 配列の確保と複製をノードに固定したスレッドで行い、ページをそのノードに置く
+            auto arrays = std::make_shared<Arrays>(
+                    std::vector<BVHNode>(bvh.nodes(), bvh.nodes() + bvh.node_count()),
+                    std::vector<PrimRef>(bvh.prims(), bvh.prims() + bvh.prim_count()));
+            replicas[k].attach(arrays->first.data(), arrays->first.size(), arrays->second.data(),
+                               arrays->second.size(), arrays);
+        });
+    }
+    bvh_replicas = std::move(replicas);
+}
+
+bool Aggregate::intersect_prim(const PrimRef &ref, Ray &ray, HitRecord &hit_rec) const {
+    HitRecord hit_temp = HitRecord();
+    // Instanceはプロトタイプのトラバーサルでこれより遠いノードを枝刈りする
+    hit_temp.t = hit_rec.t;
+    if (!AllPrimitives::is_hittable(storage, ref, ray, hit_temp) || hit_temp.t >= hit_rec.t)
+        return false;
+
+    hit_rec = hit_temp;
+    hit_rec.hit_id = static_cast<int>(AllPrimitives::object_offset(storage, ref.type) + ref.object);
+    return true;
+}
+
+bool Aggregate::intersect(Ray &ray, HitRecord &hit_rec) const {
+    if (!bvh.empty()) {
+        return local_bvh().traverse(ray, hit_rec.t, [&](const PrimRef &ref, float &t_max) {
+            if (!intersect_prim(ref, ray, hit_rec))
+                return false;
+            t_max = hit_rec.t;
+            return true;
+        });
+    }
+
+    return AllPrimitives::for_each_prim(storage, [&](const PrimRef &ref) {
+        return intersect_prim(ref, ray, hit_rec);
+    });
+}
+
+template<int N>
+void Aggregate::intersect_packet_n(Ray *rays, HitRecord *hits, uint8_t *is_hit, int count) const {
+    RayPacket<N> packet(rays, count, HIT_DISTANCE_MAX);
+    TriangleShear<N> shear;
+    Mesh::shear(packet, shear);
+    for (int i = 0; i < count; i++) {
+        hits[i] = HitRecord();
+        packet.t_max[i] = hits[i].t;
+    }
+    const std::vector<Mesh> &mesh_list = meshes();
+    uint32_t mask = local_bvh().traverse_packet(packet, [&](const PrimRef &ref, uint32_t lanes) {
+        // 三角形はSSEで衝突し得ないレーンを除いてからレイ毎に判定する
+        if (ref.type == PRIM_TRIANGLE)
+            lanes = mesh_list[ref.object].candidate_mask(ref.prim, packet, shear, lanes);
+        uint32_t hit = 0;
+        for (int lane = 0; lanes != 0; lane++, lanes >>= 1u) {
+            if (!(lanes & 1u) || !intersect_prim(ref, rays[lane], hits[lane]))
+                continue;
+            packet.t_max[lane] = hits[lane].t;
+            hit |= 1u << static_cast<uint32_t>(lane);
+        }
+        return hit;
+    });
+    for (int i = 0; i < count; i++)
+        is_hit[i] = static_cast<uint8_t>(mask >> static_cast<uint32_t>(i) & 1u);
+}
+
+void Aggregate::intersect_packet(Ray *rays, HitRecord *hits, uint8_t *is_hit, size_t count, int packet_size) const {
+    if (bvh.empty() || (packet_size != 4 && packet_size != 8 && packet_size != 16)) {
+        for (size_t i = 0; i < count; i++) {
+            hits[i] = HitRecord();
+            is_hit[i] = static_cast<uint8_t>(intersect(rays[i], hits[i]));
+        }
+        return;
+    }
+
+    for (size_t begin = 0; begin < count; begin += static_cast<size_t>(packet_size)) {
+        int n = static_cast<int>(std::min(count - begin, static_cast<size_t>(packet_size)));
+        if (n <= 4)
+            intersect_packet_n<4>(rays + begin, hits + begin, is_hit + begin, n);
+        else if (n <= 8)
+            intersect_packet_n<8>(rays + begin, hits + begin, is_hit + begin, n);
+        else
+            intersect_packet_n<16>(rays + begin, hits + begin, is_hit + begin, n);
+    }
+}
+
+bool Aggregate::occluded(const Ray &ray, float t_max) const {
+    Ray r = ray;
+    HitRecord hit_rec;
+    hit_rec.t = t_max;
+    if (bvh.empty())
+        return intersect(r, hit_rec);
+
+    bool is_occluded = false;
+    local_bvh().traverse(r, t_max, [&](const PrimRef &ref, float &t) {
+        if (is_occluded || !intersect_prim(ref, r, hit_rec))
+            return false;
+        // t_maxを0にすると以降のノードは全てスラブ判定で枝刈りされる
+        is_occluded = true;
+        t = 0.0f;
+        return true;
+    });
+    return is_occluded;
+}
+
+AABB Aggregate::bounds() const {
+    if (!bvh.empty())
+        return bvh.nodes()[0].bounds;
+
+    AABB box;
+    AllPrimitives::expand(storage, box);
+    return box;
+}
@@ -0,0 +1,174 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "futaba/render/bvh.h"
+
+namespace {
+    // SAHで分割位置を評価するビンの数
+    const int SAH_BINS = 16;
+    // これ以下のプリミティブ数のノードは分割せずに葉とする
+    const uint32_t LEAF_SIZE_MIN = 2;
+    // 葉のプリミティブ数の上限、これを超える場合はSAHのコストが悪化しても分割する
+    const uint32_t LEAF_SIZE_MAX = 8;
+    // プリミティブ1つの衝突判定に対するノード1つの判定の相対的なコスト
+    const float TRAVERSAL_COST = 1.0f;
+
+    struct Bin {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+
+    // 構築したBVHの配列、BVHのコピー間で共有する
+    struct BVHStorage {
+        std::vector<BVHNode> nodes;
+        std::vector<PrimRef> prims;
+    };
+}
+
+void BVH::build(std::vector<PrimRef> refs, std::vector<AABB> bounds) {
+    if (refs.size() != bounds.size())
+        throw std::runtime_error("BVH::build: refs and bounds size mismatch");
+
+    auto storage = std::make_shared<BVHStorage>();
+    std::vector<BVHNode> &nodes = storage->nodes;
+    std::vector<PrimRef> &prims = storage->prims;
+    prims = std::move(refs);
+    if (prims.empty()) {
+        attach(nullptr, 0, nullptr, 0, nullptr);
+        return;
+    }
+
+    std::vector<AABB> prim_bounds = std::move(bounds);
+    std::vector<Vec3> centroids(prim_bounds.size());
+    for (size_t i = 0; i < prim_bounds.size(); i++)
+        centroids[i] = prim_bounds[i].centroid();
+
+    nodes.reserve(2 * prims.size());
+    build_recursive(nodes, prims, prim_bounds, centroids, 0, static_cast<uint32_t>(prims.size()), 1);
+    attach(nodes.data(), nodes.size(), prims.data(), prims.size(), storage);
+}
+
+void BVH::attach(const BVHNode *_nodes, size_t _node_count, const PrimRef *_prims, size_t _prim_count,
+                 std::shared_ptr<const void> _owner) {
+    owner = std::move(_owner);
+    node_data = _nodes;
+    n_nodes = _node_count;
+    prim_data = _prims;
+    n_prims = _prim_count;
+}
+
+uint32_t BVH::build_recursive(std::vector<BVHNode> &nodes, std::vector<PrimRef> &refs, std::vector<AABB> &bounds,
+                              std::vector<Vec3> &centroids,
+                              uint32_t begin, uint32_t end, int depth) {
+    auto index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(BVHNode());
+
+    AABB node_bounds, centroid_bounds;
+    for (uint32_t i = begin; i < end; i++) {
+        node_bounds.expand(bounds[i]);
+        centroid_bounds.expand(centroids[i]);
+    }
+    nodes[index].bounds = node_bounds;
+
+    uint32_t count = end - begin;
+    int axis = centroid_bounds.longest_axis();
+    float c_min = centroid_bounds.min.elements[axis];
+    float c_extent = centroid_bounds.max.elements[axis] - c_min;
+
+    // 重心が全て一致する場合やスタックの上限に達した場合は分割できない
+    if (count <= LEAF_SIZE_MIN || c_extent <= 0.0f || depth >= BVH_DEPTH_MAX) {
+        nodes[index].offset = begin;
+        nodes[index].count = count;
+        return index;
+    }
+
+    auto bin_of = [&](uint32_t i) {
+        auto b = static_cast<int>(SAH_BINS * (centroids[i].elements[axis] - c_min) / c_extent);
+        return std::min(b, SAH_BINS - 1);
+    };
+
+    Bin bins[SAH_BINS];
+    for (uint32_t i = begin; i < end; i++) {
+        Bin &bin = bins[bin_of(i)];
+        bin.bounds.expand(bounds[i]);
+        bin.count++;
+    }
+
+    // 左右から累積した範囲で各分割位置のコストを求める
+    float right_area[SAH_BINS];
+    uint32_t right_count[SAH_BINS];
+    AABB acc;
+    uint32_t acc_count = 0;
+    for (int b = SAH_BINS - 1; b > 0; b--) {
+        acc.expand(bins[b].bounds);
+        acc_count += bins[b].count;
+        right_area[b] = acc.surface_area();
+        right_count[b] = acc_count;
+    }
+
+    int best_split = -1;
+    float best_cost = static_cast<float>(count);
+    acc = AABB();
+    acc_count = 0;
+    float inv_area = 1.0f / node_bounds.surface_area();
+    for (int b = 1; b < SAH_BINS; b++) {
+        acc.expand(bins[b - 1].bounds);
+        acc_count += bins[b - 1].count;
+        if (acc_count == 0 || right_count[b] == 0)
+            continue;
+        float cost = TRAVERSAL_COST +
+                     (acc.surface_area() * acc_count + right_area[b] * right_count[b]) * inv_area;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_split = b;
+        }
+    }
+
+    if (best_split < 0 && count <= LEAF_SIZE_MAX) {
+        nodes[index].offset = begin;
+        nodes[index].count = count;
+        return index;
+    }
+
+    uint32_t mid;
+    if (best_split >= 0) {
+        mid = begin;
+        for (uint32_t i = begin; i < end; i++) {
+            if (bin_of(i) < best_split) {
+                std::swap(refs[i], refs[mid]);
+                std::swap(bounds[i], bounds[mid]);
+                std::swap(centroids[i], centroids[mid]);
+                mid++;
+            }
+        }
+    } else {
+        // SAHで有効な分割が無いが葉に収まらない場合は重心の中央値で分割する
+        mid = begin + count / 2;
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; i++)
+            order[i] = begin + i;
+        std::nth_element(order.begin(), order.begin() + count / 2, order.end(), [&](uint32_t l, uint32_t r) {
+            return centroids[l].elements[axis] < centroids[r].elements[axis];
+        });
+        std::vector<PrimRef> tmp_refs(count);
+        std::vector<AABB> tmp_bounds(count);
+        std::vector<Vec3> tmp_centroids(count);
+        for (uint32_t i = 0; i < count; i++) {
+            tmp_refs[i] = refs[order[i]];
+            tmp_bounds[i] = bounds[order[i]];
+            tmp_centroids[i] = centroids[order[i]];
+        }
+        std::copy(tmp_refs.begin(), tmp_refs.end(), refs.begin() + begin);
+        std::copy(tmp_bounds.begin(), tmp_bounds.end(), bounds.begin() + begin);
+        std::copy(tmp_centroids.begin(), tmp_centroids.end(), centroids.begin() + begin);
+    }
+
+    build_recursive(nodes, refs, bounds, centroids, begin, mid, depth + 1);
+    nodes[index].offset = build_recursive(nodes, refs, bounds, centroids, mid, end, depth + 1);
+    nodes[index].count = 0;
+    return index;
+}
@@ -0,0 +1,114 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+#include "futaba/render/checkpoint.h"
+
+namespace {
+    const char CHECKPOINT_MAGIC[8] = {'F', 'T', 'B', 'C', 'K', 'P', 'T', '1'};
+
+    struct CheckpointHeader {
+        uint32_t width;
+        uint32_t height;
+        uint32_t aov_mask;
+        uint32_t tile_size;
+        uint64_t seed;
+        uint32_t spp;
+        uint32_t passes;
+    };
+
+    // gzreadとgzwriteは一度に扱えるバイト数がunsignedに制限されるため分割する
+    const size_t GZ_BLOCK_BYTES = 1u << 30;
+
+    void gz_write_all(gzFile gz, const void *data, size_t size, const std::string &path) {
+        auto p = static_cast<const char *>(data);
+        while (size > 0) {
+            auto n = static_cast<unsigned>(std::min(size, GZ_BLOCK_BYTES));
+            if (gzwrite(gz, p, n) != static_cast<int>(n))
+                throw std::runtime_error("failed to write checkpoint: " + path);
+            p += n;
+            size -= n;
+        }
+    }
+
+    void gz_read_all(gzFile gz, void *data, size_t size, const std::string &path) {
+        auto p = static_cast<char *>(data);
+        while (size > 0) {
+            auto n = static_cast<unsigned>(std::min(size, GZ_BLOCK_BYTES));
+            if (gzread(gz, p, n) != static_cast<int>(n))
+                throw std::runtime_error("truncated checkpoint: " + path);
+            p += n;
+            size -= n;
+        }
+    }
+}
+
+void save_checkpoint(const std::string &path, const Framebuffer &fb, const RenderState &state) {
+    std::string tmp_path = path + ".tmp";
+    // 累積バッファは隣接画素の値が近いため、速度を優先した圧縮レベルでも十分に小さくなる
+    gzFile gz = gzopen(tmp_path.c_str(), "wb1");
+    if (!gz)
+        throw std::runtime_error("failed to open: " + tmp_path);
+
+    CheckpointHeader header{};
+    header.width = static_cast<uint32_t>(fb.width);
+    header.height = static_cast<uint32_t>(fb.height);
+    header.aov_mask = fb.aov_mask;
+    header.tile_size = static_cast<uint32_t>(fb.tile_size);
+    header.seed = state.seed;
+    header.spp = static_cast<uint32_t>(state.spp);
+    header.passes = static_cast<uint32_t>(state.passes);
+
+    try {
+        gz_write_all(gz, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), tmp_path);
+        gz_write_all(gz, &header, sizeof(header), tmp_path);
+        gz_write_all(gz, fb.storage(), fb.storage_floats() * sizeof(float), tmp_path);
+    } catch (...) {
+        gzclose(gz);
+        throw;
+    }
+    if (gzclose(gz) != Z_OK)
+        throw std::runtime_error("failed to close: " + tmp_path);
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("failed to rename: " + tmp_path);
+}
+
+bool load_checkpoint(const std::string &path, Framebuffer &fb, RenderState &state) {
+    FILE *fp = std::fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+    std::fclose(fp);
+
+    gzFile gz = gzopen(path.c_str(), "rb");
+    if (!gz)
+        throw std::runtime_error("failed to open: " + path);
+
+    try {
+        char magic[sizeof(CHECKPOINT_MAGIC)];
+        gz_read_all(gz, magic, sizeof(magic), path);
+        if (std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0)
+            throw std::runtime_error("not a checkpoint: " + path);
+
+        CheckpointHeader header{};
+        gz_read_all(gz, &header, sizeof(header), path);
+        if (header.width != static_cast<uint32_t>(fb.width) || header.height != static_cast<uint32_t>(fb.height) ||
+            header.aov_mask != fb.aov_mask || header.tile_size != static_cast<uint32_t>(fb.tile_size))
+            throw std::runtime_error("checkpoint does not match the framebuffer: " + path);
+
+        gz_read_all(gz, fb.storage(), fb.storage_floats() * sizeof(float), path);
+        state.seed = header.seed;
+        state.spp = static_cast<int>(header.spp);
+        state.passes = static_cast<int>(header.passes);
+    } catch (...) {
+        gzclose(gz);
+        throw;
+    }
+    gzclose(gz);
+    return true;
+}
@@ -0,0 +1,254 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
+#include <vector>
+#include "futaba/core/socket.h"
+#include "futaba/core/thread_pool.h"
+#include "futaba/render/distributed.h"
+
+namespace {
+    // 送信途中で停止したワーカによってコーディネータ全体が止まらないようにするための受信タイムアウト
+    const double WORKER_RECV_TIMEOUT = 30.0;
+
+    struct WorkerConnection {
+        Socket socket;
+        // 処理中のタイル(-1は割り当てなし)
+        int tile = -1;
+        bool waiting = false;
+        std::chrono::steady_clock::time_point assigned_at;
+    };
+}
+
+void TileCoordinator::run(Framebuffer &fb, const Renderer &renderer, int passes) const {
+    const PathIntegrator &integrator = renderer.integrator;
+    // 環境光の画像と放射輝度キャッシュはワーカに送れないため、設定を黙って無視せずに拒否する
+    if (integrator.environment || integrator.cache)
+        throw std::runtime_error("distributed rendering does not support environment lights or radiance caches");
+
+    FrameSettings settings{};
+    settings.width = static_cast<uint32_t>(fb.width);
+    settings.height = static_cast<uint32_t>(fb.height);
+    settings.aov_mask = fb.aov_mask;
+    settings.tile_size = static_cast<uint32_t>(fb.tile_size);
+    settings.spp = static_cast<uint32_t>(renderer.spp);
+    settings.passes = static_cast<uint32_t>(passes);
+    settings.seed = renderer.seed;
+    settings.pixel_order = static_cast<uint32_t>(renderer.pixel_order);
+    settings.mode = static_cast<uint32_t>(integrator.mode);
+    settings.max_depth = static_cast<uint32_t>(integrator.max_depth);
+    settings.roulette_depth = static_cast<uint32_t>(integrator.roulette_depth);
+    settings.roulette = integrator.roulette;
+    for (int k = 0; k < 3; k++)
+        settings.background[k] = integrator.background.elements[k];
+    settings.packet_size = static_cast<uint32_t>(integrator.packet_size);
+    settings.ray_order = static_cast<uint32_t>(integrator.ray_order);
+    settings.ray_order_bits = static_cast<uint32_t>(integrator.ray_order_bits);
+
+    Socket server = Socket::listen(address);
+
+    int tile_count = fb.tiles_x * fb.tiles_y;
+    size_t tile_bytes = fb.tile_floats() * sizeof(float);
+    std::deque<int> pending;
+    for (int i = 0; i < tile_count; i++)
+        pending.push_back(i);
+    std::vector<bool> done(tile_count, false);
+    int done_count = 0;
+
+    std::vector<std::unique_ptr<WorkerConnection>> workers;
+
+    // ワーカを切り離し、処理中のタイルがあれば優先して再割り当てされるように先頭に戻す
+    auto drop = [&](WorkerConnection &w) {
+        if (w.tile >= 0 && !done[w.tile])
+            pending.push_front(w.tile);
+        w.tile = -1;
+        w.socket.close();
+    };
+
+    auto handle = [&](WorkerConnection &w, const Message &msg) {
+        switch (msg.type) {
+            case DIST_HELLO:
+                w.socket.send_message(DIST_FRAME, &settings, sizeof(settings));
+                break;
+            case DIST_REQUEST:
+                w.waiting = true;
+                break;
+            case DIST_RESULT: {
+                size_t offset = 0;
+                auto tile = static_cast<int>(get_value<uint32_t>(msg.payload, offset));
+                if (tile != w.tile || msg.payload.size() != offset + tile_bytes)
+                    throw std::runtime_error("unexpected tile result");
+                // タイムアウトにより再割り当てされたタイルが先に完了していた場合は破棄する
+                if (!done[tile]) {
+                    std::memcpy(fb.tile(tile % fb.tiles_x, tile / fb.tiles_x), msg.payload.data() + offset, tile_bytes);
+                    done[tile] = true;
+                    done_count++;
+                }
+                // 結果の送信は次のタイルの要求を兼ねる
+                w.tile = -1;
+                w.waiting = true;
+                break;
+            }
+            default:
+                throw std::runtime_error("unknown message");
+        }
+    };
+
+    while (done_count < tile_count) {
+        // 待機中のワーカに未処理のタイルを割り当てる
+        for (auto &w: workers) {
+            if (!w->socket.is_open() || !w->waiting || pending.empty())
+                continue;
+            int tile = pending.front();
+            pending.pop_front();
+            w->waiting = false;
+            w->tile = tile;
+            w->assigned_at = std::chrono::steady_clock::now();
+            try {
+                auto index = static_cast<uint32_t>(tile);
+                w->socket.send_message(DIST_TILE, &index, sizeof(index));
+            } catch (const std::runtime_error &) {
+                drop(*w);
+            }
+        }
+
+        std::vector<pollfd> fds;
+        fds.push_back({server.handle(), POLLIN, 0});
+        for (auto &w: workers)
+            fds.push_back({w->socket.handle(), POLLIN, 0});
+
+        int timeout_ms = tile_timeout > 0.0 ? 1000 : -1;
+        if (::poll(fds.data(), fds.size(), timeout_ms) < 0 && errno != EINTR)
+            throw std::runtime_error("poll failed");
+
+        if (fds[0].revents & POLLIN) {
+            std::unique_ptr<WorkerConnection> w(new WorkerConnection());
+            w->socket = server.accept();
+            w->socket.set_recv_timeout(WORKER_RECV_TIMEOUT);
+            workers.push_back(std::move(w));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 1; i < fds.size(); i++) {
+            WorkerConnection &w = *workers[i - 1];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                try {
+                    handle(w, w.socket.recv_message());
+                } catch (const std::runtime_error &e) {
+                    std::cerr << "worker lost: " << e.what() << std::endl;
+                    drop(w);
+                }
+            } else if (tile_timeout > 0.0 && w.tile >= 0 &&
+                       std::chrono::duration<double>(now - w.assigned_at).count() > tile_timeout) {
+                std::cerr << "worker timed out on tile " << w.tile << std::endl;
+                drop(w);
+            }
+        }
+
+        workers.erase(std::remove_if(workers.begin(), workers.end(),
+                                     [](const std::unique_ptr<WorkerConnection> &w) {
+                                         return !w->socket.is_open();
+                                     }), workers.end());
+    }
+
+    // 接続中のワーカには完了を通知する(要求を送信する前のワーカは次の要求に対する応答として受け取る)
+    for (auto &w: workers) {
+        try {
+            w->socket.send_message(DIST_DONE, nullptr, 0);
+        } catch (const std::runtime_error &) {
+        }
+    }
+}
+
+namespace {
+    // 1つの接続でDIST_DONEを受信するまでタイルをレンダリングし、レンダリングしたタイルの数を返す
+    int serve_tiles(const std::string &address, const Aggregate &aggregate, const Camera &camera) {
+        Socket socket = Socket::connect(address);
+        socket.send_message(DIST_HELLO, nullptr, 0);
+
+        Message msg = socket.recv_message();
+        if (msg.type != DIST_FRAME || msg.payload.size() != sizeof(FrameSettings))
+            throw std::runtime_error("unexpected frame settings");
+        FrameSettings settings{};
+        std::memcpy(&settings, msg.payload.data(), sizeof(settings));
+
+        Framebuffer fb(static_cast<int>(settings.height), static_cast<int>(settings.width), settings.aov_mask, "",
+                       static_cast<int>(settings.tile_size));
+        if (fb.aov_mask != settings.aov_mask)
+            throw std::runtime_error("unsupported aov mask");
+        Renderer renderer(static_cast<int>(settings.spp), 1, static_cast<int>(settings.tile_size), settings.seed);
+        renderer.pixel_order = static_cast<TraversalOrder>(settings.pixel_order);
+        PathIntegrator &integrator = renderer.integrator;
+        integrator.mode = static_cast<IntegratorMode>(settings.mode);
+        integrator.max_depth = static_cast<int>(settings.max_depth);
+        integrator.roulette_depth = static_cast<int>(settings.roulette_depth);
+        integrator.roulette = settings.roulette;
+        integrator.background = Vec3(settings.background[0], settings.background[1], settings.background[2]);
+        integrator.packet_size = static_cast<int>(settings.packet_size);
+        integrator.ray_order = static_cast<RayOrder>(settings.ray_order);
+        integrator.ray_order_bits = static_cast<int>(settings.ray_order_bits);
+
+        /*
+         * 全てのタイルが完了するとコーディネータは直ちに接続を閉じる
+         * そのため送信に失敗しても、既に届いているDIST_DONEを受信できればワーカは正常に終了する
+         */
+        auto send_or_ignore = [&](uint32_t type, const std::vector<uint8_t> &payload) {
+            try {
+                socket.send_message(type, payload);
+            } catch (const std::runtime_error &) {
+            }
+        };
+
+        int rendered = 0;
+        send_or_ignore(DIST_REQUEST, std::vector<uint8_t>());
+        while (true) {
+            msg = socket.recv_message();
+            if (msg.type == DIST_DONE)
+                break;
+            if (msg.type != DIST_TILE)
+                throw std::runtime_error("unexpected message");
+
+            size_t offset = 0;
+            auto tile = get_value<uint32_t>(msg.payload, offset);
+            int tx = static_cast<int>(tile) % fb.tiles_x;
+            int ty = static_cast<int>(tile) / fb.tiles_x;
+            int x0 = tx * fb.tile_size;
+            int y0 = ty * fb.tile_size;
+            int x1 = std::min(x0 + fb.tile_size, fb.width);
+            int y1 = std::min(y0 + fb.tile_size, fb.height);
+            for (uint32_t p = 0; p < settings.passes; p++)
+                renderer.render_tile(aggregate, camera, fb, x0, y0, x1, y1);
+
+            // 結果の送信は次のタイルの要求を兼ねる
+            std::vector<uint8_t> payload;
+            put_value(payload, tile);
+            auto data = reinterpret_cast<const uint8_t *>(fb.tile(tx, ty));
+            payload.insert(payload.end(), data, data + fb.tile_floats() * sizeof(float));
+            send_or_ignore(DIST_RESULT, payload);
+            rendered++;
+        }
+        return rendered;
+    }
+}
+
+int run_tile_worker(const std::string &address, const Aggregate &aggregate, const Camera &camera, int threads) {
+    ThreadPool pool(threads);
+    std::vector<int> rendered(pool.size(), 0);
+    pool.parallel_for(pool.size(), [&](int i) {
+        rendered[i] = serve_tiles(address, aggregate, camera);
+    });
+
+    int total = 0;
+    for (int n: rendered)
+        total += n;
+    return total;
+}
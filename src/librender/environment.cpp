@@ -0,0 +1,97 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include "stb_image.h"
+#include "futaba/core/config.h"
+#include "futaba/render/environment.h"
+
+namespace {
+    float luminance(const float *rgb) {
+        return 0.2126f * rgb[0] + 0.7152f * rgb[1] + 0.0722f * rgb[2];
+    }
+}
+
+EnvironmentLight::EnvironmentLight(const std::string &path, float _scale) : scale(_scale), w(0), h(0) {
+    int comp = 0;
+    std::unique_ptr<float, void (*)(void *)> pixels(stbi_loadf(path.c_str(), &w, &h, &comp, 3), stbi_image_free);
+    if (!pixels)
+        throw std::runtime_error("failed to load environment: " + path + " (" + stbi_failure_reason() + ")");
+    rgb.assign(pixels.get(), pixels.get() + 3 * static_cast<size_t>(w) * h);
+    build();
+}
+
+EnvironmentLight::EnvironmentLight(int _width, int _height, std::vector<float> _rgb, float _scale) :
+        scale(_scale), w(_width), h(_height), rgb(std::move(_rgb)) {
+    if (w <= 0 || h <= 0 || rgb.size() != 3 * static_cast<size_t>(w) * h)
+        throw std::runtime_error("environment size does not match the pixel array");
+    build();
+}
+
+void EnvironmentLight::build() {
+    // 各行の条件付き分布と、行の重みの合計による周辺分布を求める
+    std::vector<float> row_weights(h);
+    std::vector<float> weights(w);
+    columns.clear();
+    columns.reserve(h);
+    for (int y = 0; y < h; y++) {
+        float sin_theta = std::sin(PI * (static_cast<float>(y) + 0.5f) / static_cast<float>(h));
+        for (int x = 0; x < w; x++)
+            weights[x] = std::max(0.0f, luminance(&rgb[3 * (static_cast<size_t>(y) * w + x)])) * sin_theta;
+        columns.emplace_back(weights);
+        row_weights[y] = columns.back().sum();
+    }
+    rows = AliasTable(row_weights);
+}
+
+void EnvironmentLight::pixel_of(const Vec3 &direction, int &x, int &y, float &sin_theta) const {
+    float cos_theta = std::max(-1.0f, std::min(1.0f, direction.y()));
+    float theta = std::acos(cos_theta);
+    float phi = std::atan2(direction.z(), direction.x());
+    if (phi < 0.0f)
+        phi += 2.0f * PI;
+    x = std::min(static_cast<int>(phi / (2.0f * PI) * static_cast<float>(w)), w - 1);
+    y = std::min(static_cast<int>(theta / PI * static_cast<float>(h)), h - 1);
+    sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+}
+
+Vec3 EnvironmentLight::eval(const Vec3 &direction) const {
+    int x, y;
+    float sin_theta;
+    pixel_of(direction, x, y, sin_theta);
+    const float *p = &rgb[3 * (static_cast<size_t>(y) * w + x)];
+    return scale * Vec3(p[0], p[1], p[2]);
+}
+
+Vec3 EnvironmentLight::sample(Sampler &sampler, Vec3 &wi, float &pdf) const {
+    float ry, rx;
+    auto y = static_cast<int>(rows.sample(sampler.next(), &ry));
+    auto x = static_cast<int>(columns[y].sample(sampler.next(), &rx));
+
+    // 画素内の位置は選択に使わなかった端数で決める
+    float theta = PI * (static_cast<float>(y) + ry) / static_cast<float>(h);
+    float phi = 2.0f * PI * (static_cast<float>(x) + rx) / static_cast<float>(w);
+    float sin_theta = std::sin(theta);
+    wi = Vec3(sin_theta * std::cos(phi), std::cos(theta), sin_theta * std::sin(phi));
+
+    // 画素の選択確率を画素の立体角(2π^2 sinθ / (w h))で割る
+    float pmf = rows.pmf(y) * columns[y].pmf(x);
+    pdf = sin_theta > 0.0f ? pmf * static_cast<float>(w) * static_cast<float>(h) / (2.0f * PI * PI * sin_theta)
+                           : 0.0f;
+    const float *p = &rgb[3 * (static_cast<size_t>(y) * w + x)];
+    return scale * Vec3(p[0], p[1], p[2]);
+}
+
+float EnvironmentLight::pdf(const Vec3 &direction) const {
+    int x, y;
+    float sin_theta;
+    pixel_of(direction, x, y, sin_theta);
+    if (sin_theta <= 0.0f)
+        return 0.0f;
+    float pmf = rows.pmf(y) * columns[y].pmf(x);
+    return pmf * static_cast<float>(w) * static_cast<float>(h) / (2.0f * PI * PI * sin_theta);
+}
@@ -0,0 +1,39 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <stdexcept>
+#include "futaba/render/aggregate.h"
+#include "futaba/render/instance.h"
+
+Instance::Instance(std::shared_ptr<const Aggregate> _prototype, const Transform &_to_world) :
+        prototype(std::move(_prototype)), to_world(_to_world), to_local(_to_world.inverse()) {
+    if (!prototype)
+        throw std::runtime_error("instance requires a prototype");
+}
+
+AABB Instance::bounds() const {
+    return to_world.apply_bounds(prototype->bounds());
+}
+
+bool Instance::is_hittable(Ray &ray, HitRecord &hit_record) const {
+    /*
+     * 各プリミティブの衝突判定はレイの方向ベクトルが正規化されていることを前提とするため、
+     * 変換後の方向ベクトルを正規化し、距離はその長さで換算する
+     */
+    Vec3 local_direction = to_local.apply_vector(ray.direction);
+    float scale = local_direction.length();
+    Ray local_ray(to_local.apply_point(ray.origin), local_direction / scale);
+
+    HitRecord local_hit;
+    local_hit.t = hit_record.t * scale;
+    if (!prototype->intersect(local_ray, local_hit))
+        return false;
+
+    hit_record = local_hit;
+    hit_record.t = local_hit.t / scale;
+    hit_record.hit_uv_extent = local_hit.hit_uv_extent / scale;
+    hit_record.hit_pos = ray(hit_record.t);
+    hit_record.hit_normal = unit_vec(to_local.apply_normal(local_hit.hit_normal));
+    return true;
+}
@@ -0,0 +1,301 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <chrono>
+#include "futaba/core/traversal_order.h"
+#include "futaba/render/integrator.h"
+
+namespace {
+    // 拡散反射の後のレイコーンの広がり(ラジアン)
+    const float DIFFUSE_CONE_SPREAD = 1.0f;
+    // 光源へのシャドウレイを打ち切る距離の割合
+    const float SHADOW_EPSILON = 1e-3f;
+
+    typedef bool (*ScatterFunc)(const MaterialTable &, MaterialId, const Vec3 &, const Vec3 &, Sampler &, Vec3 &,
+                                Vec3 &);
+
+    // パワーヒューリスティック(指数2)によるMISの重み
+    float power_heuristic(float pdf, float other_pdf) {
+        float a = pdf * pdf;
+        float b = other_pdf * other_pdf;
+        return a + b > 0.0f ? a / (a + b) : 0.0f;
+    }
+
+    /*
+     * 拡散反射の面で環境光をサンプリングし、遮蔽されていなければ直接光を加える
+     * nsは光を受ける側の法線、albedoはテクスチャを含めた衝突位置でのalbedo
+     * misの場合は同じ方向を拡散反射でサンプリングする確率密度と比べて重み付けする
+     */
+    void sample_environment(const Aggregate &aggregate, const EnvironmentLight &environment, PathState &path,
+                            const HitRecord &hit, const Vec3 &ns, const Vec3 &albedo, bool mis) {
+        Vec3 wl;
+        float pdf;
+        Vec3 radiance = environment.sample(path.sampler, wl, pdf);
+        float cos = dot(ns, wl);
+        if (pdf <= 0.0f || cos <= 0.0f || aggregate.occluded(Ray(hit.hit_pos, wl), HIT_DISTANCE_MAX))
+            return;
+        float weight = mis ? power_heuristic(pdf, cos / PI) : 1.0f;
+        path.radiance += path.throughput * albedo * radiance * (weight * cos / (PI * pdf));
+    }
+
+    // 拡散反射の面でライトBVHから光源上の点をサンプリングし、遮蔽されていなければ直接光を加える
+    void sample_lights(const Aggregate &aggregate, PathState &path, const HitRecord &hit, const Vec3 &ns,
+                       const Vec3 &albedo, bool mis) {
+        LightSample ls;
+        if (!aggregate.lights.sample(hit.hit_pos, ns, path.sampler, ls) || ls.pdf <= 0.0f)
+            return;
+        Vec3 to_light = ls.position - hit.hit_pos;
+        float dist = to_light.length();
+        Vec3 wl = to_light / dist;
+        float cos = dot(ns, wl);
+        // 光源自身に衝突しないよう、シャドウレイは光源の手前で止める
+        if (cos <= 0.0f || aggregate.occluded(Ray(hit.hit_pos, wl), dist * (1.0f - SHADOW_EPSILON)))
+            return;
+        float weight = mis ? power_heuristic(ls.pdf, cos / PI) : 1.0f;
+        path.radiance += path.throughput * albedo * ls.emission * (weight * cos / (PI * ls.pdf));
+    }
+
+    /*
+     * activeの経路をレイの始点(boundsで量子化したMorton符号)と方向の象限で並べ替える
+     * keysは作業用の配列
+     */
+    void reorder_rays(const std::vector<PathState> &paths, std::vector<uint32_t> &active, const AABB &bounds,
+                      RayOrder order, int bits, std::vector<uint64_t> &keys) {
+        // 象限の3ビットと合わせてキーを32ビットに収める
+        bits = std::min(std::max(bits, 1), 9);
+        auto cells = static_cast<float>(1u << static_cast<uint32_t>(bits));
+        Vec3 extent = bounds.max - bounds.min;
+        Vec3 scale;
+        for (int k = 0; k < 3; k++)
+            scale.elements[k] = extent.elements[k] > 0.0f ? cells / extent.elements[k] : 0.0f;
+
+        keys.clear();
+        for (uint32_t i: active) {
+            const Ray &ray = paths[i].ray;
+            uint32_t q[3];
+            for (int k = 0; k < 3; k++) {
+                float c = (ray.origin.elements[k] - bounds.min.elements[k]) * scale.elements[k];
+                q[k] = static_cast<uint32_t>(std::min(std::max(c, 0.0f), cells - 1.0f));
+            }
+            uint64_t key = morton_encode3(q[0], q[1], q[2]);
+            if (order == RAY_ORDER_OCTANT_ORIGIN) {
+                uint64_t octant = (ray.direction.x() < 0.0f ? 1u : 0u) | (ray.direction.y() < 0.0f ? 2u : 0u) |
+                                  (ray.direction.z() < 0.0f ? 4u : 0u);
+                key |= octant << (3u * static_cast<uint32_t>(bits));
+            }
+            keys.push_back(key << 32u | i);
+        }
+        std::sort(keys.begin(), keys.end());
+        for (size_t j = 0; j < keys.size(); j++)
+            active[j] = static_cast<uint32_t>(keys[j]);
+    }
+
+    /*
+     * 同じ材質の経路の区間[begin, end)を散乱させ、継続する経路をnext_activeに追加する
+     * 散乱の関数はテンプレート引数として渡すため、区間内のループに直接展開される
+     * spread_minは散乱後のレイコーンの広がりの下限
+     * Diffuseの場合は散乱の前に環境光とライトBVHの光源のNEEを行い、散乱の確率密度をMISのために残す
+     */
+    template<ScatterFunc Scatter, bool Diffuse>
+    void scatter_run(const Aggregate &aggregate, MaterialId id, const uint64_t *begin, const uint64_t *end,
+                     std::vector<PathState> &paths, const std::vector<HitRecord> &hits, int depth,
+                     float spread_min, const PathIntegrator &integrator, std::vector<uint32_t> &next_active) {
+        const MaterialTable &table = aggregate.materials;
+        bool textured = table.albedo_texture[id] != NO_TEXTURE;
+        bool nee = Diffuse && integrator.mode != INTEGRATOR_BSDF;
+        bool mis = integrator.mode == INTEGRATOR_MIS;
+        const EnvironmentLight *environment = nee ? integrator.environment.get() : nullptr;
+        bool lights = nee && !aggregate.lights.empty();
+        RadianceCache *cache = Diffuse ? integrator.cache.get() : nullptr;
+        for (const uint64_t *key = begin; key != end; key++) {
+            auto i = static_cast<uint32_t>(*key);
+            PathState &path = paths[i];
+            const HitRecord &hit = hits[i];
+
+            path.cone_width += path.cone_spread * hit.t;
+            // 各散乱の重みはalbedoに比例するため、テクスチャの値をそのまま掛ける
+            Vec3 texture = textured ? table.texture_at(id, hit, path.cone_width) : Vec3(1.0f);
+            Vec3 ns = dot(path.ray.direction, hit.hit_normal) < 0.0f ? hit.hit_normal : -hit.hit_normal;
+            Vec3 albedo = table.albedo[id] * texture;
+            if (cache) {
+                // 2回目以降の拡散反射で、レイコーンがセルより広ければキャッシュの値で経路を終了する
+                Vec3 cached;
+                if (path.diffuse_bounces > 0 && path.cone_width >= cache->cell_size &&
+                    cache->lookup(hit.hit_pos, ns, cached)) {
+                    path.radiance += path.throughput * albedo * cached;
+                    continue;
+                }
+                if (path.cache_records < PATH_CACHE_RECORDS)
+                    path.records[path.cache_records++] = {hit.hit_pos, ns, path.radiance, path.throughput * albedo};
+                path.diffuse_bounces++;
+            }
+            if (environment)
+                sample_environment(aggregate, *environment, path, hit, ns, albedo, mis);
+            if (lights)
+                sample_lights(aggregate, path, hit, ns, albedo, mis);
+            path.specular = !Diffuse;
+
+            Vec3 wi, weight;
+            if (!Scatter(table, id, path.ray.direction, hit.hit_normal, path.sampler, wi, weight))
+                continue;
+            path.cone_spread = std::max(path.cone_spread, spread_min);
+            path.throughput *= weight * texture;
+            if (Diffuse) {
+                path.prev_pos = hit.hit_pos;
+                path.prev_normal = ns;
+                path.bsdf_pdf = std::max(0.0f, dot(ns, wi)) / PI;
+            }
+
+            if (depth + 1 >= integrator.max_depth)
+                continue;
+            if (depth + 1 >= integrator.roulette_depth) {
+                if (path.sampler.next() >= integrator.roulette)
+                    continue;
+                path.throughput /= integrator.roulette;
+            }
+            path.ray = Ray(hit.hit_pos, wi);
+            next_active.push_back(i);
+        }
+    }
+}
+
+void PathIntegrator::trace(const Aggregate &aggregate, std::vector<PathState> &paths,
+                           std::vector<HitRecord> &first_hits, std::vector<uint8_t> &first_is_hit) const {
+    const MaterialTable &table = aggregate.materials;
+    first_hits.assign(paths.size(), HitRecord());
+    first_is_hit.assign(paths.size(), 0);
+
+    std::vector<HitRecord> hits(paths.size());
+    std::vector<uint32_t> active(paths.size());
+    for (uint32_t i = 0; i < active.size(); i++)
+        active[i] = i;
+    std::vector<uint32_t> next_active;
+    // (材質の番号 << 32) | 経路の番号
+    std::vector<uint64_t> keys;
+    std::vector<Ray> packet_rays;
+    std::vector<uint8_t> packet_hit;
+    AABB bounds = ray_order != RAY_ORDER_NONE ? aggregate.bounds() : AABB();
+    uint64_t secondary_rays = 0;
+    std::chrono::steady_clock::duration primary_time(0), secondary_time(0);
+
+    for (int depth = 0; !active.empty(); depth++) {
+        auto intersect_begin = stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        if (depth > 0 && ray_order != RAY_ORDER_NONE && active.size() >= RAY_ORDER_MIN_RAYS && !bounds.is_empty())
+            reorder_rays(paths, active, bounds, ray_order, ray_order_bits, keys);
+        // 一次レイは画素の順に並んでおり揃っているため、パケットとしてまとめて判定する
+        // depth == 0ではactive[i] == iのため、結果は経路の番号でそのまま参照できる
+        bool packets = depth == 0 && packet_size > 0;
+        if (packets) {
+            packet_rays.clear();
+            for (uint32_t i: active)
+                packet_rays.push_back(paths[i].ray);
+            packet_hit.resize(packet_rays.size());
+            aggregate.intersect_packet(packet_rays.data(), hits.data(), packet_hit.data(), packet_rays.size(),
+                                       packet_size);
+        }
+        keys.clear();
+        for (uint32_t i: active) {
+            PathState &path = paths[i];
+            bool is_hit;
+            if (packets) {
+                is_hit = packet_hit[i] != 0;
+            } else {
+                hits[i] = HitRecord();
+                is_hit = aggregate.intersect(path.ray, hits[i]);
+            }
+            // 材質の表に存在しない番号は既定の材質として扱う
+            if (hits[i].hit_material >= table.size())
+                hits[i].hit_material = 0;
+            if (depth == 0) {
+                first_hits[i] = hits[i];
+                first_is_hit[i] = is_hit;
+            }
+            if (!is_hit) {
+                if (!environment)
+                    path.radiance += path.throughput * background;
+                else if (path.specular || mode == INTEGRATOR_BSDF)
+                    path.radiance += path.throughput * environment->eval(path.ray.direction);
+                else if (mode == INTEGRATOR_MIS)
+                    path.radiance += path.throughput * environment->eval(path.ray.direction) *
+                                     power_heuristic(path.bsdf_pdf, environment->pdf(path.ray.direction));
+                continue;
+            }
+            keys.push_back(static_cast<uint64_t>(hits[i].hit_material) << 32u | i);
+        }
+        if (stats && depth == 0) {
+            primary_time = std::chrono::steady_clock::now() - intersect_begin;
+        } else if (stats) {
+            secondary_rays += active.size();
+            secondary_time += std::chrono::steady_clock::now() - intersect_begin;
+        }
+        std::sort(keys.begin(), keys.end());
+
+        next_active.clear();
+        for (size_t begin = 0; begin < keys.size();) {
+            auto id = static_cast<MaterialId>(keys[begin] >> 32u);
+            size_t end = begin;
+            while (end < keys.size() && static_cast<MaterialId>(keys[end] >> 32u) == id)
+                end++;
+
+            const uint64_t *run_begin = keys.data() + begin;
+            const uint64_t *run_end = keys.data() + end;
+            switch (table.type[id]) {
+                case MAT_DIFFUSE:
+                    scatter_run<scatter_diffuse, true>(aggregate, id, run_begin, run_end, paths, hits, depth,
+                                                       DIFFUSE_CONE_SPREAD, *this, next_active);
+                    break;
+                case MAT_METAL:
+                    scatter_run<scatter_metal, false>(aggregate, id, run_begin, run_end, paths, hits, depth,
+                                                      table.roughness[id], *this, next_active);
+                    break;
+                case MAT_DIELECTRIC:
+                    scatter_run<scatter_dielectric, false>(aggregate, id, run_begin, run_end, paths, hits, depth,
+                                                           0.0f, *this, next_active);
+                    break;
+                case MAT_EMISSIVE:
+                default:
+                    // 光源は反射しないため経路を終了する
+                    // 拡散反射の後に到達したライトBVHの光源はNEEでも数えているため、モードに応じて重みを変える
+                    for (const uint64_t *key = run_begin; key != run_end; key++) {
+                        auto i = static_cast<uint32_t>(*key);
+                        PathState &path = paths[i];
+                        float weight = 1.0f;
+                        int light = path.specular || mode == INTEGRATOR_BSDF
+                                    ? -1 : aggregate.lights.find(hits[i].hit_id, hits[i].hit_prim);
+                        if (light >= 0 && mode == INTEGRATOR_NEE)
+                            continue;
+                        if (light >= 0)
+                            weight = power_heuristic(path.bsdf_pdf, aggregate.lights.pdf(
+                                    path.prev_pos, path.prev_normal, light, hits[i].hit_pos));
+                        path.radiance += path.throughput * table.emission[id] * weight;
+                    }
+                    break;
+            }
+            begin = end;
+        }
+        active.swap(next_active);
+    }
+    if (stats) {
+        stats->primary_rays.fetch_add(paths.size(), std::memory_order_relaxed);
+        stats->primary_nanoseconds.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(primary_time).count()), std::memory_order_relaxed);
+        stats->secondary_rays.fetch_add(secondary_rays, std::memory_order_relaxed);
+        stats->secondary_nanoseconds.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(secondary_time).count()), std::memory_order_relaxed);
+    }
+
+    // 記録した拡散反射から先で得た放射輝度をalbedoで割ってキャッシュに加える
+    if (cache) {
+        for (const PathState &path: paths) {
+            for (int r = 0; r < path.cache_records; r++) {
+                const CacheRecord &record = path.records[r];
+                // 重みが0の成分は値が定まらないため、その拡散反射は加えない
+                const Vec3 &w = record.weight;
+                if (w.x() > 0.0f && w.y() > 0.0f && w.z() > 0.0f)
+                    cache->add(record.position, record.normal, (path.radiance - record.radiance) / w);
+            }
+        }
+    }
+}
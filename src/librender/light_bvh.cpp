@@ -0,0 +1,444 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "futaba/core/config.h"
+#include "futaba/render/light_bvh.h"
+#include "futaba/render/material.h"
+
+namespace {
+    const int LIGHT_BIN_COUNT = 12;
+    // これより深いノードではビン分割を行わず中央で分割し、偏った木で深さが増え続けないようにする
+    const int LIGHT_SAH_DEPTH_MAX = 64;
+
+    // 方向コーン(角度で保持する)
+    struct Cone {
+        Vec3 axis;
+        float theta_o;
+        float theta_e;
+        bool empty;
+
+        Cone() : axis(0.0f, 0.0f, 1.0f), theta_o(0.0f), theta_e(0.0f), empty(true) {};
+
+        Cone(const Vec3 &_axis, float _theta_o, float _theta_e) :
+                axis(_axis), theta_o(_theta_o), theta_e(_theta_e), empty(false) {};
+    };
+
+    uint64_t light_key(int hit_id, uint32_t hit_prim) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(hit_id)) << 32u | hit_prim;
+    }
+
+    float luminance(const Vec3 &c) {
+        return 0.2126f * c.x() + 0.7152f * c.y() + 0.0722f * c.z();
+    }
+
+    // 2つの単位ベクトルのなす角(内積のacosより0とπの付近で精度が良い)
+    float angle_between(const Vec3 &a, const Vec3 &b) {
+        if (dot(a, b) < 0.0f)
+            return PI - 2.0f * std::asin(std::min(1.0f, (a + b).length() / 2.0f));
+        return 2.0f * std::asin(std::min(1.0f, (a - b).length() / 2.0f));
+    }
+
+    // 単位ベクトルkを軸にvをtheta回転する(ロドリゲスの回転公式)
+    Vec3 rotate(const Vec3 &v, const Vec3 &k, float theta) {
+        float c = std::cos(theta);
+        float s = std::sin(theta);
+        return v * c + cross(k, v) * s + k * (dot(k, v) * (1.0f - c));
+    }
+
+    Cone cone_union(const Cone &a, const Cone &b) {
+        if (a.empty)
+            return b;
+        if (b.empty)
+            return a;
+        float theta_e = std::max(a.theta_e, b.theta_e);
+        if (a.theta_o >= PI || b.theta_o >= PI)
+            return {a.axis, PI, theta_e};
+
+        float theta_d = angle_between(a.axis, b.axis);
+        if (std::min(theta_d + b.theta_o, PI) <= a.theta_o)
+            return {a.axis, a.theta_o, theta_e};
+        if (std::min(theta_d + a.theta_o, PI) <= b.theta_o)
+            return {b.axis, b.theta_o, theta_e};
+
+        // 両方を含む最小のコーンの軸はaの軸をbの軸の方向に回転したもの
+        float theta_o = (a.theta_o + theta_d + b.theta_o) / 2.0f;
+        if (theta_o >= PI)
+            return {a.axis, PI, theta_e};
+        Vec3 wr = cross(a.axis, b.axis);
+        if (wr.squared_length() == 0.0f)
+            return {a.axis, PI, theta_e};
+        return {unit_vec(rotate(a.axis, unit_vec(wr), theta_o - a.theta_o)), theta_o, theta_e};
+    }
+
+    Cone cone_of(const Light &light) {
+        // 球と三角形はどちらも全方向に放射する
+        if (light.shape == LIGHT_TRIANGLE)
+            return {unit_vec(cross(light.p1 - light.p0, light.p2 - light.p0)), PI, PI / 2.0f};
+        return {Vec3(0.0f, 0.0f, 1.0f), PI, PI / 2.0f};
+    }
+
+    // 方向コーンが放射する立体角の重み(PBRT 4版 式(12.7))
+    float cone_measure(const Cone &cone) {
+        float theta_w = std::min(cone.theta_o + cone.theta_e, PI);
+        float sin_o = std::sin(cone.theta_o);
+        float cos_o = std::cos(cone.theta_o);
+        return 2.0f * PI * (1.0f - cos_o) +
+               PI / 2.0f * (2.0f * theta_w * sin_o - std::cos(cone.theta_o - 2.0f * theta_w) -
+                            2.0f * cone.theta_o * sin_o + cos_o);
+    }
+
+    // cos(max(0, a - b))とsin(max(0, a - b))
+    float cos_sub_clamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+        return cos_a > cos_b ? 1.0f : cos_a * cos_b + sin_a * sin_b;
+    }
+
+    float sin_sub_clamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+        return cos_a > cos_b ? 0.0f : sin_a * cos_b - cos_a * sin_b;
+    }
+
+    float safe_sqrt(float x) {
+        return std::sqrt(std::max(0.0f, x));
+    }
+
+    /*
+     * 光源上の点をサンプリングし、立体角に関する確率密度を求める
+     * 球は外側からは見える範囲のコーン内で一様に、内側からは表面上で一様にサンプリングする
+     * 三角形は面積について一様にサンプリングする
+     */
+    bool sample_point(const Light &light, const Vec3 &p, Sampler &sampler, LightSample &ls) {
+        float u1 = sampler.next();
+        float u2 = sampler.next();
+        ls.emission = light.emission;
+
+        if (light.shape == LIGHT_SPHERE) {
+            float r = light.radius;
+            Vec3 to_center = light.p0 - p;
+            float d2 = to_center.squared_length();
+            if (d2 > r * r) {
+                float d = std::sqrt(d2);
+                float sin2_max = r * r / d2;
+                float cos_max = safe_sqrt(1.0f - sin2_max);
+                // 1 - cos_maxは小さな球で桁落ちするため、sin^2 / (1 + cos)で求める
+                float one_minus_cos_max = sin2_max / (1.0f + cos_max);
+
+                float one_minus_cos = u1 * one_minus_cos_max;
+                float cos_t = 1.0f - one_minus_cos;
+                float sin2_t = one_minus_cos * (2.0f - one_minus_cos);
+                float phi = 2.0f * PI * u2;
+
+                Vec3 wc = to_center / d;
+                Vec3 s, t;
+                make_basis(wc, s, t);
+                float sin_t = safe_sqrt(sin2_t);
+                Vec3 w = cos_t * wc + sin_t * (std::cos(phi) * s + std::sin(phi) * t);
+                float ds = d * cos_t - safe_sqrt(r * r - d2 * sin2_t);
+                ls.position = p + ds * w;
+                ls.normal = unit_vec(ls.position - light.p0);
+                ls.pdf = 1.0f / (2.0f * PI * one_minus_cos_max);
+                return true;
+            }
+
+            float z = 1.0f - 2.0f * u1;
+            float rz = safe_sqrt(1.0f - z * z);
+            float phi = 2.0f * PI * u2;
+            ls.normal = Vec3(rz * std::cos(phi), rz * std::sin(phi), z);
+            ls.position = light.p0 + r * ls.normal;
+        } else {
+            float su = std::sqrt(u1);
+            float b0 = 1.0f - su;
+            float b1 = u2 * su;
+            ls.position = b0 * light.p0 + b1 * light.p1 + (1.0f - b0 - b1) * light.p2;
+            ls.normal = unit_vec(cross(light.p1 - light.p0, light.p2 - light.p0));
+        }
+
+        // 面積に関する確率密度を立体角に関する確率密度に変換する
+        Vec3 wi = ls.position - p;
+        float dist2 = wi.squared_length();
+        float cos_l = std::abs(dot(ls.normal, wi)) / std::sqrt(dist2);
+        if (dist2 == 0.0f || cos_l == 0.0f)
+            return false;
+        ls.pdf = dist2 / (light.area() * cos_l);
+        return true;
+    }
+
+    float pdf_point(const Light &light, const Vec3 &p, const Vec3 &x) {
+        if (light.shape == LIGHT_SPHERE) {
+            float r = light.radius;
+            float d2 = (light.p0 - p).squared_length();
+            if (d2 > r * r) {
+                float sin2_max = r * r / d2;
+                float cos_max = safe_sqrt(1.0f - sin2_max);
+                return 1.0f / (2.0f * PI * sin2_max / (1.0f + cos_max));
+            }
+        }
+        Vec3 n = light.shape == LIGHT_SPHERE ? unit_vec(x - light.p0)
+                                             : unit_vec(cross(light.p1 - light.p0, light.p2 - light.p0));
+        Vec3 wi = x - p;
+        float dist2 = wi.squared_length();
+        float cos_l = std::abs(dot(n, wi)) / std::sqrt(dist2);
+        if (dist2 == 0.0f || cos_l == 0.0f)
+            return 0.0f;
+        return dist2 / (light.area() * cos_l);
+    }
+}
+
+Light Light::sphere(const Vec3 &center, float radius, const Vec3 &emission, int hit_id, uint32_t hit_prim) {
+    return {LIGHT_SPHERE, center, Vec3(), Vec3(), radius, emission, hit_id, hit_prim};
+}
+
+Light Light::triangle(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2, const Vec3 &emission, int hit_id,
+                      uint32_t hit_prim) {
+    return {LIGHT_TRIANGLE, p0, p1, p2, 0.0f, emission, hit_id, hit_prim};
+}
+
+float Light::area() const {
+    if (shape == LIGHT_SPHERE)
+        return 4.0f * PI * radius * radius;
+    return 0.5f * cross(p1 - p0, p2 - p0).length();
+}
+
+AABB Light::bounds() const {
+    AABB box;
+    if (shape == LIGHT_SPHERE) {
+        box.expand(p0 - radius);
+        box.expand(p0 + radius);
+    } else {
+        box.expand(p0);
+        box.expand(p1);
+        box.expand(p2);
+    }
+    return box;
+}
+
+float Light::power() const {
+    return luminance(emission) * area() * PI;
+}
+
+void LightBVH::build(std::vector<Light> _lights) {
+    lights = std::move(_lights);
+    nodes.clear();
+    parents.clear();
+    leaf_of.assign(lights.size(), 0);
+    index.clear();
+    for (uint32_t i = 0; i < lights.size(); i++)
+        index[light_key(lights[i].hit_id, lights[i].hit_prim)] = i;
+    if (lights.empty())
+        return;
+
+    std::vector<uint32_t> order(lights.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    nodes.reserve(2 * lights.size() - 1);
+    parents.reserve(2 * lights.size() - 1);
+    build_recursive(order, 0, order.size(), 0, 0);
+}
+
+uint32_t LightBVH::build_recursive(std::vector<uint32_t> &order, size_t begin, size_t end, uint32_t parent,
+                                   int depth) {
+    auto node_index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    parents.push_back(parent);
+
+    AABB bounds, centroid_bounds;
+    Cone cone;
+    float power = 0.0f;
+    for (size_t i = begin; i < end; i++) {
+        const Light &light = lights[order[i]];
+        AABB b = light.bounds();
+        bounds.expand(b);
+        centroid_bounds.expand(b.centroid());
+        cone = cone_union(cone, cone_of(light));
+        power += light.power();
+    }
+    LightBVHNode &node = nodes[node_index];
+    node.bounds = bounds;
+    node.axis = cone.axis;
+    node.cos_theta_o = std::cos(cone.theta_o);
+    node.cos_theta_e = std::cos(cone.theta_e);
+    node.power = power;
+
+    if (end - begin == 1) {
+        node.offset = order[begin];
+        node.is_leaf = 1;
+        leaf_of[order[begin]] = node_index;
+        return node_index;
+    }
+    node.is_leaf = 0;
+
+    // 各軸でビン分割し、(放射束 * 表面積 * 方向コーンの立体角)の和が最小となる分割を選ぶ
+    int best_axis = -1;
+    int best_split = 0;
+    float best_cost = std::numeric_limits<float>::max();
+    Vec3 extent = centroid_bounds.max - centroid_bounds.min;
+    for (int axis = 0; depth < LIGHT_SAH_DEPTH_MAX && axis < 3; axis++) {
+        if (!(extent.elements[axis] > 0.0f))
+            continue;
+        AABB bin_bounds[LIGHT_BIN_COUNT];
+        Cone bin_cones[LIGHT_BIN_COUNT];
+        float bin_power[LIGHT_BIN_COUNT] = {};
+        for (size_t i = begin; i < end; i++) {
+            const Light &light = lights[order[i]];
+            AABB b = light.bounds();
+            int bin = std::min(LIGHT_BIN_COUNT - 1, static_cast<int>(
+                    LIGHT_BIN_COUNT * (b.centroid().elements[axis] - centroid_bounds.min.elements[axis]) /
+                    extent.elements[axis]));
+            bin_bounds[bin].expand(b);
+            bin_cones[bin] = cone_union(bin_cones[bin], cone_of(light));
+            bin_power[bin] += light.power();
+        }
+        for (int split = 1; split < LIGHT_BIN_COUNT; split++) {
+            AABB left_bounds, right_bounds;
+            Cone left_cone, right_cone;
+            float left_power = 0.0f, right_power = 0.0f;
+            for (int b = 0; b < split; b++) {
+                left_bounds.expand(bin_bounds[b]);
+                left_cone = cone_union(left_cone, bin_cones[b]);
+                left_power += bin_power[b];
+            }
+            for (int b = split; b < LIGHT_BIN_COUNT; b++) {
+                right_bounds.expand(bin_bounds[b]);
+                right_cone = cone_union(right_cone, bin_cones[b]);
+                right_power += bin_power[b];
+            }
+            if (left_cone.empty || right_cone.empty)
+                continue;
+            float cost = left_power * left_bounds.surface_area() * cone_measure(left_cone) +
+                         right_power * right_bounds.surface_area() * cone_measure(right_cone);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    size_t mid = begin;
+    if (best_axis >= 0) {
+        float min = centroid_bounds.min.elements[best_axis];
+        float width = extent.elements[best_axis];
+        auto it = std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t i) {
+            int bin = std::min(LIGHT_BIN_COUNT - 1, static_cast<int>(
+                    LIGHT_BIN_COUNT * (lights[i].bounds().centroid().elements[best_axis] - min) / width));
+            return bin < best_split;
+        });
+        mid = static_cast<size_t>(it - order.begin());
+    }
+    if (mid == begin || mid == end) {
+        // 分割できない場合は最も広い軸の中央値で分ける
+        int axis = extent.x() > extent.y() ? (extent.x() > extent.z() ? 0 : 2) : (extent.y() > extent.z() ? 1 : 2);
+        mid = (begin + end) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return lights[a].bounds().centroid().elements[axis] < lights[b].bounds().centroid().elements[axis];
+        });
+    }
+
+    build_recursive(order, begin, mid, node_index, depth + 1);
+    uint32_t right = build_recursive(order, mid, end, node_index, depth + 1);
+    nodes[node_index].offset = right;
+    return node_index;
+}
+
+float LightBVH::importance(const LightBVHNode &node, const Vec3 &p, const Vec3 &n) {
+    Vec3 pc = node.bounds.centroid();
+    Vec3 diagonal = node.bounds.max - node.bounds.min;
+    float d2 = (p - pc).squared_length();
+    // ノードの内側や極端に近い点で重要度が発散しないようにする
+    float d2_clamped = std::max(d2, diagonal.length() / 2.0f);
+    if (d2 == 0.0f)
+        return node.power / d2_clamped;
+
+    Vec3 wi = (p - pc) / std::sqrt(d2);
+    float cos_w = dot(node.axis, wi);
+    float sin_w = safe_sqrt(1.0f - cos_w * cos_w);
+
+    // ノードの範囲の外接球がpから見える角度の半分
+    float r2 = diagonal.squared_length() / 4.0f;
+    float cos_b = d2 < r2 ? -1.0f : safe_sqrt(1.0f - r2 / d2);
+    float sin_b = safe_sqrt(1.0f - cos_b * cos_b);
+
+    // 放射の向きとpの方向のなす角から、コーンの広がりと外接球の角度を差し引く
+    float sin_o = safe_sqrt(1.0f - node.cos_theta_o * node.cos_theta_o);
+    float cos_x = cos_sub_clamped(sin_w, cos_w, sin_o, node.cos_theta_o);
+    float sin_x = sin_sub_clamped(sin_w, cos_w, sin_o, node.cos_theta_o);
+    float cos_p = cos_sub_clamped(sin_x, cos_x, sin_b, cos_b);
+    if (cos_p <= node.cos_theta_e)
+        return 0.0f;
+
+    // 受ける側の法線とのなす角からも外接球の角度を差し引く
+    float cos_i = dot(n, -wi);
+    float sin_i = safe_sqrt(1.0f - cos_i * cos_i);
+    float cos_i_min = cos_sub_clamped(sin_i, cos_i, sin_b, cos_b);
+    if (cos_i_min <= 0.0f)
+        return 0.0f;
+    return node.power * cos_p * cos_i_min / d2_clamped;
+}
+
+int LightBVH::find(int hit_id, uint32_t hit_prim) const {
+    auto it = index.find(light_key(hit_id, hit_prim));
+    return it == index.end() ? -1 : static_cast<int>(it->second);
+}
+
+bool LightBVH::sample(const Vec3 &p, const Vec3 &n, Sampler &sampler, LightSample &ls) const {
+    if (nodes.empty() || importance(nodes[0], p, n) <= 0.0f)
+        return false;
+
+    float u = sampler.next();
+    float pmf = 1.0f;
+    uint32_t node = 0;
+    while (!nodes[node].is_leaf) {
+        uint32_t left = node + 1;
+        uint32_t right = nodes[node].offset;
+        float il = importance(nodes[left], p, n);
+        float ir = importance(nodes[right], p, n);
+        if (il + ir <= 0.0f)
+            return false;
+        // 選んだ子の確率で乱数を引き伸ばし、次の段の選択に使い回す
+        float pl = il / (il + ir);
+        if (u < pl) {
+            node = left;
+            u = std::min(u / pl, 0.99999994f);
+            pmf *= pl;
+        } else {
+            node = right;
+            u = std::min((u - pl) / (1.0f - pl), 0.99999994f);
+            pmf *= 1.0f - pl;
+        }
+    }
+
+    if (!sample_point(lights[nodes[node].offset], p, sampler, ls))
+        return false;
+    ls.pdf *= pmf;
+    return true;
+}
+
+float LightBVH::pmf(const Vec3 &p, const Vec3 &n, int light) const {
+    if (light < 0 || static_cast<size_t>(light) >= lights.size() || importance(nodes[0], p, n) <= 0.0f)
+        return 0.0f;
+
+    // 葉から根へ遡り、各段で自身が選ばれる確率を掛ける
+    float pmf = 1.0f;
+    uint32_t node = leaf_of[light];
+    while (node != 0) {
+        uint32_t parent = parents[node];
+        uint32_t left = parent + 1;
+        uint32_t right = nodes[parent].offset;
+        float il = importance(nodes[left], p, n);
+        float ir = importance(nodes[right], p, n);
+        if (il + ir <= 0.0f)
+            return 0.0f;
+        pmf *= (node == left ? il : ir) / (il + ir);
+        node = parent;
+    }
+    return pmf;
+}
+
+float LightBVH::pdf(const Vec3 &p, const Vec3 &n, int light, const Vec3 &x) const {
+    float light_pmf = pmf(p, n, light);
+    if (light_pmf <= 0.0f)
+        return 0.0f;
+    return light_pmf * pdf_point(lights[light], p, x);
+}
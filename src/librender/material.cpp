@@ -0,0 +1,28 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "futaba/render/hit.h"
+#include "futaba/render/material.h"
+
+void surface_uv(const HitRecord &hit, float &u, float &v) {
+    if (hit.hit_type == PRIM_TRIANGLE) {
+        u = hit.hit_u;
+        v = hit.hit_v;
+        return;
+    }
+    const Vec3 &n = hit.hit_normal;
+    u = 0.5f + std::atan2(n.z(), n.x()) / (2.0f * PI);
+    v = 0.5f + std::asin(std::max(-1.0f, std::min(1.0f, n.y()))) / PI;
+}
+
+Vec3 MaterialTable::texture_at(MaterialId id, const HitRecord &hit, float cone_width) const {
+    TextureId texture = albedo_texture[id];
+    if (texture == NO_TEXTURE)
+        return Vec3(1.0f);
+    float u, v;
+    surface_uv(hit, u, v);
+    return textures->lookup(texture, u, v, cone_width / hit.hit_uv_extent);
+}
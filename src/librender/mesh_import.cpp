@@ -0,0 +1,324 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "futaba/core/mapped_file.h"
+#include "futaba/render/scene_file.h"
+
+namespace {
+    /*
+     * mmapしたテキストを先頭から読み進める
+     * ファイルの末尾はヌル終端されていないため、数値は短いトークンを複製してから変換する
+     */
+    class TextCursor {
+    public:
+        const char *p;
+        const char *end;
+
+        TextCursor(const char *_p, const char *_end) : p(_p), end(_end) {};
+
+        bool at_end() const {
+            return p >= end;
+        }
+
+        // 改行以外の空白を読み飛ばす
+        void skip_blank() {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+                p++;
+        }
+
+        void skip_line() {
+            while (p < end && *p != '\n')
+                p++;
+            if (p < end)
+                p++;
+        }
+
+        bool at_line_end() {
+            skip_blank();
+            return p >= end || *p == '\n';
+        }
+
+        // 空白区切りのトークン、改行は越えない
+        std::string token() {
+            skip_blank();
+            const char *begin = p;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                p++;
+            return std::string(begin, p);
+        }
+
+        // 改行を含む空白区切りのトークン
+        std::string any_token() {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+                p++;
+            return token();
+        }
+
+        std::string line() {
+            const char *begin = p;
+            skip_line();
+            const char *last = p;
+            while (last > begin && (last[-1] == '\n' || last[-1] == '\r'))
+                last--;
+            return std::string(begin, last);
+        }
+    };
+
+    double to_number(const std::string &s, const std::string &path) {
+        char *tail = nullptr;
+        double v = std::strtod(s.c_str(), &tail);
+        if (s.empty() || *tail != '\0')
+            throw std::runtime_error("invalid number '" + s + "': " + path);
+        return v;
+    }
+
+    // 多角形を扇状に三角形分割してindicesに追加する
+    void add_polygon(const std::vector<uint32_t> &polygon, std::vector<uint32_t> &indices) {
+        for (size_t k = 2; k < polygon.size(); k++) {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[k - 1]);
+            indices.push_back(polygon[k]);
+        }
+    }
+
+    bool has_extension(const std::string &path, const std::string &ext) {
+        if (path.size() < ext.size())
+            return false;
+        std::string tail = path.substr(path.size() - ext.size());
+        std::transform(tail.begin(), tail.end(), tail.begin(), ::tolower);
+        return tail == ext;
+    }
+
+    enum PlyFormat {
+        PLY_ASCII,
+        PLY_BINARY_LE,
+        PLY_BINARY_BE
+    };
+
+    struct PlyProperty {
+        std::string name;
+        // 要素の型、リストの場合は要素の型とcount_typeに要素数の型
+        std::string type;
+        std::string count_type;
+        bool is_list = false;
+    };
+
+    struct PlyElement {
+        std::string name;
+        uint64_t count = 0;
+        std::vector<PlyProperty> properties;
+    };
+
+    size_t ply_type_size(const std::string &type, const std::string &path) {
+        if (type == "char" || type == "uchar" || type == "int8" || type == "uint8")
+            return 1;
+        if (type == "short" || type == "ushort" || type == "int16" || type == "uint16")
+            return 2;
+        if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" ||
+            type == "float32")
+            return 4;
+        if (type == "double" || type == "float64")
+            return 8;
+        throw std::runtime_error("unknown ply type '" + type + "': " + path);
+    }
+
+    /*
+     * PLYの本体からスカラを1つずつ読み込む
+     * バイナリの場合はホストのバイト順と異なればバイトを入れ替える
+     */
+    class PlyReader {
+    public:
+        PlyReader(TextCursor _cursor, PlyFormat _format, std::string _path) :
+                cursor(_cursor), format(_format), path(std::move(_path)) {};
+
+        double read(const std::string &type) {
+            if (format == PLY_ASCII)
+                return to_number(cursor.any_token(), path);
+
+            size_t size = ply_type_size(type, path);
+            if (cursor.end - cursor.p < static_cast<ptrdiff_t>(size))
+                throw std::runtime_error("truncated ply: " + path);
+            uint8_t bytes[8];
+            std::memcpy(bytes, cursor.p, size);
+            cursor.p += size;
+            if ((format == PLY_BINARY_BE) == host_is_little_endian())
+                std::reverse(bytes, bytes + size);
+
+            if (type == "char" || type == "int8")
+                return static_cast<int8_t>(bytes[0]);
+            if (type == "uchar" || type == "uint8")
+                return bytes[0];
+            if (type == "short" || type == "int16")
+                return load<int16_t>(bytes);
+            if (type == "ushort" || type == "uint16")
+                return load<uint16_t>(bytes);
+            if (type == "int" || type == "int32")
+                return load<int32_t>(bytes);
+            if (type == "uint" || type == "uint32")
+                return load<uint32_t>(bytes);
+            if (type == "float" || type == "float32")
+                return load<float>(bytes);
+            return load<double>(bytes);
+        }
+
+    private:
+        TextCursor cursor;
+        PlyFormat format;
+        std::string path;
+
+        template<typename T>
+        static T load(const uint8_t *bytes) {
+            T v;
+            std::memcpy(&v, bytes, sizeof(T));
+            return v;
+        }
+
+        static bool host_is_little_endian() {
+            const uint16_t one = 1;
+            uint8_t b;
+            std::memcpy(&b, &one, 1);
+            return b == 1;
+        }
+    };
+
+    uint32_t to_index(double v, size_t vertex_count, const std::string &path) {
+        if (v < 0 || v >= static_cast<double>(vertex_count))
+            throw std::runtime_error("face index out of range: " + path);
+        return static_cast<uint32_t>(v);
+    }
+}
+
+std::shared_ptr<Mesh> import_obj(const std::string &path) {
+    MappedFile file = MappedFile::open_readonly(path);
+    const auto *text = static_cast<const char *>(file.data());
+    TextCursor cursor(text, text + file.size());
+
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> polygon;
+    while (!cursor.at_end()) {
+        std::string keyword = cursor.token();
+        if (keyword == "v") {
+            for (int k = 0; k < 3; k++)
+                positions.push_back(static_cast<float>(to_number(cursor.token(), path)));
+        } else if (keyword == "f") {
+            polygon.clear();
+            while (!cursor.at_line_end()) {
+                // v, v/vt, v/vt/vn, v//vnのいずれも先頭の頂点番号のみを利用する
+                std::string vertex = cursor.token();
+                auto index = static_cast<long long>(to_number(vertex.substr(0, vertex.find('/')), path));
+                auto vertex_count = static_cast<long long>(positions.size() / 3);
+                // 負の番号はそれまでに定義された頂点の末尾からの位置を表す
+                long long i = index < 0 ? vertex_count + index : index - 1;
+                if (index == 0 || i < 0 || i >= vertex_count)
+                    throw std::runtime_error("face index out of range: " + path);
+                polygon.push_back(static_cast<uint32_t>(i));
+            }
+            add_polygon(polygon, indices);
+        }
+        cursor.skip_line();
+    }
+    return std::make_shared<Mesh>(std::move(positions), std::move(indices));
+}
+
+std::shared_ptr<Mesh> import_ply(const std::string &path) {
+    MappedFile file = MappedFile::open_readonly(path);
+    const auto *text = static_cast<const char *>(file.data());
+    TextCursor cursor(text, text + file.size());
+
+    if (cursor.line() != "ply")
+        throw std::runtime_error("not a ply file: " + path);
+
+    PlyFormat format = PLY_ASCII;
+    std::vector<PlyElement> elements;
+    while (true) {
+        if (cursor.at_end())
+            throw std::runtime_error("missing end_header: " + path);
+        TextCursor line_cursor(cursor.p, cursor.end);
+        std::string keyword = line_cursor.token();
+        if (keyword == "end_header") {
+            cursor.skip_line();
+            break;
+        }
+        if (keyword == "format") {
+            std::string name = line_cursor.token();
+            if (name == "ascii")
+                format = PLY_ASCII;
+            else if (name == "binary_little_endian")
+                format = PLY_BINARY_LE;
+            else if (name == "binary_big_endian")
+                format = PLY_BINARY_BE;
+            else
+                throw std::runtime_error("unknown ply format '" + name + "': " + path);
+        } else if (keyword == "element") {
+            PlyElement element;
+            element.name = line_cursor.token();
+            element.count = static_cast<uint64_t>(to_number(line_cursor.token(), path));
+            elements.push_back(element);
+        } else if (keyword == "property") {
+            if (elements.empty())
+                throw std::runtime_error("property without element: " + path);
+            PlyProperty property;
+            property.type = line_cursor.token();
+            if (property.type == "list") {
+                property.is_list = true;
+                property.count_type = line_cursor.token();
+                property.type = line_cursor.token();
+            }
+            property.name = line_cursor.token();
+            elements.back().properties.push_back(property);
+        }
+        cursor.skip_line();
+    }
+
+    PlyReader reader(cursor, format, path);
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> polygon;
+    for (const auto &element: elements) {
+        bool is_vertex = element.name == "vertex";
+        bool is_face = element.name == "face";
+        if (is_vertex)
+            positions.reserve(3 * element.count);
+
+        for (uint64_t n = 0; n < element.count; n++) {
+            float v[3] = {0.0f, 0.0f, 0.0f};
+            for (const auto &property: element.properties) {
+                if (property.is_list) {
+                    auto count = static_cast<uint64_t>(reader.read(property.count_type));
+                    bool is_index = is_face && (property.name == "vertex_indices" || property.name == "vertex_index");
+                    polygon.clear();
+                    for (uint64_t k = 0; k < count; k++) {
+                        double value = reader.read(property.type);
+                        if (is_index)
+                            polygon.push_back(to_index(value, positions.size() / 3, path));
+                    }
+                    if (is_index)
+                        add_polygon(polygon, indices);
+                    continue;
+                }
+                double value = reader.read(property.type);
+                if (is_vertex && property.name.size() == 1 && property.name[0] >= 'x' && property.name[0] <= 'z')
+                    v[property.name[0] - 'x'] = static_cast<float>(value);
+            }
+            if (is_vertex)
+                positions.insert(positions.end(), v, v + 3);
+        }
+    }
+    return std::make_shared<Mesh>(std::move(positions), std::move(indices));
+}
+
+std::shared_ptr<Mesh> import_mesh(const std::string &path) {
+    if (has_extension(path, ".obj"))
+        return import_obj(path);
+    if (has_extension(path, ".ply"))
+        return import_ply(path);
+    throw std::runtime_error("unknown mesh format: " + path);
+}
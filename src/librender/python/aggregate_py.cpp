@@ -7,9 +7,17 @@
 #include <futaba/render/aggregate.h>
 
 FTB_PY_EXPORT(aggregate) {
-    py::class_<Aggregate>(m, "Aggregate")
+    py::class_<Aggregate, std::shared_ptr<Aggregate>>(m, "Aggregate")
             .def(py::init<>())
             .def(py::init<const std::vector<std::shared_ptr<Sphere>>>())
-            .def("add", &Aggregate::add)
+            .def("add", [](Aggregate &a, const Sphere &s) { a.add(s); })
+            .def("add", [](Aggregate &a, const Mesh &mesh) { a.add(mesh); })
+            .def("add", [](Aggregate &a, const SphereCloud &c) { a.add(c); })
+            .def("add", [](Aggregate &a, const Instance &i) { a.add(i); })
+            .def_readwrite("materials", &Aggregate::materials)
+            .def("build", &Aggregate::build)
+            .def("replicate_bvh", &Aggregate::replicate_bvh)
+            .def_property_readonly("replica_count", &Aggregate::replica_count)
+            .def_property_readonly("light_count", [](const Aggregate &a) { return a.lights.lights.size(); })
             .def("intersect", &Aggregate::intersect);
 }
\ No newline at end of file
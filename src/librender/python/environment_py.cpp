@@ -0,0 +1,19 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/environment.h>
+
+FTB_PY_EXPORT(environment) {
+    py::class_<EnvironmentLight, std::shared_ptr<EnvironmentLight>>(m, "EnvironmentLight")
+            .def(py::init<const std::string &, float>(), py::arg("path"), py::arg("scale") = 1.0f)
+            .def(py::init<int, int, std::vector<float>, float>(), py::arg("width"), py::arg("height"),
+                 py::arg("rgb"), py::arg("scale") = 1.0f)
+            .def_readwrite("scale", &EnvironmentLight::scale)
+            .def("width", &EnvironmentLight::width)
+            .def("height", &EnvironmentLight::height)
+            .def("eval", &EnvironmentLight::eval)
+            .def("pdf", &EnvironmentLight::pdf);
+}
@@ -10,5 +10,8 @@ FTB_PY_EXPORT(hit) {
     py::class_<HitRecord>(m, "HitRecord")
             .def(py::init<>())
             .def_readwrite("hit_pos", &HitRecord::hit_pos)
-            .def_readwrite("hit_normal", &HitRecord::hit_normal);
+            .def_readwrite("hit_normal", &HitRecord::hit_normal)
+            .def_readwrite("hit_id", &HitRecord::hit_id)
+            .def_readwrite("hit_prim", &HitRecord::hit_prim)
+            .def_readwrite("t", &HitRecord::t);
 }
\ No newline at end of file
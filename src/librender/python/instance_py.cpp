@@ -0,0 +1,16 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/aggregate.h>
+
+FTB_PY_EXPORT(instance) {
+    py::class_<Instance, std::shared_ptr<Instance>>(m, "Instance")
+            .def(py::init([](const std::shared_ptr<Aggregate> &prototype, const Transform &to_world) {
+                return std::make_shared<Instance>(prototype, to_world);
+            }))
+            .def_readonly("to_world", &Instance::to_world)
+            .def("is_hittable", static_cast<bool (Instance::*)(Ray &, HitRecord &) const>(&Instance::is_hittable));
+}
@@ -12,12 +12,32 @@
 
 FTB_PY_DECLARE(aggregate);
 
+FTB_PY_DECLARE(environment);
+
 FTB_PY_DECLARE(hit);
 
+FTB_PY_DECLARE(instance);
+
+FTB_PY_DECLARE(material);
+
+FTB_PY_DECLARE(mesh);
+
 FTB_PY_DECLARE(pinhole_camera);
 
+FTB_PY_DECLARE(radiance_cache);
+
+FTB_PY_DECLARE(render_client);
+
+FTB_PY_DECLARE(renderer);
+
+FTB_PY_DECLARE(scene_file);
+
 FTB_PY_DECLARE(sphere);
 
+FTB_PY_DECLARE(sphere_cloud);
+
+FTB_PY_DECLARE(texture);
+
 /*
  * futaba_pyはCMakeのtargetにも同名の指定が必要
  */
@@ -56,8 +76,18 @@ PYBIND11_MODULE(librender_py, m) {
     m.attr("FTB_AUTHORS") = FTB_AUTHORS;
 
     FTB_PY_IMPORT(aggregate);
+    FTB_PY_IMPORT(environment);
     FTB_PY_IMPORT(hit);
+    FTB_PY_IMPORT(instance);
+    FTB_PY_IMPORT(material);
+    FTB_PY_IMPORT(mesh);
     FTB_PY_IMPORT(pinhole_camera);
+    FTB_PY_IMPORT(radiance_cache);
+    FTB_PY_IMPORT(render_client);
+    FTB_PY_IMPORT(renderer);
+    FTB_PY_IMPORT(scene_file);
     FTB_PY_IMPORT(sphere);
+    FTB_PY_IMPORT(sphere_cloud);
+    FTB_PY_IMPORT(texture);
 
 }
@@ -0,0 +1,33 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/material.h>
+
+FTB_PY_EXPORT(material) {
+    py::enum_<MaterialType>(m, "MaterialType")
+            .value("MAT_DIFFUSE", MAT_DIFFUSE)
+            .value("MAT_METAL", MAT_METAL)
+            .value("MAT_DIELECTRIC", MAT_DIELECTRIC)
+            .value("MAT_EMISSIVE", MAT_EMISSIVE)
+            .export_values();
+
+    py::class_<MaterialTable>(m, "MaterialTable")
+            .def(py::init<>())
+            .def("add_diffuse", &MaterialTable::add_diffuse)
+            .def("add_metal", &MaterialTable::add_metal)
+            .def("add_dielectric", &MaterialTable::add_dielectric, py::arg("ior"), py::arg("albedo") = Vec3(1.0f))
+            .def("add_emissive", &MaterialTable::add_emissive)
+            .def("set_albedo_texture", &MaterialTable::set_albedo_texture)
+            .def_readwrite("textures", &MaterialTable::textures)
+            .def("size", &MaterialTable::size)
+            .def("__len__", &MaterialTable::size)
+            .def_readonly("type", &MaterialTable::type)
+            .def_readonly("albedo", &MaterialTable::albedo)
+            .def_readonly("emission", &MaterialTable::emission)
+            .def_readonly("roughness", &MaterialTable::roughness)
+            .def_readonly("ior", &MaterialTable::ior)
+            .def_readonly("albedo_texture", &MaterialTable::albedo_texture);
+}
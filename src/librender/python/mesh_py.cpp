@@ -0,0 +1,16 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/mesh.h>
+
+FTB_PY_EXPORT(mesh) {
+    py::class_<Mesh, std::shared_ptr<Mesh>>(m, "Mesh")
+            .def(py::init<std::vector<float>, std::vector<uint32_t>>())
+            .def_readwrite("material", &Mesh::material)
+            .def("vertex_count", &Mesh::vertex_count)
+            .def("triangle_count", &Mesh::triangle_count)
+            .def("is_hittable", &Mesh::is_hittable);
+}
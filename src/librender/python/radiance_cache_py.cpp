@@ -0,0 +1,20 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/radiance_cache.h>
+
+FTB_PY_EXPORT(radiance_cache) {
+    // renderのcacheに渡すと、同じキャッシュを渡した呼び出しの間で構築した放射輝度を引き継ぐ
+    py::class_<RadianceCache, std::shared_ptr<RadianceCache>>(m, "RadianceCache")
+            .def(py::init<float, uint32_t, size_t, uint32_t>(), py::arg("cell_size"), py::arg("min_samples") = 16,
+                 py::arg("capacity") = 1u << 20u, py::arg("max_samples") = 1u << 16u)
+            .def_readwrite("cell_size", &RadianceCache::cell_size)
+            .def_readwrite("min_samples", &RadianceCache::min_samples)
+            .def_readwrite("max_samples", &RadianceCache::max_samples)
+            .def_property_readonly("capacity", &RadianceCache::capacity)
+            .def_property_readonly("cell_count", &RadianceCache::cell_count)
+            .def("clear", &RadianceCache::clear);
+}
@@ -0,0 +1,72 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <cstring>
+#include <pybind11/numpy.h>
+#include <futaba/python/python.h>
+#include <futaba/render/camera.h>
+#include <futaba/render/server.h>
+
+namespace {
+    /*
+     * 登録済みのシーンnameをサーバでレンダリングし、(height, width, channels)のNumPyの配列で返す
+     * 通信とサーバでのレンダリングの間はGILを解放する
+     */
+    py::array_t<float> render(RenderClient &client, const std::string &name, const Camera &camera, int width,
+                              int height, int spp, int passes, uint64_t seed, AOVType aov) {
+        if (width <= 0 || height <= 0 || spp <= 0 || passes <= 0)
+            throw std::runtime_error("render: width, height, spp and passes must be positive");
+
+        RenderRequest request{};
+        for (int k = 0; k < 3; k++) {
+            request.cam_sensor_pos[k] = camera.cam_sensor_pos.elements[k];
+            request.cam_sight_vec[k] = camera.cam_sight_vec.elements[k];
+        }
+        request.cam_sensor_width = camera.cam_sensor_width;
+        request.cam_sensor_height = camera.cam_sensor_height;
+        request.cam_sensor_dist = camera.cam_sensor_dist;
+        request.width = static_cast<uint32_t>(width);
+        request.height = static_cast<uint32_t>(height);
+        request.spp = static_cast<uint32_t>(spp);
+        request.passes = static_cast<uint32_t>(passes);
+        request.seed = seed;
+        request.aov = static_cast<uint32_t>(aov);
+
+        std::vector<float> frame;
+        int channels = 0;
+        {
+            py::gil_scoped_release release;
+            frame = client.render(name, request, channels);
+        }
+        if (frame.size() != static_cast<size_t>(width) * height * channels)
+            throw std::runtime_error("render: unexpected frame size");
+        py::array_t<float> image({static_cast<py::ssize_t>(height), static_cast<py::ssize_t>(width),
+                                  static_cast<py::ssize_t>(channels)});
+        std::memcpy(image.mutable_data(), frame.data(), frame.size() * sizeof(float));
+        return image;
+    }
+}
+
+FTB_PY_EXPORT(render_client) {
+    py::enum_<AOVType>(m, "AOVType")
+            .value("BEAUTY", AOV_BEAUTY)
+            .value("NORMAL", AOV_NORMAL)
+            .value("DEPTH", AOV_DEPTH)
+            .value("ALBEDO", AOV_ALBEDO)
+            .value("OBJECT_ID", AOV_OBJECT_ID)
+            .value("SAMPLE_COUNT", AOV_SAMPLE_COUNT);
+
+    // 常駐するRenderServer(futaba serve)に接続し、シーンを一度だけ登録してレンダリングを繰り返す
+    py::class_<RenderClient>(m, "RenderClient")
+            .def(py::init<const std::string &>(), py::arg("address"))
+            .def("put_scene", &RenderClient::put_scene, py::arg("name"), py::arg("aggregate"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("drop_scene", &RenderClient::drop_scene, py::arg("name"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("list_scenes", &RenderClient::list_scenes, py::call_guard<py::gil_scoped_release>())
+            .def("render", &render, py::arg("name"), py::arg("camera"), py::arg("width"), py::arg("height"),
+                 py::arg("spp") = 16, py::arg("passes") = 1, py::arg("seed") = 0, py::arg("aov") = AOV_BEAUTY)
+            .def("stats", &RenderClient::stats, py::call_guard<py::gil_scoped_release>())
+            .def("shutdown_server", &RenderClient::shutdown_server, py::call_guard<py::gil_scoped_release>());
+}
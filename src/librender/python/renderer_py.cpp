@@ -0,0 +1,143 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <pybind11/numpy.h>
+#include <futaba/python/python.h>
+#include <futaba/render/renderer.h>
+
+namespace {
+    // Pythonの別のスレッドからrenderの中断を要求するためのトークン
+    struct RenderCancel {
+        std::atomic<bool> flag{false};
+    };
+
+    /*
+     * GILを解放してレンダリングし、Beautyを(height, width, 3)のNumPyの配列で返す
+     * progressは完了した割合(0から1)を引数にprogress_interval秒以上の間隔で呼び出し、Falseを返すと中断する
+     * 中断した場合(progress、cancel、Ctrl+C)は描画済みのタイルのみを含む画像を返す
+     * environment、mode、max_depth、roulette、cacheはPathIntegratorの同名の設定に渡す(Noneは設定しない)
+     * progressで発生した例外とCtrl+Cによる例外はレンダリングを中断した後に送出する
+     */
+    py::array_t<float> render(const Aggregate &aggregate, const Camera &camera, int width, int height, int spp,
+                              int threads, int passes, const py::object &progress, double progress_interval,
+                              RenderCancel *cancel, uint64_t seed, TraversalOrder tile_order,
+                              TraversalOrder pixel_order, RayOrder ray_order, int packet_size, bool numa,
+                              std::shared_ptr<EnvironmentLight> environment, IntegratorMode mode, int max_depth,
+                              float roulette, std::shared_ptr<RadianceCache> cache) {
+        if (width <= 0 || height <= 0 || spp <= 0 || passes <= 0)
+            throw std::runtime_error("render: width, height, spp and passes must be positive");
+        if (max_depth <= 0)
+            throw std::runtime_error("render: max_depth must be positive");
+
+        // numaの場合は各タイルのページを描画したノードに置くため、無名の領域として確保する
+        uint32_t mask = aov_bit(AOV_BEAUTY) | aov_bit(AOV_SAMPLE_COUNT);
+        Framebuffer fb = numa ? Framebuffer(height, width, mask, "") : Framebuffer(height, width, mask);
+        Renderer renderer(spp, threads, 0, seed);
+        renderer.tile_order = tile_order;
+        renderer.pixel_order = pixel_order;
+        renderer.integrator.ray_order = ray_order;
+        renderer.integrator.packet_size = packet_size;
+        renderer.numa = numa;
+        renderer.integrator.environment = environment;
+        renderer.integrator.mode = mode;
+        renderer.integrator.max_depth = max_depth;
+        renderer.integrator.roulette = roulette;
+        renderer.integrator.cache = cache;
+        RenderCancel local_cancel;
+        std::atomic<bool> &cancelled = cancel ? cancel->flag : local_cancel.flag;
+        renderer.cancel = &cancelled;
+
+        std::mutex mtx;
+        auto interval = std::chrono::duration<double>(progress_interval);
+        auto last_reported = std::chrono::steady_clock::now();
+        std::unique_ptr<py::error_already_set> error;
+        int pass = 0;
+        renderer.progress = [&](int done, int total) {
+            // 他のスレッドが報告中であれば待たずに処理を続ける
+            std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+            if (!lock.owns_lock())
+                return;
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_reported < interval)
+                return;
+            last_reported = now;
+
+            py::gil_scoped_acquire gil;
+            try {
+                if (PyErr_CheckSignals() != 0)
+                    throw py::error_already_set();
+                if (progress.is_none())
+                    return;
+                py::object result = progress((pass + static_cast<double>(done) / total) / passes);
+                if (!result.is_none() && !result.cast<bool>())
+                    cancelled = true;
+            } catch (py::error_already_set &e) {
+                if (!error)
+                    error.reset(new py::error_already_set(std::move(e)));
+                cancelled = true;
+            }
+        };
+
+        {
+            py::gil_scoped_release release;
+            for (pass = 0; pass < passes && !renderer.is_cancelled(); pass++)
+                renderer.render(aggregate, camera, fb);
+        }
+        if (error)
+            throw *error;
+        if (!progress.is_none() && !renderer.is_cancelled())
+            progress(1.0);
+
+        py::array_t<float> image({static_cast<py::ssize_t>(height), static_cast<py::ssize_t>(width),
+                                  static_cast<py::ssize_t>(3)});
+        float *out = image.mutable_data();
+        {
+            py::gil_scoped_release release;
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    Vec3 v = fb.read(AOV_BEAUTY, x, y);
+                    float *p = out + 3 * (static_cast<size_t>(y) * width + x);
+                    p[0] = v.x();
+                    p[1] = v.y();
+                    p[2] = v.z();
+                }
+            }
+        }
+        return image;
+    }
+}
+
+FTB_PY_EXPORT(renderer) {
+    py::enum_<TraversalOrder>(m, "TraversalOrder")
+            .value("SCANLINE", ORDER_SCANLINE)
+            .value("MORTON", ORDER_MORTON)
+            .value("HILBERT", ORDER_HILBERT);
+
+    py::enum_<IntegratorMode>(m, "IntegratorMode")
+            .value("BSDF", INTEGRATOR_BSDF)
+            .value("NEE", INTEGRATOR_NEE)
+            .value("MIS", INTEGRATOR_MIS);
+
+    py::enum_<RayOrder>(m, "RayOrder")
+            .value("NONE", RAY_ORDER_NONE)
+            .value("ORIGIN", RAY_ORDER_ORIGIN)
+            .value("OCTANT_ORIGIN", RAY_ORDER_OCTANT_ORIGIN);
+
+    py::class_<RenderCancel>(m, "RenderCancel")
+            .def(py::init<>())
+            .def("cancel", [](RenderCancel &c) { c.flag = true; })
+            .def_property_readonly("cancelled", [](const RenderCancel &c) { return c.flag.load(); });
+
+    m.def("render", &render, py::arg("aggregate"), py::arg("camera"), py::arg("width"), py::arg("height"),
+          py::arg("spp") = 16, py::arg("threads") = 0, py::arg("passes") = 1, py::arg("progress") = py::none(),
+          py::arg("progress_interval") = 0.1, py::arg("cancel") = py::none(), py::arg("seed") = 0,
+          py::arg("tile_order") = ORDER_SCANLINE, py::arg("pixel_order") = ORDER_SCANLINE,
+          py::arg("ray_order") = RAY_ORDER_NONE, py::arg("packet_size") = 0,
+          py::arg("numa") = false, py::arg("environment") = py::none(), py::arg("mode") = INTEGRATOR_MIS,
+          py::arg("max_depth") = MAX_DEPTH, py::arg("roulette") = ROULETTE, py::arg("cache") = py::none());
+}
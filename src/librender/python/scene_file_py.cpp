@@ -0,0 +1,18 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/scene_file.h>
+
+FTB_PY_EXPORT(scene_file) {
+    m.def("save_scene_file", &save_scene_file);
+    m.def("load_scene_file", &load_scene_file);
+    m.def("save_shared_scene", &save_shared_scene);
+    m.def("load_shared_scene", &load_shared_scene);
+    m.def("remove_shared_scene", &remove_shared_scene);
+    m.def("import_mesh", &import_mesh);
+    m.def("import_obj", &import_obj);
+    m.def("import_ply", &import_ply);
+}
@@ -0,0 +1,52 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <stdexcept>
+#include <pybind11/numpy.h>
+#include <futaba/python/python.h>
+#include <futaba/render/sphere_cloud.h>
+
+namespace {
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+    /*
+     * NumPyの配列から直接SphereCloudを構築する
+     * centersは(N, 3)、radiiは(N,)の配列もしくはスカラ(Pythonの数値、NumPyのスカラ、0次元の配列)
+     * float32のC連続な配列の場合は変換のための複製も発生しない
+     */
+    std::shared_ptr<SphereCloud> from_numpy(const FloatArray &centers, const py::object &radii, int threads) {
+        if (centers.ndim() != 2 || centers.shape(1) != 3)
+            throw std::runtime_error("centers must be an (N, 3) array");
+        auto count = static_cast<size_t>(centers.shape(0));
+
+        if (py::isinstance<py::float_>(radii) || py::isinstance<py::int_>(radii)) {
+            auto radius = radii.cast<float>();
+            py::gil_scoped_release release;
+            return SphereCloud::from_arrays(centers.data(), nullptr, count, radius, threads);
+        }
+        auto radius_array = FloatArray::ensure(radii);
+        // NumPyのスカラ(np.float32など)は0次元の配列になる
+        if (radius_array && radius_array.ndim() == 0) {
+            float radius = *radius_array.data();
+            py::gil_scoped_release release;
+            return SphereCloud::from_arrays(centers.data(), nullptr, count, radius, threads);
+        }
+        if (!radius_array || radius_array.ndim() != 1 || static_cast<size_t>(radius_array.shape(0)) != count)
+            throw std::runtime_error("radii must be an (N,) array or a scalar");
+        py::gil_scoped_release release;
+        return SphereCloud::from_arrays(centers.data(), radius_array.data(), count, 1.0f, threads);
+    }
+}
+
+FTB_PY_EXPORT(sphere_cloud) {
+    py::class_<SphereCloud, std::shared_ptr<SphereCloud>>(m, "SphereCloud")
+            .def_static("from_numpy", &from_numpy, py::arg("centers"), py::arg("radii"), py::arg("threads") = 0)
+            .def_static("load", &SphereCloud::load, py::arg("path"), py::arg("threads") = 0,
+                        py::call_guard<py::gil_scoped_release>())
+            .def("save", &SphereCloud::save)
+            .def_readwrite("material", &SphereCloud::material)
+            .def("count", &SphereCloud::count)
+            .def("__len__", &SphereCloud::count);
+}
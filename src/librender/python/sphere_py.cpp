@@ -9,5 +9,7 @@
 FTB_PY_EXPORT(sphere) {
     py::class_<Sphere>(m, "Sphere")
             .def(py::init<Vec3, float>())
-            .def("is_hittable", &Sphere::is_hittable);
+            .def(py::init<Vec3, float, MaterialId>())
+            .def_readwrite("material", &Sphere::material)
+            .def("is_hittable", static_cast<bool (Sphere::*)(Ray &, HitRecord &) const>(&Sphere::is_hittable));
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+
+#include <futaba/python/python.h>
+#include <futaba/render/texture.h>
+
+FTB_PY_EXPORT(texture) {
+    m.attr("NO_TEXTURE") = NO_TEXTURE;
+
+    py::class_<TextureCache, std::shared_ptr<TextureCache>>(m, "TextureCache")
+            .def(py::init<size_t, std::string>(), py::arg("memory_limit") = 256u << 20u, py::arg("tile_dir") = "")
+            .def_readwrite("memory_limit", &TextureCache::memory_limit)
+            .def("add", &TextureCache::add, py::call_guard<py::gil_scoped_release>())
+            .def("texture_count", &TextureCache::texture_count)
+            .def("width", &TextureCache::width)
+            .def("height", &TextureCache::height)
+            .def("levels", &TextureCache::levels)
+            .def("lookup", &TextureCache::lookup, py::call_guard<py::gil_scoped_release>())
+            .def("memory_usage", &TextureCache::memory_usage)
+            .def("hit_count", &TextureCache::hit_count)
+            .def("miss_count", &TextureCache::miss_count);
+}
@@ -0,0 +1,115 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <cmath>
+#include <stdexcept>
+#include "futaba/render/radiance_cache.h"
+
+namespace {
+    // 格子の座標を表すビット数(各軸)、範囲外の座標は折り返す
+    const int CELL_COORD_BITS = 20;
+    // 探索するセルの数の上限
+    const size_t PROBE_MAX = 16;
+
+    uint64_t mix64(uint64_t x) {
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31u);
+    }
+
+    uint64_t coord_bits(float x, float inv_cell_size) {
+        auto i = static_cast<int64_t>(std::floor(x * inv_cell_size));
+        return static_cast<uint64_t>(i) & ((1ull << CELL_COORD_BITS) - 1u);
+    }
+
+    // CASによるfloatの加算
+    void atomic_add(std::atomic<float> &target, float value) {
+        float old = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(old, old + value, std::memory_order_relaxed));
+    }
+}
+
+RadianceCache::RadianceCache(float _cell_size, uint32_t _min_samples, size_t capacity, uint32_t _max_samples) :
+        cell_size(_cell_size), min_samples(_min_samples), max_samples(_max_samples) {
+    if (!(cell_size > 0.0f))
+        throw std::runtime_error("RadianceCache: cell_size must be positive");
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1u;
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    clear();
+}
+
+void RadianceCache::clear() {
+    for (size_t i = 0; i <= mask; i++) {
+        cells[i].key.store(0, std::memory_order_relaxed);
+        cells[i].count.store(0, std::memory_order_relaxed);
+        for (auto &s: cells[i].sum)
+            s.store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+uint64_t RadianceCache::cell_key(const Vec3 &p, const Vec3 &n) const {
+    float inv = 1.0f / cell_size;
+    // 法線は絶対値の最大の成分の軸と符号で6方向に分ける
+    int axis = std::abs(n.x()) > std::abs(n.y()) ? (std::abs(n.x()) > std::abs(n.z()) ? 0 : 2)
+                                                 : (std::abs(n.y()) > std::abs(n.z()) ? 1 : 2);
+    uint64_t direction = 2u * axis + (n.elements[axis] < 0.0f ? 1u : 0u);
+    // 最上位のビットを立てて空のセル(0)と区別する
+    return 1ull << 63u | direction << (3u * CELL_COORD_BITS) |
+           coord_bits(p.z(), inv) << (2u * CELL_COORD_BITS) | coord_bits(p.y(), inv) << CELL_COORD_BITS |
+           coord_bits(p.x(), inv);
+}
+
+RadianceCache::Cell *RadianceCache::find(uint64_t key, bool create) const {
+    size_t slot = mix64(key) & mask;
+    for (size_t probe = 0; probe < PROBE_MAX; probe++, slot = (slot + 1) & mask) {
+        Cell &cell = cells[slot];
+        uint64_t current = cell.key.load(std::memory_order_acquire);
+        if (current == key)
+            return &cell;
+        if (current != 0)
+            continue;
+        if (!create)
+            return nullptr;
+        // 空のセルを確保する、他のスレッドが先に確保した場合はそのキーを確かめる
+        if (cell.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key)
+            return &cell;
+    }
+    return nullptr;
+}
+
+bool RadianceCache::lookup(const Vec3 &p, const Vec3 &n, Vec3 &value) const {
+    const Cell *cell = find(cell_key(p, n), false);
+    if (!cell)
+        return false;
+    uint32_t count = cell->count.load(std::memory_order_relaxed);
+    if (count < min_samples || count == 0)
+        return false;
+    // 和と数は個別に更新されるため、並行して加えている間は僅かにずれた平均となる
+    value = Vec3(cell->sum[0].load(std::memory_order_relaxed), cell->sum[1].load(std::memory_order_relaxed),
+                 cell->sum[2].load(std::memory_order_relaxed)) / static_cast<float>(count);
+    return true;
+}
+
+void RadianceCache::add(const Vec3 &p, const Vec3 &n, const Vec3 &value) {
+    if (!std::isfinite(value.x()) || !std::isfinite(value.y()) || !std::isfinite(value.z()))
+        return;
+    Cell *cell = find(cell_key(p, n), true);
+    if (!cell || cell->count.load(std::memory_order_relaxed) >= max_samples)
+        return;
+    for (int i = 0; i < 3; i++)
+        atomic_add(cell->sum[i], value.elements[i]);
+    cell->count.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t RadianceCache::cell_count() const {
+    size_t count = 0;
+    for (size_t i = 0; i <= mask; i++) {
+        if (cells[i].key.load(std::memory_order_relaxed) != 0)
+            count++;
+    }
+    return count;
+}
@@ -0,0 +1,165 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "futaba/core/sampler.h"
+#include "futaba/render/checkpoint.h"
+#include "futaba/render/renderer.h"
+
+Ray Renderer::primary_ray(const Camera &camera, const Framebuffer &fb, int x, int y, float dx, float dy) {
+    float u = 1.0f - 2.0f * (static_cast<float>(x) + dx) / static_cast<float>(fb.width);
+    float v = 2.0f * (static_cast<float>(y) + dy) / static_cast<float>(fb.height) - 1.0f;
+    return camera.shoot(u, v);
+}
+
+void Renderer::render_tile(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb,
+                           int x0, int y0, int x1, int y1) const {
+    const int tile_width = x1 - x0;
+    // i番目に追跡する画素のタイル内の位置
+    const std::vector<uint32_t> order = traversal_order(tile_width, y1 - y0, pixel_order);
+    const size_t pixel_count = order.size();
+    if (pixel_count == 0)
+        return;
+
+    std::vector<uint64_t> sample_counts(pixel_count);
+    for (size_t i = 0; i < pixel_count; i++) {
+        int x = x0 + static_cast<int>(order[i]) % tile_width;
+        int y = y0 + static_cast<int>(order[i]) / tile_width;
+        sample_counts[i] = static_cast<uint64_t>(fb.read_scalar(AOV_SAMPLE_COUNT, x, y));
+    }
+
+    std::vector<Vec3> beauty_sum(pixel_count), albedo_sum(pixel_count);
+    std::vector<HitRecord> center_hits(pixel_count);
+    std::vector<uint8_t> center_is_hit(pixel_count, 0);
+
+    std::vector<PathState> paths;
+    std::vector<HitRecord> first_hits;
+    std::vector<uint8_t> first_is_hit;
+    paths.reserve(pixel_count);
+
+    // 隣接する画素の中心を通るレイのなす角をレイコーンの広がりとする(タイル内では一定とみなす)
+    int cx = (x0 + x1) / 2;
+    int cy = (y0 + y1) / 2;
+    Vec3 d0 = primary_ray(camera, fb, cx, cy, 0.5f, 0.5f).direction;
+    Vec3 d1 = primary_ray(camera, fb, cx + 1, cy, 0.5f, 0.5f).direction;
+    float cone_spread = (unit_vec(d1) - unit_vec(d0)).length();
+
+    // タイル内の全画素の同じサンプル番号の経路をまとめて追跡する
+    for (int s = 0; s < spp; s++) {
+        paths.clear();
+        for (size_t i = 0; i < pixel_count; i++) {
+            int x = x0 + static_cast<int>(order[i]) % tile_width;
+            int y = y0 + static_cast<int>(order[i]) / tile_width;
+            uint64_t sample_index = sample_counts[i] + s;
+            Sampler sampler(seed, static_cast<uint64_t>(y) * fb.width + x, sample_index);
+
+            // 最初のサンプルは画素の中心を通し、以降は画素内でランダムにずらす
+            float dx = sample_index == 0 ? 0.5f : sampler.next();
+            float dy = sample_index == 0 ? 0.5f : sampler.next();
+            paths.emplace_back(primary_ray(camera, fb, x, y, dx, dy), sampler, cone_spread);
+        }
+
+        integrator.trace(aggregate, paths, first_hits, first_is_hit);
+
+        for (size_t i = 0; i < pixel_count; i++) {
+            beauty_sum[i] += paths[i].radiance;
+            if (first_is_hit[i])
+                albedo_sum[i] += aggregate.materials.albedo_at(first_hits[i].hit_material, first_hits[i],
+                                                               cone_spread * first_hits[i].t);
+            if (sample_counts[i] + s == 0) {
+                center_hits[i] = first_hits[i];
+                center_is_hit[i] = first_is_hit[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pixel_count; i++) {
+        int x = x0 + static_cast<int>(order[i]) % tile_width;
+        int y = y0 + static_cast<int>(order[i]) / tile_width;
+        uint64_t n = sample_counts[i];
+
+        // 累積済みの平均とサンプル数から新しい平均を求める
+        auto n_f = static_cast<float>(n);
+        float inv_total = 1.0f / (n_f + static_cast<float>(spp));
+        if (fb.has_aov(AOV_BEAUTY))
+            fb.write(AOV_BEAUTY, x, y, (fb.read(AOV_BEAUTY, x, y) * n_f + beauty_sum[i]) * inv_total);
+        if (fb.has_aov(AOV_ALBEDO))
+            fb.write(AOV_ALBEDO, x, y, (fb.read(AOV_ALBEDO, x, y) * n_f + albedo_sum[i]) * inv_total);
+        fb.write(AOV_SAMPLE_COUNT, x, y, static_cast<float>(n + spp));
+
+        /*
+         * 幾何情報のAOVは平均すると意味を失うため最初のサンプル(画素の中心)の値を採用する
+         * 衝突しなかった場合はHitRecordの初期値(t = HIT_DISTANCE_MAX, hit_id = -1)がそのまま書き込まれる
+         */
+        if (n > 0)
+            continue;
+        if (fb.has_aov(AOV_NORMAL))
+            fb.write(AOV_NORMAL, x, y, center_is_hit[i] ? center_hits[i].hit_normal : Vec3());
+        if (fb.has_aov(AOV_DEPTH))
+            fb.write(AOV_DEPTH, x, y, center_hits[i].t);
+        if (fb.has_aov(AOV_OBJECT_ID))
+            fb.write(AOV_OBJECT_ID, x, y, static_cast<float>(center_hits[i].hit_id));
+    }
+}
+
+void Renderer::render(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb) const {
+    int tile_size = this->tile_size > 0 ? this->tile_size : fb.tile_size;
+    int tiles_x = (fb.width + tile_size - 1) / tile_size;
+    int tiles_y = (fb.height + tile_size - 1) / tile_size;
+    int tile_count = tiles_x * tiles_y;
+    const std::vector<uint32_t> tiles = traversal_order(tiles_x, tiles_y, tile_order);
+
+    /*
+     * 各スレッドは次のタイル番号を順に取得する(numaの場合は自身のノードの範囲から)
+     * タイル毎に処理時間が異なっても早く終わったスレッドが残りのタイルを引き受ける
+     */
+    std::atomic<int> done(0);
+    auto render_one = [&](int i) {
+        if (is_cancelled())
+            return;
+        int x0 = static_cast<int>(tiles[i] % tiles_x) * tile_size;
+        int y0 = static_cast<int>(tiles[i] / tiles_x) * tile_size;
+        render_tile(aggregate, camera, fb, x0, y0,
+                    std::min(x0 + tile_size, fb.width), std::min(y0 + tile_size, fb.height));
+        if (progress)
+            progress(done.fetch_add(1) + 1, tile_count);
+    };
+
+    if (pool) {
+        pool->parallel_for_nodes(tile_count, render_one);
+    } else {
+        ThreadPool local_pool(std::min(threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency()),
+                                       tile_count), numa);
+        local_pool.parallel_for_nodes(tile_count, render_one);
+    }
+}
+
+int Renderer::render_progressive(const Aggregate &aggregate, const Camera &camera, Framebuffer &fb, int passes,
+                                 const std::string &checkpoint_path, double checkpoint_interval) const {
+    RenderState state{seed, spp, 0};
+    if (!checkpoint_path.empty() && load_checkpoint(checkpoint_path, fb, state)) {
+        if (state.seed != seed || state.spp != spp)
+            throw std::runtime_error("checkpoint was written with different sampler settings: " + checkpoint_path);
+    }
+
+    auto last_saved = std::chrono::steady_clock::now();
+    while (state.passes < passes && !is_cancelled()) {
+        render(aggregate, camera, fb);
+        if (is_cancelled())
+            break;
+        state.passes++;
+
+        if (checkpoint_path.empty())
+            continue;
+        auto now = std::chrono::steady_clock::now();
+        if (state.passes == passes || std::chrono::duration<double>(now - last_saved).count() >= checkpoint_interval) {
+            save_checkpoint(checkpoint_path, fb, state);
+            last_saved = now;
+        }
+    }
+    return state.passes;
+}
@@ -0,0 +1,381 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "futaba/core/mapped_file.h"
+#include "futaba/render/scene_file.h"
+
+// BVHの配列はメモリ上の表現のまま書き出す
+static_assert(sizeof(BVHNode) == 32 && sizeof(PrimRef) == 12, "unexpected BVH layout");
+
+namespace {
+    const char SCENE_MAGIC[8] = {'F', 'T', 'B', 'S', 'C', 'N', '0', '1'};
+    // 各配列の先頭の境界、キャッシュラインに揃える
+    const uint64_t SCENE_ALIGNMENT = 64;
+    // 球を書き込む際に一度にバッファに詰める数
+    const size_t WRITE_CHUNK_SPHERES = 1u << 16;
+
+    uint64_t align_up(uint64_t offset) {
+        return (offset + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT;
+    }
+
+    // ファイルもしくは割り当て済みのメモリ(共有メモリ)に書き込む
+    class SceneWriter {
+    public:
+        explicit SceneWriter(const std::string &_path) : path(_path), buffer(nullptr), buffer_size(0) {
+            fp = std::fopen(path.c_str(), "wb");
+            if (!fp)
+                throw std::runtime_error("failed to open: " + path);
+        }
+
+        SceneWriter(const std::string &_name, uint8_t *_buffer, size_t _buffer_size) :
+                path(_name), fp(nullptr), buffer(_buffer), buffer_size(_buffer_size) {};
+
+        ~SceneWriter() {
+            if (fp)
+                std::fclose(fp);
+        }
+
+        void write_at(uint64_t offset, const void *data, size_t size) {
+            if (size == 0)
+                return;
+            if (buffer) {
+                if (offset > buffer_size || size > buffer_size - offset)
+                    throw std::runtime_error("failed to write scene: " + path);
+                std::memcpy(buffer + offset, data, size);
+                return;
+            }
+            if (std::fseek(fp, static_cast<long>(offset), SEEK_SET) != 0 || std::fwrite(data, 1, size, fp) != size)
+                throw std::runtime_error("failed to write scene: " + path);
+        }
+
+        void close() {
+            if (!fp)
+                return;
+            int ret = std::fclose(fp);
+            fp = nullptr;
+            if (ret != 0)
+                throw std::runtime_error("failed to write scene: " + path);
+        }
+
+    private:
+        std::string path;
+        std::FILE *fp;
+        uint8_t *buffer;
+        size_t buffer_size;
+    };
+
+    /*
+     * 球の(cx, cy, cz, r)を一定数ずつバッファに詰めて書き込む
+     * 数千万個の粒子でもファイル全体分のバッファは確保しない
+     */
+    template<typename F>
+    void write_spheres(SceneWriter &writer, uint64_t offset, size_t count, F &&sphere_at) {
+        std::vector<float> buf;
+        buf.reserve(4 * WRITE_CHUNK_SPHERES);
+        for (size_t begin = 0; begin < count; begin += WRITE_CHUNK_SPHERES) {
+            size_t end = std::min(count, begin + WRITE_CHUNK_SPHERES);
+            buf.clear();
+            for (size_t i = begin; i < end; i++) {
+                Vec3 c;
+                float r;
+                sphere_at(i, c, r);
+                buf.insert(buf.end(), c.elements.begin(), c.elements.end());
+                buf.push_back(r);
+            }
+            writer.write_at(offset + 4 * begin * sizeof(float), buf.data(), buf.size() * sizeof(float));
+        }
+    }
+
+    // [offset, offset + count * elem_size)がファイルに収まり、4バイト境界に揃っているかを確認する
+    void check_range(const MappedFile &file, uint64_t offset, uint64_t count, size_t elem_size, const std::string &path) {
+        if (offset % sizeof(float) != 0 || offset > file.size() || count > (file.size() - offset) / elem_size)
+            throw std::runtime_error("corrupt scene file: " + path);
+    }
+}
+
+namespace {
+    /*
+     * 書き出す要素と配列の位置
+     * SPHERESの要素はaggregate.spheresの材質毎の区間、各SphereCloudの順に並ぶ
+     */
+    struct ScenePlan {
+        std::vector<SceneFileEntry> entries;
+        // 材質の番号順に並べたSphereのインデックス
+        std::vector<size_t> sphere_order;
+        // 各区間のsphere_orderでの先頭
+        std::vector<size_t> sphere_entry_begin;
+        // 読み込み後のオブジェクトの並びに対応させたBVHのプリミティブ
+        std::vector<PrimRef> bvh_prims;
+        uint64_t size;
+    };
+
+    ScenePlan plan_scene(const Aggregate &aggregate) {
+        if (!aggregate.instances().empty())
+            throw std::runtime_error("scene files do not support instances");
+
+        ScenePlan plan;
+        std::vector<SceneFileEntry> &entries = plan.entries;
+        {
+            SceneFileEntry e{};
+            e.type = SCENE_ENTRY_MATERIALS;
+            e.count0 = aggregate.materials.size();
+            entries.push_back(e);
+        }
+
+        // Sphereは材質の番号順に並べ、同じ材質の連続した区間毎に1つの要素とする
+        const auto &spheres = aggregate.spheres();
+        std::vector<size_t> &sphere_order = plan.sphere_order;
+        sphere_order.resize(spheres.size());
+        for (size_t i = 0; i < sphere_order.size(); i++)
+            sphere_order[i] = i;
+        std::stable_sort(sphere_order.begin(), sphere_order.end(), [&](size_t a, size_t b) {
+            return spheres[a].material < spheres[b].material;
+        });
+        // 読み込み後は各区間がSphereCloudとなるため、各Sphereの(区間, 区間内の位置)を残す
+        std::vector<uint32_t> sphere_cloud(spheres.size()), sphere_rank(spheres.size());
+        for (size_t begin = 0; begin < sphere_order.size();) {
+            size_t end = begin;
+            while (end < sphere_order.size() &&
+                   spheres[sphere_order[end]].material == spheres[sphere_order[begin]].material) {
+                sphere_cloud[sphere_order[end]] = static_cast<uint32_t>(plan.sphere_entry_begin.size());
+                sphere_rank[sphere_order[end]] = static_cast<uint32_t>(end - begin);
+                end++;
+            }
+            SceneFileEntry e{};
+            e.type = SCENE_ENTRY_SPHERES;
+            e.material = spheres[sphere_order[begin]].material;
+            e.count0 = end - begin;
+            entries.push_back(e);
+            plan.sphere_entry_begin.push_back(begin);
+            begin = end;
+        }
+        auto sphere_entry_count = static_cast<uint32_t>(plan.sphere_entry_begin.size());
+
+        for (const auto &m: aggregate.meshes()) {
+            SceneFileEntry e{};
+            e.type = SCENE_ENTRY_MESH;
+            e.material = m.material;
+            e.count0 = m.vertex_count();
+            e.count1 = m.index_count();
+            entries.push_back(e);
+        }
+        for (const auto &c: aggregate.clouds()) {
+            SceneFileEntry e{};
+            e.type = SCENE_ENTRY_SPHERES;
+            e.material = c.material;
+            e.count0 = c.count();
+            entries.push_back(e);
+        }
+
+        // 構築済みのBVHはプリミティブを読み込み後の並び(SphereはSphereCloud)に置き換えて書き出す
+        const BVH &bvh = aggregate.acceleration();
+        if (!bvh.empty()) {
+            plan.bvh_prims.assign(bvh.prims(), bvh.prims() + bvh.prim_count());
+            for (PrimRef &ref: plan.bvh_prims) {
+                if (ref.type == PRIM_SPHERE)
+                    ref = PrimRef{PRIM_SPHERE_CLOUD, sphere_cloud[ref.object], sphere_rank[ref.object]};
+                else if (ref.type == PRIM_SPHERE_CLOUD)
+                    ref.object += sphere_entry_count;
+            }
+            SceneFileEntry e{};
+            e.type = SCENE_ENTRY_BVH;
+            e.count0 = bvh.node_count();
+            e.count1 = bvh.prim_count();
+            entries.push_back(e);
+        }
+
+        // 配列の位置を先に決める
+        uint64_t offset = sizeof(SceneFileHeader) + entries.size() * sizeof(SceneFileEntry);
+        for (auto &e: entries) {
+            offset = align_up(offset);
+            e.offset0 = offset;
+            if (e.type == SCENE_ENTRY_MATERIALS) {
+                offset += e.count0 * sizeof(SceneFileMaterial);
+                continue;
+            }
+            if (e.type == SCENE_ENTRY_BVH) {
+                offset += e.count0 * sizeof(BVHNode);
+                offset = align_up(offset);
+                e.offset1 = offset;
+                offset += e.count1 * sizeof(PrimRef);
+                continue;
+            }
+            offset += e.count0 * (e.type == SCENE_ENTRY_SPHERES ? 4 : 3) * sizeof(float);
+            if (e.type == SCENE_ENTRY_MESH) {
+                offset = align_up(offset);
+                e.offset1 = offset;
+                offset += e.count1 * sizeof(uint32_t);
+            }
+        }
+        plan.size = offset;
+        return plan;
+    }
+
+    /*
+     * 配列、要素の表、ヘッダの順に書き込む
+     * ヘッダを最後に書き込むため、書き込み途中の共有メモリを他のプロセスが開いてもシーンとしては読み込まれない
+     */
+    void write_scene(SceneWriter &writer, const Aggregate &aggregate, const ScenePlan &plan) {
+        const MaterialTable &materials = aggregate.materials;
+        const auto &spheres = aggregate.spheres();
+        size_t mesh_index = 0;
+        size_t cloud_index = 0;
+        size_t sphere_entry_index = 0;
+        for (const auto &e: plan.entries) {
+            if (e.type == SCENE_ENTRY_MATERIALS) {
+                std::vector<SceneFileMaterial> records(materials.size());
+                for (size_t i = 0; i < records.size(); i++) {
+                    SceneFileMaterial &r = records[i];
+                    r.type = materials.type[i];
+                    std::copy(materials.albedo[i].elements.begin(), materials.albedo[i].elements.end(), r.albedo);
+                    std::copy(materials.emission[i].elements.begin(), materials.emission[i].elements.end(),
+                              r.emission);
+                    r.roughness = materials.roughness[i];
+                    r.ior = materials.ior[i];
+                }
+                writer.write_at(e.offset0, records.data(), records.size() * sizeof(SceneFileMaterial));
+            } else if (e.type == SCENE_ENTRY_SPHERES && sphere_entry_index < plan.sphere_entry_begin.size()) {
+                size_t begin = plan.sphere_entry_begin[sphere_entry_index++];
+                write_spheres(writer, e.offset0, e.count0, [&](size_t i, Vec3 &c, float &r) {
+                    const Sphere &sphere = spheres[plan.sphere_order[begin + i]];
+                    c = sphere.center;
+                    r = sphere.radius;
+                });
+            } else if (e.type == SCENE_ENTRY_SPHERES) {
+                const SphereCloud &cloud = aggregate.clouds()[cloud_index++];
+                write_spheres(writer, e.offset0, cloud.count(), [&](size_t i, Vec3 &c, float &r) {
+                    c = cloud.center(i);
+                    r = cloud.radius(i);
+                });
+            } else if (e.type == SCENE_ENTRY_BVH) {
+                writer.write_at(e.offset0, aggregate.acceleration().nodes(), e.count0 * sizeof(BVHNode));
+                writer.write_at(e.offset1, plan.bvh_prims.data(), e.count1 * sizeof(PrimRef));
+            } else {
+                const Mesh &m = aggregate.meshes()[mesh_index++];
+                writer.write_at(e.offset0, m.positions(), 3 * m.vertex_count() * sizeof(float));
+                writer.write_at(e.offset1, m.indices(), m.index_count() * sizeof(uint32_t));
+            }
+        }
+
+        SceneFileHeader header{};
+        std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+        header.version = SCENE_FILE_VERSION;
+        header.entry_count = static_cast<uint32_t>(plan.entries.size());
+        writer.write_at(sizeof(header), plan.entries.data(), plan.entries.size() * sizeof(SceneFileEntry));
+        writer.write_at(0, &header, sizeof(header));
+    }
+
+    // 割り当てたシーンファイルからAggregateを構築する、pathはエラーメッセージに用いる
+    Aggregate load_scene(const std::shared_ptr<MappedFile> &file, const std::string &path) {
+        const auto *base = static_cast<const uint8_t *>(file->data());
+
+        SceneFileHeader header{};
+        if (file->size() < sizeof(header))
+            throw std::runtime_error("not a scene file: " + path);
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0)
+            throw std::runtime_error("not a scene file: " + path);
+        if (header.version != SCENE_FILE_VERSION)
+            throw std::runtime_error("unsupported scene file version: " + path);
+        check_range(*file, sizeof(header), header.entry_count, sizeof(SceneFileEntry), path);
+
+        Aggregate aggregate;
+        BVH bvh;
+        for (uint32_t i = 0; i < header.entry_count; i++) {
+            SceneFileEntry e{};
+            std::memcpy(&e, base + sizeof(header) + i * sizeof(SceneFileEntry), sizeof(e));
+            switch (e.type) {
+                case SCENE_ENTRY_SPHERES: {
+                    check_range(*file, e.offset0, e.count0, 4 * sizeof(float), path);
+                    const auto *s = reinterpret_cast<const float *>(base + e.offset0);
+                    SphereCloud cloud(s, 4, s + 3, 4, e.count0, file);
+                    cloud.material = static_cast<MaterialId>(e.material);
+                    aggregate.add(cloud);
+                    break;
+                }
+                case SCENE_ENTRY_MESH: {
+                    check_range(*file, e.offset0, e.count0, 3 * sizeof(float), path);
+                    check_range(*file, e.offset1, e.count1, sizeof(uint32_t), path);
+                    Mesh mesh(reinterpret_cast<const float *>(base + e.offset0), e.count0,
+                              reinterpret_cast<const uint32_t *>(base + e.offset1), e.count1, file);
+                    mesh.material = static_cast<MaterialId>(e.material);
+                    aggregate.add(mesh);
+                    break;
+                }
+                case SCENE_ENTRY_MATERIALS: {
+                    check_range(*file, e.offset0, e.count0, sizeof(SceneFileMaterial), path);
+                    if (e.count0 == 0 || e.count0 - 1 > static_cast<MaterialId>(-1))
+                        throw std::runtime_error("corrupt scene file: " + path);
+                    MaterialTable &materials = aggregate.materials;
+                    materials = MaterialTable();
+                    for (uint64_t j = 0; j < e.count0; j++) {
+                        SceneFileMaterial r{};
+                        std::memcpy(&r, base + e.offset0 + j * sizeof(SceneFileMaterial), sizeof(r));
+                        if (r.type >= MAT_TYPE_COUNT)
+                            throw std::runtime_error("corrupt scene file: " + path);
+                        materials.set(static_cast<MaterialId>(j), static_cast<MaterialType>(r.type),
+                                      Vec3(r.albedo[0], r.albedo[1], r.albedo[2]),
+                                      Vec3(r.emission[0], r.emission[1], r.emission[2]), r.roughness, r.ior);
+                    }
+                    break;
+                }
+                case SCENE_ENTRY_BVH: {
+                    // オブジェクトを全て追加した後に用いる
+                    check_range(*file, e.offset0, e.count0, sizeof(BVHNode), path);
+                    check_range(*file, e.offset1, e.count1, sizeof(PrimRef), path);
+                    bvh.attach(reinterpret_cast<const BVHNode *>(base + e.offset0), e.count0,
+                               reinterpret_cast<const PrimRef *>(base + e.offset1), e.count1, file);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        if (!bvh.empty())
+            aggregate.use_bvh(bvh);
+        return aggregate;
+    }
+}
+
+void save_scene_file(const std::string &path, const Aggregate &aggregate) {
+    ScenePlan plan = plan_scene(aggregate);
+    std::string tmp_path = path + ".tmp";
+    {
+        SceneWriter writer(tmp_path);
+        write_scene(writer, aggregate, plan);
+        writer.close();
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("failed to rename: " + tmp_path);
+}
+
+void save_shared_scene(const std::string &name, const Aggregate &aggregate) {
+    ScenePlan plan = plan_scene(aggregate);
+    MappedFile shm = MappedFile::create_shared(name, plan.size);
+    try {
+        SceneWriter writer(name, static_cast<uint8_t *>(shm.data()), shm.size());
+        write_scene(writer, aggregate, plan);
+    } catch (...) {
+        MappedFile::unlink_shared(name);
+        throw;
+    }
+}
+
+Aggregate load_scene_file(const std::string &path) {
+    return load_scene(std::make_shared<MappedFile>(MappedFile::open_readonly(path)), path);
+}
+
+Aggregate load_shared_scene(const std::string &name) {
+    return load_scene(std::make_shared<MappedFile>(MappedFile::open_shared_readonly(name)), name);
+}
+
+void remove_shared_scene(const std::string &name) {
+    MappedFile::unlink_shared(name);
+}
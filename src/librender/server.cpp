@@ -0,0 +1,382 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "futaba/render/camera.h"
+#include "futaba/render/renderer.h"
+#include "futaba/render/server.h"
+
+namespace {
+    // 統計情報のために保持する処理時間の数
+    const size_t LATENCY_WINDOW = 1024;
+
+    Message reply(uint32_t type, std::vector<uint8_t> payload = std::vector<uint8_t>()) {
+        Message msg;
+        msg.type = type;
+        msg.payload = std::move(payload);
+        return msg;
+    }
+}
+
+void RenderServer::run() {
+    Socket server = Socket::listen(address);
+
+    // SRV_SHUTDOWNを検知できるように一定時間毎にacceptの待機を抜ける
+    while (!stopping) {
+        pollfd fd{server.handle(), POLLIN, 0};
+        if (::poll(&fd, 1, 200) <= 0 || !(fd.revents & POLLIN))
+            continue;
+        try {
+            Socket client = server.accept();
+            {
+                std::lock_guard<std::mutex> lock(clients_mtx);
+                live_clients++;
+            }
+            try {
+                std::thread(&RenderServer::serve_client, this, std::move(client)).detach();
+            } catch (...) {
+                finish_client();
+                throw;
+            }
+        } catch (const std::exception &e) {
+            // 接続の受け付けやスレッドの生成に失敗しても常駐を続ける、記述子の枯渇が続く場合に備えて少し待つ
+            std::cerr << "server: " << e.what() << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(clients_mtx);
+    for (auto client: clients)
+        client->shutdown();
+    clients_cv.wait(lock, [this]() { return live_clients == 0; });
+}
+
+void RenderServer::serve_client(Socket socket) {
+    {
+        // 停止処理がshutdownを呼び出した後に登録された場合は、ここで終了させる
+        std::lock_guard<std::mutex> lock(clients_mtx);
+        if (stopping) {
+            live_clients--;
+            clients_cv.notify_all();
+            return;
+        }
+        clients.insert(&socket);
+    }
+    try {
+        while (!stopping) {
+            Message response = handle(socket.recv_message());
+            socket.send_message(response.type, response.payload);
+        }
+    } catch (const std::exception &) {
+        // クライアントの切断(切り離したスレッドから例外を送出すると常駐プロセスごと終了するため全て捕捉する)
+    }
+    {
+        std::lock_guard<std::mutex> lock(clients_mtx);
+        clients.erase(&socket);
+    }
+    finish_client();
+}
+
+void RenderServer::finish_client() {
+    // runは通知を受けるとthisを破棄し得るため、ロックを保持したまま通知してから何も参照せずに戻る
+    std::lock_guard<std::mutex> lock(clients_mtx);
+    live_clients--;
+    clients_cv.notify_all();
+}
+
+Message RenderServer::handle(const Message &request) {
+    try {
+        size_t offset = 0;
+        switch (request.type) {
+            case SRV_PUT_SCENE: {
+                std::string name = get_string(request.payload, offset);
+                std::shared_ptr<Scene> scene(new Scene());
+
+                auto material_count = get_value<uint64_t>(request.payload, offset);
+                if (material_count == 0 || material_count - 1 > static_cast<MaterialId>(-1))
+                    throw std::runtime_error("invalid scene payload");
+                for (uint64_t i = 0; i < material_count; i++) {
+                    auto type = get_value<uint32_t>(request.payload, offset);
+                    float v[8];
+                    for (float &e: v)
+                        e = get_value<float>(request.payload, offset);
+                    if (type >= MAT_TYPE_COUNT)
+                        throw std::runtime_error("invalid scene payload");
+                    scene->aggregate.materials.set(static_cast<MaterialId>(i), static_cast<MaterialType>(type),
+                                                   Vec3(v[0], v[1], v[2]), Vec3(v[3], v[4], v[5]), v[6], v[7]);
+                }
+
+                auto count = get_value<uint64_t>(request.payload, offset);
+                if (request.payload.size() < offset + count * (4 * sizeof(float) + sizeof(uint32_t)))
+                    throw std::runtime_error("invalid scene payload");
+                scene->aggregate.spheres().reserve(count);
+                for (uint64_t i = 0; i < count; i++) {
+                    float v[4];
+                    for (float &e: v)
+                        e = get_value<float>(request.payload, offset);
+                    auto material = get_value<uint32_t>(request.payload, offset);
+                    scene->aggregate.add(Sphere(Vec3(v[0], v[1], v[2]), v[3], static_cast<MaterialId>(material)));
+                }
+
+                auto mesh_count = get_value<uint64_t>(request.payload, offset);
+                for (uint64_t i = 0; i < mesh_count; i++) {
+                    auto vertex_count = get_value<uint64_t>(request.payload, offset);
+                    auto index_count = get_value<uint64_t>(request.payload, offset);
+                    auto material = get_value<uint32_t>(request.payload, offset);
+                    if (vertex_count > request.payload.size() || index_count > request.payload.size() ||
+                        request.payload.size() < offset + (3 * vertex_count + index_count) * sizeof(float))
+                        throw std::runtime_error("invalid scene payload");
+                    std::vector<float> positions(3 * vertex_count);
+                    std::vector<uint32_t> indices(index_count);
+                    std::memcpy(positions.data(), request.payload.data() + offset, positions.size() * sizeof(float));
+                    offset += positions.size() * sizeof(float);
+                    std::memcpy(indices.data(), request.payload.data() + offset, indices.size() * sizeof(uint32_t));
+                    offset += indices.size() * sizeof(uint32_t);
+                    Mesh mesh(std::move(positions), std::move(indices));
+                    mesh.material = static_cast<MaterialId>(material);
+                    scene->aggregate.add(mesh);
+                }
+
+                auto cloud_count = get_value<uint64_t>(request.payload, offset);
+                for (uint64_t i = 0; i < cloud_count; i++) {
+                    auto sphere_count = get_value<uint64_t>(request.payload, offset);
+                    auto material = get_value<uint32_t>(request.payload, offset);
+                    if (sphere_count > request.payload.size() ||
+                        request.payload.size() < offset + 4 * sphere_count * sizeof(float))
+                        throw std::runtime_error("invalid scene payload");
+                    const auto *data = reinterpret_cast<const float *>(request.payload.data() + offset);
+                    auto cloud = SphereCloud::from_arrays(data, data + 3 * sphere_count, sphere_count);
+                    cloud->material = static_cast<MaterialId>(material);
+                    scene->aggregate.add(cloud);
+                    offset += 4 * sphere_count * sizeof(float);
+                }
+                if (offset != request.payload.size())
+                    throw std::runtime_error("invalid scene payload");
+
+                scene->aggregate.build();
+
+                std::lock_guard<std::mutex> lock(scenes_mtx);
+                scenes[name] = scene;
+                return reply(SRV_OK);
+            }
+            case SRV_DROP_SCENE: {
+                std::string name = get_string(request.payload, offset);
+                std::lock_guard<std::mutex> lock(scenes_mtx);
+                if (scenes.erase(name) == 0)
+                    throw std::runtime_error("no such scene: " + name);
+                return reply(SRV_OK);
+            }
+            case SRV_LIST: {
+                std::vector<uint8_t> payload;
+                std::lock_guard<std::mutex> lock(scenes_mtx);
+                put_value(payload, static_cast<uint32_t>(scenes.size()));
+                for (const auto &kv: scenes)
+                    put_string(payload, kv.first);
+                return reply(SRV_OK, payload);
+            }
+            case SRV_RENDER:
+                return render(request.payload);
+            case SRV_STATS: {
+                std::vector<uint8_t> payload;
+                put_string(payload, stats());
+                return reply(SRV_OK, payload);
+            }
+            case SRV_SHUTDOWN:
+                stopping = true;
+                return reply(SRV_OK);
+            default:
+                throw std::runtime_error("unknown request");
+        }
+    } catch (const std::exception &e) {
+        std::vector<uint8_t> payload;
+        put_string(payload, e.what());
+        return reply(SRV_ERROR, payload);
+    }
+}
+
+Message RenderServer::render(const std::vector<uint8_t> &payload) {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t offset = 0;
+    auto req = get_value<RenderRequest>(payload, offset);
+    std::string name = get_string(payload, offset);
+    if (req.aov >= AOV_COUNT || req.width == 0 || req.height == 0 || req.spp == 0)
+        throw std::runtime_error("invalid render request");
+
+    std::shared_ptr<const Scene> scene;
+    {
+        std::lock_guard<std::mutex> lock(scenes_mtx);
+        auto it = scenes.find(name);
+        if (it == scenes.end())
+            throw std::runtime_error("no such scene: " + name);
+        scene = it->second;
+    }
+
+    PinholeCamera camera(Vec3(req.cam_sensor_pos[0], req.cam_sensor_pos[1], req.cam_sensor_pos[2]),
+                         Vec3(req.cam_sight_vec[0], req.cam_sight_vec[1], req.cam_sight_vec[2]),
+                         req.cam_sensor_width, req.cam_sensor_height, req.cam_sensor_dist);
+    auto aov = static_cast<AOVType>(req.aov);
+    Framebuffer fb(static_cast<int>(req.height), static_cast<int>(req.width), aov_bit(aov));
+    Renderer renderer(static_cast<int>(req.spp), 0, 0, req.seed, &pool);
+    for (uint32_t p = 0; p < std::max(1u, req.passes); p++)
+        renderer.render(scene->aggregate, camera, fb);
+
+    int channels = aov_channel_count(aov);
+    std::vector<uint8_t> frame;
+    frame.reserve(3 * sizeof(uint32_t) + static_cast<size_t>(fb.width) * fb.height * channels * sizeof(float));
+    put_value(frame, req.width);
+    put_value(frame, req.height);
+    put_value(frame, static_cast<uint32_t>(channels));
+    for (int y = 0; y < fb.height; y++) {
+        for (int x = 0; x < fb.width; x++) {
+            for (int c = 0; c < channels; c++)
+                put_value(frame, *fb.at(aov, c, x, y));
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(stats_mtx);
+        if (latencies.size() == LATENCY_WINDOW)
+            latencies[render_count % LATENCY_WINDOW] = ms;
+        else
+            latencies.push_back(ms);
+        render_count++;
+    }
+    return reply(SRV_FRAME, frame);
+}
+
+std::string RenderServer::stats() {
+    size_t scene_count;
+    {
+        std::lock_guard<std::mutex> lock(scenes_mtx);
+        scene_count = scenes.size();
+    }
+    std::vector<double> sorted;
+    uint64_t count;
+    {
+        std::lock_guard<std::mutex> lock(stats_mtx);
+        sorted = latencies;
+        count = render_count;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    };
+
+    std::ostringstream oss;
+    oss << "scenes=" << scene_count << " threads=" << pool.size() << " renders=" << count
+        << " p50_ms=" << percentile(0.50) << " p99_ms=" << percentile(0.99);
+    return oss.str();
+}
+
+Message RenderClient::call(uint32_t type, const std::vector<uint8_t> &payload) {
+    socket.send_message(type, payload);
+    Message response = socket.recv_message();
+    if (response.type == SRV_ERROR) {
+        size_t offset = 0;
+        throw std::runtime_error(get_string(response.payload, offset));
+    }
+    return response;
+}
+
+void RenderClient::put_scene(const std::string &name, const Aggregate &aggregate) {
+    if (!aggregate.instances().empty())
+        throw std::runtime_error("put_scene does not support instances");
+
+    std::vector<uint8_t> payload;
+    put_string(payload, name);
+    const MaterialTable &materials = aggregate.materials;
+    put_value(payload, static_cast<uint64_t>(materials.size()));
+    for (size_t i = 0; i < materials.size(); i++) {
+        put_value(payload, static_cast<uint32_t>(materials.type[i]));
+        for (float e: materials.albedo[i].elements)
+            put_value(payload, e);
+        for (float e: materials.emission[i].elements)
+            put_value(payload, e);
+        put_value(payload, materials.roughness[i]);
+        put_value(payload, materials.ior[i]);
+    }
+    put_value(payload, static_cast<uint64_t>(aggregate.spheres().size()));
+    for (const auto &s: aggregate.spheres()) {
+        put_value(payload, s.center.x());
+        put_value(payload, s.center.y());
+        put_value(payload, s.center.z());
+        put_value(payload, s.radius);
+        put_value(payload, static_cast<uint32_t>(s.material));
+    }
+    put_value(payload, static_cast<uint64_t>(aggregate.meshes().size()));
+    for (const auto &m: aggregate.meshes()) {
+        put_value(payload, static_cast<uint64_t>(m.vertex_count()));
+        put_value(payload, static_cast<uint64_t>(m.index_count()));
+        put_value(payload, static_cast<uint32_t>(m.material));
+        const auto *p = reinterpret_cast<const uint8_t *>(m.positions());
+        payload.insert(payload.end(), p, p + 3 * m.vertex_count() * sizeof(float));
+        p = reinterpret_cast<const uint8_t *>(m.indices());
+        payload.insert(payload.end(), p, p + m.index_count() * sizeof(uint32_t));
+    }
+    put_value(payload, static_cast<uint64_t>(aggregate.clouds().size()));
+    for (const auto &c: aggregate.clouds()) {
+        put_value(payload, static_cast<uint64_t>(c.count()));
+        put_value(payload, static_cast<uint32_t>(c.material));
+        for (size_t i = 0; i < c.count(); i++) {
+            Vec3 center = c.center(i);
+            for (float e: center.elements)
+                put_value(payload, e);
+        }
+        for (size_t i = 0; i < c.count(); i++)
+            put_value(payload, c.radius(i));
+    }
+    call(SRV_PUT_SCENE, payload);
+}
+
+void RenderClient::drop_scene(const std::string &name) {
+    std::vector<uint8_t> payload;
+    put_string(payload, name);
+    call(SRV_DROP_SCENE, payload);
+}
+
+std::vector<std::string> RenderClient::list_scenes() {
+    Message response = call(SRV_LIST, std::vector<uint8_t>());
+    size_t offset = 0;
+    auto count = get_value<uint32_t>(response.payload, offset);
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < count; i++)
+        names.push_back(get_string(response.payload, offset));
+    return names;
+}
+
+std::vector<float> RenderClient::render(const std::string &name, const RenderRequest &request, int &channels) {
+    std::vector<uint8_t> payload;
+    put_value(payload, request);
+    put_string(payload, name);
+    Message response = call(SRV_RENDER, payload);
+
+    size_t offset = 0;
+    auto width = get_value<uint32_t>(response.payload, offset);
+    auto height = get_value<uint32_t>(response.payload, offset);
+    channels = static_cast<int>(get_value<uint32_t>(response.payload, offset));
+    std::vector<float> frame(static_cast<size_t>(width) * height * channels);
+    if (response.payload.size() != offset + frame.size() * sizeof(float))
+        throw std::runtime_error("invalid frame");
+    std::memcpy(frame.data(), response.payload.data() + offset, frame.size() * sizeof(float));
+    return frame;
+}
+
+std::string RenderClient::stats() {
+    Message response = call(SRV_STATS, std::vector<uint8_t>());
+    size_t offset = 0;
+    return get_string(response.payload, offset);
+}
+
+void RenderClient::shutdown_server() {
+    call(SRV_SHUTDOWN, std::vector<uint8_t>());
+}
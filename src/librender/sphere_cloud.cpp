@@ -0,0 +1,134 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#include "futaba/core/thread_pool.h"
+#include "futaba/render/sphere_cloud.h"
+
+namespace {
+    const char PARTICLE_MAGIC[8] = {'F', 'T', 'B', 'P', 'T', 'C', 'L', '1'};
+    const size_t PARTICLE_HEADER_SIZE = sizeof(PARTICLE_MAGIC) + sizeof(uint64_t);
+    // 1つのタスクで処理する球の数
+    const size_t CHUNK_SPHERES = 1u << 18;
+
+    /*
+     * 数千万個の粒子では0による初期化だけでも無視できない時間がかかるため、vectorではなく初期化しない配列を用いる
+     * 各ページは並列に書き込むタスクが最初に触れる
+     */
+    struct SphereStorage {
+        std::unique_ptr<float[]> centers;
+        std::unique_ptr<float[]> radii;
+
+        SphereStorage(size_t center_floats, size_t radius_floats) :
+                centers(new float[center_floats]), radii(new float[radius_floats]) {};
+    };
+
+    int chunk_count(size_t count) {
+        return static_cast<int>((count + CHUNK_SPHERES - 1) / CHUNK_SPHERES);
+    }
+
+    // sizeバイトを全て読み込むまでpreadを繰り返す
+    bool pread_all(int fd, void *data, size_t size, uint64_t offset) {
+        auto p = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t n = ::pread(fd, p, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+}
+
+std::shared_ptr<SphereCloud> SphereCloud::from_arrays(const float *_centers, const float *_radii, size_t _count,
+                                                      float uniform_radius, int threads) {
+    auto storage = std::make_shared<SphereStorage>(3 * _count, _radii ? _count : 1);
+    if (!_radii)
+        storage->radii[0] = uniform_radius;
+
+    ThreadPool pool(threads);
+    pool.parallel_for(chunk_count(_count), [&](int chunk) {
+        size_t begin = static_cast<size_t>(chunk) * CHUNK_SPHERES;
+        size_t end = std::min(_count, begin + CHUNK_SPHERES);
+        std::memcpy(&storage->centers[3 * begin], _centers + 3 * begin, 3 * (end - begin) * sizeof(float));
+        if (_radii)
+            std::memcpy(&storage->radii[begin], _radii + begin, (end - begin) * sizeof(float));
+    });
+
+    return std::make_shared<SphereCloud>(storage->centers.get(), 3, storage->radii.get(), _radii ? 1 : 0, _count,
+                                         storage);
+}
+
+std::shared_ptr<SphereCloud> SphereCloud::load(const std::string &path, int threads) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open: " + path);
+
+    char magic[sizeof(PARTICLE_MAGIC)];
+    uint64_t count = 0;
+    off_t file_size = ::lseek(fd, 0, SEEK_END);
+    if (!pread_all(fd, magic, sizeof(magic), 0) || std::memcmp(magic, PARTICLE_MAGIC, sizeof(magic)) != 0 ||
+        !pread_all(fd, &count, sizeof(count), sizeof(magic)) ||
+        count > static_cast<uint64_t>(file_size) / (4 * sizeof(float)) ||
+        static_cast<uint64_t>(file_size) != PARTICLE_HEADER_SIZE + count * 4 * sizeof(float)) {
+        ::close(fd);
+        throw std::runtime_error("not a particle file: " + path);
+    }
+
+    std::shared_ptr<SphereStorage> storage;
+    try {
+        storage = std::make_shared<SphereStorage>(3 * count, count);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    // 各タスクはファイルの異なる区間を格納先に直接読み込む
+    std::atomic<bool> failed{false};
+    uint64_t radii_offset = PARTICLE_HEADER_SIZE + 3 * count * sizeof(float);
+    ThreadPool pool(threads);
+    pool.parallel_for(chunk_count(count), [&](int chunk) {
+        size_t begin = static_cast<size_t>(chunk) * CHUNK_SPHERES;
+        size_t n = std::min(static_cast<size_t>(count), begin + CHUNK_SPHERES) - begin;
+        if (!pread_all(fd, &storage->centers[3 * begin], 3 * n * sizeof(float),
+                       PARTICLE_HEADER_SIZE + 3 * begin * sizeof(float)) ||
+            !pread_all(fd, &storage->radii[begin], n * sizeof(float), radii_offset + begin * sizeof(float)))
+            failed = true;
+    });
+    ::close(fd);
+    if (failed)
+        throw std::runtime_error("failed to read: " + path);
+
+    return std::make_shared<SphereCloud>(storage->centers.get(), 3, storage->radii.get(), 1,
+                                         static_cast<size_t>(count), storage);
+}
+
+void SphereCloud::save(const std::string &path) const {
+    std::FILE *fp = std::fopen(path.c_str(), "wb");
+    if (!fp)
+        throw std::runtime_error("failed to open: " + path);
+
+    auto count = static_cast<uint64_t>(n_spheres);
+    bool ok = std::fwrite(PARTICLE_MAGIC, sizeof(PARTICLE_MAGIC), 1, fp) == 1 &&
+              std::fwrite(&count, sizeof(count), 1, fp) == 1;
+    for (size_t i = 0; ok && i < n_spheres; i++) {
+        const float *c = centers + i * center_stride;
+        ok = std::fwrite(c, sizeof(float), 3, fp) == 3;
+    }
+    for (size_t i = 0; ok && i < n_spheres; i++)
+        ok = std::fwrite(radii + i * radius_stride, sizeof(float), 1, fp) == 1;
+    if (std::fclose(fp) != 0 || !ok)
+        throw std::runtime_error("failed to write: " + path);
+}
@@ -0,0 +1,342 @@
+//
+// Created by okn-yu on 2026/10/19.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <unistd.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stb_image.h"
+#include "futaba/render/texture.h"
+
+namespace {
+    bool pread_all(int fd, void *data, size_t size, uint64_t offset) {
+        auto p = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t n = ::pread(fd, p, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool pwrite_all(int fd, const void *data, size_t size, uint64_t offset) {
+        auto p = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd, p, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    int wrap(int x, int n) {
+        int r = x % n;
+        return r < 0 ? r + n : r;
+    }
+
+    // (テクスチャ, レベル, タイル)を1つのキーにまとめる
+    uint64_t tile_key(TextureId id, int level, int tile_x, int tile_y) {
+        return static_cast<uint64_t>(id) << 40u | static_cast<uint64_t>(level) << 34u |
+               static_cast<uint64_t>(tile_y) << 17u | static_cast<uint64_t>(tile_x);
+    }
+
+    struct Tap {
+        int index;
+        float weight;
+    };
+
+    /*
+     * 長さnの画素列を長さdst_nに縮小する際の各画素の重み
+     * 縮小後の各画素は元の画素列の幅n / dst_nの区間に対応し、区間と重なる面積で重み付けする
+     * 奇数の長さでも端の画素を失ったり重複したりせず、全体の平均が保たれる
+     */
+    std::vector<std::vector<Tap>> box_taps(int n, int dst_n) {
+        std::vector<std::vector<Tap>> taps(dst_n);
+        float scale = static_cast<float>(n) / static_cast<float>(dst_n);
+        for (int i = 0; i < dst_n; i++) {
+            float begin = static_cast<float>(i) * scale;
+            float end = begin + scale;
+            for (auto j = static_cast<int>(begin); j < n && static_cast<float>(j) < end; j++) {
+                float overlap = std::min(end, static_cast<float>(j + 1)) - std::max(begin, static_cast<float>(j));
+                if (overlap > 0.0f)
+                    taps[i].push_back({j, overlap / scale});
+            }
+        }
+        return taps;
+    }
+
+    // 区間の平均による縮小で次のMIPレベルの画像を生成する
+    std::vector<float> downsample(const float *src, int w, int h, int dst_w, int dst_h) {
+        auto taps_x = box_taps(w, dst_w);
+        auto taps_y = box_taps(h, dst_h);
+
+        // 横方向に縮小してから縦方向に縮小する
+        std::vector<float> rows(3 * static_cast<size_t>(dst_w) * h, 0.0f);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < dst_w; x++) {
+                float *d = &rows[3 * (static_cast<size_t>(y) * dst_w + x)];
+                for (const Tap &tap: taps_x[x]) {
+                    const float *p = src + 3 * (static_cast<size_t>(y) * w + tap.index);
+                    for (int c = 0; c < 3; c++)
+                        d[c] += tap.weight * p[c];
+                }
+            }
+        }
+
+        std::vector<float> dst(3 * static_cast<size_t>(dst_w) * dst_h, 0.0f);
+        for (int y = 0; y < dst_h; y++) {
+            for (const Tap &tap: taps_y[y]) {
+                const float *p = &rows[3 * static_cast<size_t>(tap.index) * dst_w];
+                float *d = &dst[3 * static_cast<size_t>(y) * dst_w];
+                for (int i = 0; i < 3 * dst_w; i++)
+                    d[i] += tap.weight * p[i];
+            }
+        }
+        return dst;
+    }
+}
+
+TextureCache::TextureCache(size_t _memory_limit, std::string _tile_dir) :
+        memory_limit(_memory_limit), tile_dir(std::move(_tile_dir)) {}
+
+TextureCache::~TextureCache() {
+    for (auto &tex: textures) {
+        if (tex->fd >= 0)
+            ::close(tex->fd);
+    }
+}
+
+TextureId TextureCache::add(const std::string &path) {
+    int w = 0, h = 0, comp = 0;
+    if (!stbi_info(path.c_str(), &w, &h, &comp))
+        throw std::runtime_error("failed to read texture: " + path);
+    if (w <= 0 || h <= 0 || w > (TEXTURE_TILE_SIZE << 17) || h > (TEXTURE_TILE_SIZE << 17))
+        throw std::runtime_error("unsupported texture size: " + path);
+
+    std::unique_ptr<Texture> tex(new Texture());
+    tex->path = path;
+    tex->width = w;
+    tex->height = h;
+
+    // 各レベルの位置はヘッダのみから決まるため、変換前に求めておく
+    uint64_t offset = 0;
+    while (true) {
+        Level level{w, h, (w + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE,
+                    (h + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE, offset};
+        tex->levels.push_back(level);
+        offset += static_cast<uint64_t>(level.tiles_x) * level.tiles_y * sizeof(Tile);
+        if (w == 1 && h == 1)
+            break;
+        // 奇数の場合は切り上げ、端の画素が失われないようにする
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+
+    convert(*tex);
+    textures.push_back(std::move(tex));
+    return static_cast<TextureId>(textures.size() - 1);
+}
+
+TextureCache::Texture &TextureCache::texture(TextureId id) const {
+    if (id < 0 || static_cast<size_t>(id) >= textures.size())
+        throw std::runtime_error("texture id out of range");
+    return *textures[id];
+}
+
+int TextureCache::width(TextureId id) const {
+    return texture(id).width;
+}
+
+int TextureCache::height(TextureId id) const {
+    return texture(id).height;
+}
+
+int TextureCache::levels(TextureId id) const {
+    return static_cast<int>(texture(id).levels.size());
+}
+
+void TextureCache::convert(Texture &tex) const {
+    int w = 0, h = 0, comp = 0;
+    // LDRの画像はstbによりsRGBからリニアに変換される
+    std::unique_ptr<float, void (*)(void *)> pixels(stbi_loadf(tex.path.c_str(), &w, &h, &comp, 3), stbi_image_free);
+    if (!pixels)
+        throw std::runtime_error("failed to load texture: " + tex.path + " (" + stbi_failure_reason() + ")");
+    if (w != tex.width || h != tex.height)
+        throw std::runtime_error("texture changed after it was added: " + tex.path);
+
+    std::string dir = tile_dir;
+    if (dir.empty()) {
+        const char *env = std::getenv("TMPDIR");
+        dir = env && *env ? env : "/tmp";
+    }
+    std::string name = dir + "/futaba-texture-XXXXXX";
+    std::vector<char> name_buf(name.begin(), name.end());
+    name_buf.push_back('\0');
+    int fd = ::mkstemp(name_buf.data());
+    if (fd < 0)
+        throw std::runtime_error("failed to create tile file in " + dir);
+    // 名前は不要なため直ちに削除し、ファイルは閉じた時点で解放されるようにする
+    ::unlink(name_buf.data());
+
+    std::vector<float> current;
+    const float *src = pixels.get();
+    std::unique_ptr<Tile> buf(new Tile());
+    for (size_t l = 0; l < tex.levels.size(); l++) {
+        const Level &level = tex.levels[l];
+        if (l > 0) {
+            const Level &prev = tex.levels[l - 1];
+            current = downsample(src, prev.width, prev.height, level.width, level.height);
+            src = current.data();
+            if (l == 1)
+                pixels.reset();
+        }
+
+        // 端のタイルの範囲外の画素は端の画素で埋める
+        for (int ty = 0; ty < level.tiles_y; ty++) {
+            for (int tx = 0; tx < level.tiles_x; tx++) {
+                for (int y = 0; y < TEXTURE_TILE_SIZE; y++) {
+                    int sy = std::min(ty * TEXTURE_TILE_SIZE + y, level.height - 1);
+                    for (int x = 0; x < TEXTURE_TILE_SIZE; x++) {
+                        int sx = std::min(tx * TEXTURE_TILE_SIZE + x, level.width - 1);
+                        const float *p = src + 3 * (static_cast<size_t>(sy) * level.width + sx);
+                        std::copy(p, p + 3, buf->rgb + 3 * (y * TEXTURE_TILE_SIZE + x));
+                    }
+                }
+                uint64_t offset = level.offset + (static_cast<uint64_t>(ty) * level.tiles_x + tx) * sizeof(Tile);
+                if (!pwrite_all(fd, buf.get(), sizeof(Tile), offset)) {
+                    ::close(fd);
+                    throw std::runtime_error("failed to write tile file for " + tex.path);
+                }
+            }
+        }
+    }
+    tex.fd = fd;
+}
+
+std::shared_ptr<const TextureCache::Tile> TextureCache::tile(TextureId id, int level, int tile_x, int tile_y) {
+    uint64_t key = tile_key(id, level, tile_x, tile_y);
+    Shard &shard = shards[(key * 0x9E3779B97F4A7C15ull) >> 60u];
+    {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            hits++;
+            return it->second->second;
+        }
+    }
+    misses++;
+
+    // 読み込みはロックの外で行い、同じタイルを同時に読み込んだ場合は先に登録された方を採用する
+    const Texture &tex = texture(id);
+    const Level &lv = tex.levels[level];
+    std::shared_ptr<Tile> loaded = std::make_shared<Tile>();
+    uint64_t offset = lv.offset + (static_cast<uint64_t>(tile_y) * lv.tiles_x + tile_x) * sizeof(Tile);
+    if (!pread_all(tex.fd, loaded.get(), sizeof(Tile), offset))
+        throw std::runtime_error("failed to read tile file for " + tex.path);
+
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->second;
+    }
+    shard.lru.emplace_front(key, loaded);
+    shard.index[key] = shard.lru.begin();
+    shard.memory += sizeof(Tile);
+
+    // 直前に読み込んだタイルは上限を超えていても残す
+    size_t shard_limit = memory_limit / SHARD_COUNT;
+    while (shard.memory > shard_limit && shard.lru.size() > 1) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+        shard.memory -= sizeof(Tile);
+    }
+    return loaded;
+}
+
+Vec3 TextureCache::texel(TextureId id, int level, int x, int y) {
+    const Level &lv = texture(id).levels[level];
+    x = wrap(x, lv.width);
+    y = wrap(y, lv.height);
+    auto t = tile(id, level, x / TEXTURE_TILE_SIZE, y / TEXTURE_TILE_SIZE);
+    const float *p = t->rgb + 3 * ((y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + x % TEXTURE_TILE_SIZE);
+    return {p[0], p[1], p[2]};
+}
+
+Vec3 TextureCache::bilinear(TextureId id, int level, float u, float v) {
+    const Level &lv = texture(id).levels[level];
+    // 整数部を除いてから画素の座標に変換し、大きな座標でも桁があふれないようにする
+    u -= std::floor(u);
+    v -= std::floor(v);
+    // 画素の中心を整数座標とする
+    float fx = u * static_cast<float>(lv.width) - 0.5f;
+    float fy = (1.0f - v) * static_cast<float>(lv.height) - 0.5f;
+    float x_floor = std::floor(fx);
+    float y_floor = std::floor(fy);
+    float ax = fx - x_floor;
+    float ay = fy - y_floor;
+
+    int xs[2] = {wrap(static_cast<int>(x_floor), lv.width), wrap(static_cast<int>(x_floor) + 1, lv.width)};
+    int ys[2] = {wrap(static_cast<int>(y_floor), lv.height), wrap(static_cast<int>(y_floor) + 1, lv.height)};
+
+    // 4画素は同じタイルに含まれることが多いため、直前に取得したタイルを使い回す
+    std::shared_ptr<const Tile> t;
+    int t_x = -1, t_y = -1;
+    Vec3 c[2][2];
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            int tile_x = xs[i] / TEXTURE_TILE_SIZE;
+            int tile_y = ys[j] / TEXTURE_TILE_SIZE;
+            if (tile_x != t_x || tile_y != t_y) {
+                t = tile(id, level, tile_x, tile_y);
+                t_x = tile_x;
+                t_y = tile_y;
+            }
+            const float *p = t->rgb + 3 * ((ys[j] % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + xs[i] % TEXTURE_TILE_SIZE);
+            c[j][i] = Vec3(p[0], p[1], p[2]);
+        }
+    }
+    return (1.0f - ay) * ((1.0f - ax) * c[0][0] + ax * c[0][1]) + ay * ((1.0f - ax) * c[1][0] + ax * c[1][1]);
+}
+
+Vec3 TextureCache::lookup(TextureId id, float u, float v, float footprint) {
+    const Texture &tex = texture(id);
+    int max_level = static_cast<int>(tex.levels.size()) - 1;
+    float texels = footprint * static_cast<float>(std::max(tex.width, tex.height));
+    float lod = texels > 1.0f ? std::log2(texels) : 0.0f;
+    if (lod >= static_cast<float>(max_level))
+        return bilinear(id, max_level, u, v);
+
+    auto l0 = static_cast<int>(lod);
+    float f = lod - static_cast<float>(l0);
+    Vec3 c0 = bilinear(id, l0, u, v);
+    if (f == 0.0f)
+        return c0;
+    return (1.0f - f) * c0 + f * bilinear(id, l0 + 1, u, v);
+}
+
+size_t TextureCache::memory_usage() const {
+    size_t total = 0;
+    for (const Shard &shard: shards) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        total += shard.memory;
+    }
+    return total;
+}